@@ -361,6 +361,47 @@ static double compensate_humidity(const struct bme280_uncomp_data *uncomp_data,
 static double compensate_temperature(const struct bme280_uncomp_data *uncomp_data,
 									 struct bme280_calib_data *calib_data);
 
+#elif defined(BME280_FLOAT_ENABLE)
+
+/*!
+ * @brief This internal API is used to compensate the raw pressure data and
+ * return the compensated pressure data in single precision float data type.
+ *
+ * @param[in] uncomp_data : Contains the uncompensated pressure data.
+ * @param[in] calib_data  : Pointer to the calibration data structure.
+ *
+ * @return Compensated pressure data in float.
+ *
+ */
+static float compensate_pressure(const struct bme280_uncomp_data *uncomp_data,
+								 const struct bme280_calib_data *calib_data);
+
+/*!
+ * @brief This internal API is used to compensate the raw humidity data and
+ * return the compensated humidity data in single precision float data type.
+ *
+ * @param[in] uncomp_data : Contains the uncompensated humidity data.
+ * @param[in] calib_data  : Pointer to the calibration data structure.
+ *
+ * @return Compensated humidity data in float.
+ *
+ */
+static float compensate_humidity(const struct bme280_uncomp_data *uncomp_data,
+								 const struct bme280_calib_data *calib_data);
+
+/*!
+ * @brief This internal API is used to compensate the raw temperature data and
+ * return the compensated temperature data in single precision float data type.
+ *
+ * @param[in] uncomp_data : Contains the uncompensated temperature data.
+ * @param[in] calib_data  : Pointer to calibration data structure.
+ *
+ * @return Compensated temperature data in float.
+ *
+ */
+static float compensate_temperature(const struct bme280_uncomp_data *uncomp_data,
+									struct bme280_calib_data *calib_data);
+
 #else
 
 /*!
@@ -1238,6 +1279,131 @@ static double compensate_humidity(const struct bme280_uncomp_data *uncomp_data,
 	return humidity;
 }
 
+#elif defined(BME280_FLOAT_ENABLE)
+
+/*
+ * The float kernels follow the double precision reference above, but keep every
+ * intermediate within the 24-bit mantissa of the single precision FPU.
+ * All divisions by powers of two are replaced with exact multiplications.
+ */
+
+/*!
+ * @brief This internal API is used to compensate the raw temperature data and
+ * return the compensated temperature data in single precision float data type.
+ */
+static float compensate_temperature(const struct bme280_uncomp_data *uncomp_data, struct bme280_calib_data *calib_data)
+{
+	float var1;
+	float var2;
+	float temperature;
+	float temperature_min = -40.0f;
+	float temperature_max = 85.0f;
+
+	var1 = ((float)uncomp_data->temperature) * (1.0f / 16384.0f) - ((float)calib_data->dig_t1) * (1.0f / 1024.0f);
+	var1 = var1 * ((float)calib_data->dig_t2);
+	var2 = ((float)uncomp_data->temperature) * (1.0f / 131072.0f) - ((float)calib_data->dig_t1) * (1.0f / 8192.0f);
+	var2 = (var2 * var2) * ((float)calib_data->dig_t3);
+	calib_data->t_fine = (int32_t)(var1 + var2);
+	temperature = (var1 + var2) * (1.0f / 5120.0f);
+
+	if (temperature < temperature_min)
+	{
+		temperature = temperature_min;
+	}
+	else if (temperature > temperature_max)
+	{
+		temperature = temperature_max;
+	}
+
+	return temperature;
+}
+
+/*!
+ * @brief This internal API is used to compensate the raw pressure data and
+ * return the compensated pressure data in single precision float data type.
+ */
+static float compensate_pressure(const struct bme280_uncomp_data *uncomp_data,
+								 const struct bme280_calib_data *calib_data)
+{
+	float var1;
+	float var2;
+	float var3;
+	float pressure;
+	float pressure_min = 30000.0f;
+	float pressure_max = 110000.0f;
+
+	var1 = ((float)calib_data->t_fine * 0.5f) - 64000.0f;
+	var2 = var1 * var1 * ((float)calib_data->dig_p6) * (1.0f / 32768.0f);
+	var2 = var2 + var1 * ((float)calib_data->dig_p5) * 2.0f;
+	var2 = (var2 * 0.25f) + (((float)calib_data->dig_p4) * 65536.0f);
+	var3 = ((float)calib_data->dig_p3) * var1 * var1 * (1.0f / 524288.0f);
+	var1 = (var3 + ((float)calib_data->dig_p2) * var1) * (1.0f / 524288.0f);
+	var1 = (1.0f + var1 * (1.0f / 32768.0f)) * ((float)calib_data->dig_p1);
+
+	/* Avoid exception caused by division by zero */
+	if (var1 > (0.0f))
+	{
+		pressure = 1048576.0f - (float)uncomp_data->pressure;
+		pressure = (pressure - (var2 * (1.0f / 4096.0f))) * 6250.0f / var1;
+		var1 = ((float)calib_data->dig_p9) * pressure * pressure * (1.0f / 2147483648.0f);
+		var2 = pressure * ((float)calib_data->dig_p8) * (1.0f / 32768.0f);
+		pressure = pressure + (var1 + var2 + ((float)calib_data->dig_p7)) * (1.0f / 16.0f);
+
+		if (pressure < pressure_min)
+		{
+			pressure = pressure_min;
+		}
+		else if (pressure > pressure_max)
+		{
+			pressure = pressure_max;
+		}
+	}
+	else /* Invalid case */
+	{
+		pressure = pressure_min;
+	}
+
+	return pressure;
+}
+
+/*!
+ * @brief This internal API is used to compensate the raw humidity data and
+ * return the compensated humidity data in single precision float data type.
+ */
+static float compensate_humidity(const struct bme280_uncomp_data *uncomp_data,
+								 const struct bme280_calib_data *calib_data)
+{
+	float humidity;
+	float humidity_min = 0.0f;
+	float humidity_max = 100.0f;
+	float var1;
+	float var2;
+	float var3;
+	float var4;
+	float var5;
+	float var6;
+
+	var1 = ((float)calib_data->t_fine) - 76800.0f;
+	var2 = (((float)calib_data->dig_h4) * 64.0f + (((float)calib_data->dig_h5) * (1.0f / 16384.0f)) * var1);
+	var3 = (float)uncomp_data->humidity - var2;
+	var4 = ((float)calib_data->dig_h2) * (1.0f / 65536.0f);
+	var5 = (1.0f + (((float)calib_data->dig_h3) * (1.0f / 67108864.0f)) * var1);
+	var6 = 1.0f + (((float)calib_data->dig_h6) * (1.0f / 67108864.0f)) * var1 * var5;
+	var6 = var3 * var4 * (var5 * var6);
+	humidity = var6 * (1.0f - ((float)calib_data->dig_h1) * var6 * (1.0f / 524288.0f));
+
+	if (humidity > humidity_max)
+	{
+		humidity = humidity_max;
+	}
+	else if (humidity < humidity_min)
+	{
+		humidity = humidity_min;
+	}
+
+	return humidity;
+}
+
 #else
 
 /*!
@@ -40,8 +40,12 @@
 #define _BME280_DEFS_H
 
 // #define BME280_32BIT_ENABLE
-#define BME280_64BIT_ENABLE
+// #define BME280_64BIT_ENABLE
 // #define BME280_DOUBLE_ENABLE
+// Single precision unless the build selects another variant (tools/test/bme280_compensation.cpp builds all four)
+#if !defined(BME280_32BIT_ENABLE) && !defined(BME280_64BIT_ENABLE) && !defined(BME280_DOUBLE_ENABLE)
+#define BME280_FLOAT_ENABLE
+#endif
 
 #define BME280_INTF_RET_TYPE int
 
@@ -94,11 +98,13 @@
 /******************************************************************************/
 #ifndef BME280_64BIT_ENABLE	 /*< Check if 64-bit integer (using BME280_64BIT_ENABLE) is enabled */
 #ifndef BME280_32BIT_ENABLE	 /*< Check if 32-bit integer (using BME280_32BIT_ENABLE) is enabled */
+#ifndef BME280_FLOAT_ENABLE	 /*< Check if single precision float (using BME280_FLOAT_ENABLE) is enabled */
 #ifndef BME280_DOUBLE_ENABLE /*< If any of the integer data types not enabled then enable BME280_DOUBLE_ENABLE */
 #define BME280_DOUBLE_ENABLE
 #endif
 #endif
 #endif
+#endif
 
 /******************************************************************************/
 /*! @name        General Macro Definitions                */
@@ -408,6 +414,18 @@ struct bme280_data
 	/*! Compensated humidity */
 	double humidity;
 };
+#elif defined(BME280_FLOAT_ENABLE)
+struct bme280_data
+{
+	/*! Compensated pressure */
+	float pressure;
+
+	/*! Compensated temperature */
+	float temperature;
+
+	/*! Compensated humidity */
+	float humidity;
+};
 #else
 struct bme280_data
 {
@@ -0,0 +1,204 @@
+#ifndef Animation_H
+#define Animation_H
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <bit>
+
+// Compressed clips of VFD grid frames (std::array<uint16_t, 16>, the layout of VFD::matrix).
+// A clip is an 8 byte header followed by records, every record produces 1 to 64 frames:
+//
+//   header   'V' 'A' version grids frames:u16 period_ms:u16   (little endian)
+//   record   ctl [payload]
+//            ctl bits 7..6 type, bits 5..0 n
+//     HOLD   -                           previous frame n + 1 more times
+//     WORDS  mask:u16, xor:u16 per bit   grid g ^= xor for every set bit g, shown n + 1 times
+//     BYTES  mask:u32, xor:u8 per bit    byte b of the frame ^= xor (b = 2g + high), shown n + 1 times
+//     KEY    16 x u16                    absolute frame, shown n + 1 times
+//
+// The decoder starts from an all-dark frame, so the first record is simply a delta from black and a clip
+// can be played straight out of flash (rodata or a mapped partition), one frame per next() call.
+// Clips are produced on host by tools/anim_encode.cpp, which picks the smallest record for every frame.
+namespace AnimationFormat
+{
+	static constexpr uint8_t MAGIC0 = 'V';
+	static constexpr uint8_t MAGIC1 = 'A';
+	static constexpr uint8_t VERSION = 1;
+	static constexpr size_t GRIDS = 16;
+	static constexpr size_t HEADER_SIZE = 8;
+
+	static constexpr uint8_t HOLD = 0x00;
+	static constexpr uint8_t WORDS = 0x40;
+	static constexpr uint8_t BYTES = 0x80;
+	static constexpr uint8_t KEY = 0xC0;
+	static constexpr uint8_t TYPE_MASK = 0xC0;
+	static constexpr uint8_t COUNT_MASK = 0x3F; // repeats, so a record covers up to 64 frames
+
+	using Frame = std::array<uint16_t, GRIDS>;
+};
+
+// Streaming player of a clip, keeps only the current frame (32 bytes) and the read position.
+// The clip memory must stay valid (and mapped) while the decoder is used.
+class AnimationDecoder
+{
+public:
+	using Frame = AnimationFormat::Frame;
+
+private:
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+
+	size_t pos = 0;		  // next record
+	uint8_t repeats = 0;  // frames of the current record still to show
+	uint16_t shown = 0;	  // frames produced since rewind()
+	bool broken = false;  // truncated or unknown record
+
+	Frame current = {};
+
+public:
+	AnimationDecoder() = default;
+	AnimationDecoder(const uint8_t *clip, size_t len) : data(clip), size(len)
+	{
+		rewind();
+	}
+	~AnimationDecoder() = default;
+
+	bool valid() const
+	{
+		using namespace AnimationFormat;
+		return data && size >= HEADER_SIZE && data[0] == MAGIC0 && data[1] == MAGIC1 && data[2] == VERSION && data[3] == GRIDS;
+	}
+
+	// Number of frames in the clip, holds included
+	uint16_t frames() const
+	{
+		return valid() ? read16(data + 4) : 0;
+	}
+
+	// Intended display time of one frame, ms
+	uint16_t period_ms() const
+	{
+		return valid() ? read16(data + 6) : 0;
+	}
+
+	// Frames produced since the last rewind()
+	uint16_t position() const
+	{
+		return shown;
+	}
+
+	bool done() const
+	{
+		return broken || shown >= frames();
+	}
+
+	void rewind()
+	{
+		pos = AnimationFormat::HEADER_SIZE;
+		repeats = 0;
+		shown = 0;
+		broken = !valid();
+		current.fill(0);
+	}
+
+	const Frame &frame() const
+	{
+		return current;
+	}
+
+	// Decodes the next frame into out (e.g. vfd.matrix), false at the end of the clip or on corrupt data.
+	// out is only written on success and may be changed freely between calls.
+	bool next(Frame &out)
+	{
+		if (done())
+			return false;
+
+		if (!repeats && !step())
+		{
+			broken = true;
+			return false;
+		}
+
+		--repeats;
+		++shown;
+		out = current;
+		return true;
+	}
+
+private:
+	static uint16_t read16(const uint8_t *p)
+	{
+		return uint16_t(p[0] | p[1] << 8);
+	}
+
+	static uint32_t read32(const uint8_t *p)
+	{
+		return uint32_t(read16(p)) | uint32_t(read16(p + 2)) << 16;
+	}
+
+	// Applies the record at pos to current
+	bool step()
+	{
+		using namespace AnimationFormat;
+
+		if (pos >= size)
+			return false;
+
+		const uint8_t ctl = data[pos++];
+		const uint8_t *p = data + pos;
+		const size_t left = size - pos;
+
+		switch (ctl & TYPE_MASK)
+		{
+		case HOLD:
+			break;
+
+		case WORDS:
+		{
+			if (left < 2)
+				return false;
+			uint32_t mask = read16(p);
+			const size_t len = 2 + 2 * std::popcount(mask);
+			if (left < len)
+				return false;
+
+			for (p += 2; mask; mask &= mask - 1, p += 2)
+				current[std::countr_zero(mask)] ^= read16(p);
+			pos += len;
+			break;
+		}
+
+		case BYTES:
+		{
+			if (left < 4)
+				return false;
+			uint32_t mask = read32(p);
+			const size_t len = 4 + std::popcount(mask);
+			if (left < len)
+				return false;
+
+			for (p += 4; mask; mask &= mask - 1, ++p)
+			{
+				const unsigned b = std::countr_zero(mask);
+				current[b >> 1] ^= uint16_t(*p << ((b & 1) * 8));
+			}
+			pos += len;
+			break;
+		}
+
+		case KEY:
+			if (left < 2 * GRIDS)
+				return false;
+			for (size_t g = 0; g < GRIDS; ++g)
+				current[g] = read16(p + 2 * g);
+			pos += 2 * GRIDS;
+			break;
+		}
+
+		repeats = (ctl & COUNT_MASK) + 1;
+		return true;
+	}
+};
+
+#endif
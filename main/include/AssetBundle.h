@@ -0,0 +1,133 @@
+#ifndef AssetBundle_H
+#define AssetBundle_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include <esp_err.h>
+
+#include "AssetFormat.h"
+#include "Animation.h"
+
+// Maps the asset bundle (AssetFormat.h) from its partition, or from a file with mmap() on host builds,
+// and hands out assets in place: fonts are read straight from flash and clips are played by AnimationDecoder.
+class AssetBundle
+{
+	static constexpr const char *const TAG = "AssetBundle";
+
+public:
+	using Type = AssetFormat::Type;
+
+	struct Asset
+	{
+		const uint8_t *data = nullptr;
+		size_t size = 0;
+		Type type = Type::NONE;
+
+		explicit operator bool() const
+		{
+			return data != nullptr;
+		}
+
+		// In-place view, the data is aligned to AssetFormat::ALIGN
+		template <typename T>
+		const T *as() const
+		{
+			static_assert(alignof(T) <= AssetFormat::ALIGN);
+			return reinterpret_cast<const T *>(data);
+		}
+
+		template <typename T>
+		size_t count() const
+		{
+			return size / sizeof(T);
+		}
+	};
+
+private:
+	const uint8_t *base = nullptr; // mapped bundle
+	size_t mapped = 0;
+	const AssetFormat::Entry *index = nullptr;
+	uint16_t n = 0;
+
+	uint32_t handle = 0; // esp_partition_mmap_handle_t, unused on host
+
+public:
+	AssetBundle() = default;
+	AssetBundle(const AssetBundle &) = delete;
+	AssetBundle &operator=(const AssetBundle &) = delete;
+	~AssetBundle()
+	{
+		deinit();
+	}
+
+	// Maps and validates the bundle, only as much of the partition as its header says. name is the partition label,
+	// or the file path on host.
+	esp_err_t init(const char *name = "assets");
+	esp_err_t deinit();
+
+	bool is_open() const
+	{
+		return base != nullptr;
+	}
+
+	uint16_t version() const
+	{
+		return is_open() ? reinterpret_cast<const AssetFormat::Header *>(base)->version : 0;
+	}
+
+	// Bytes mapped, the bundle size from its header
+	size_t size() const
+	{
+		return mapped;
+	}
+
+	// Number of ids, including unused ones
+	uint16_t count() const
+	{
+		return n;
+	}
+
+	// O(1), an empty Asset if the id is unused or out of range
+	Asset get(uint16_t id) const
+	{
+		if (id >= n || !index[id].size)
+			return {};
+
+		const AssetFormat::Entry &e = index[id];
+		return {base + e.offset, e.size, e.type};
+	}
+
+	// The AssetFormat::GLYPHS segment patterns of a FONT asset by ASCII code, nullptr if missing
+	const uint16_t *font(uint16_t id) const
+	{
+		const Asset a = get(id);
+		if (a.type != Type::FONT || a.count<uint16_t>() < AssetFormat::GLYPHS)
+			return nullptr;
+		return a.as<uint16_t>();
+	}
+
+	// Segment pattern of c from a FONT asset, 0 if missing
+	uint16_t glyph(uint16_t id, char c) const
+	{
+		const uint16_t *f = font(id);
+		const unsigned char i = c;
+		return f && i < AssetFormat::GLYPHS ? f[i] : 0;
+	}
+
+	// Decoder playing an ANIMATION asset from flash, not valid() if missing
+	AnimationDecoder animation(uint16_t id) const
+	{
+		const Asset a = get(id);
+		if (a.type != Type::ANIMATION)
+			return {};
+		return {a.data, a.size};
+	}
+
+private:
+	esp_err_t map(const char *name);
+	void unmap();
+	esp_err_t validate() const;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef AssetFormat_H
+#define AssetFormat_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Versioned bundle of read-only assets (fonts, glyph LUTs, animation clips) in the "assets" data partition.
+// The partition is mapped once (AssetBundle) and assets are used in place, nothing is copied to RAM.
+//
+//   header   'V' 'F' 'D' 'A' version:u16 count:u16 size:u32
+//   index    count x {offset:u32 size:u32 type:u8 pad:u8[3]}, entry i is asset id i
+//   data     assets, each 4 byte aligned so LUTs of uint16_t / uint32_t can be read directly
+//
+// Ids are dense, so lookup is a bounds check and one index read. Unused ids have size 0.
+// Bundles are built on host by tools/asset_pack.cpp.
+namespace AssetFormat
+{
+	static constexpr char MAGIC[4] = {'V', 'F', 'D', 'A'};
+	static constexpr uint16_t VERSION = 1;
+	static constexpr size_t ALIGN = 4;
+
+	enum class Type : uint8_t
+	{
+		NONE = 0,
+		RAW,
+		FONT,	   // GLYPHS x uint16_t segment patterns, indexed by ASCII code
+		ANIMATION, // clip, see Animation.h
+	};
+
+	static constexpr size_t GLYPHS = 128; // SegmentDisplay::FONT_GLYPHS
+
+	// Ids the firmware looks up, the built-in glyph tables and boot clip are used when they are missing
+	namespace Id
+	{
+		static constexpr uint16_t FONT_7SEG = 0;
+		static constexpr uint16_t FONT_16SEG = 1;
+		static constexpr uint16_t BOOT_ANIMATION = 2;
+	};
+
+	struct Header
+	{
+		char magic[4];
+		uint16_t version;
+		uint16_t count;
+		uint32_t size; // whole bundle, header included
+	};
+
+	struct Entry
+	{
+		uint32_t offset; // from the start of the bundle
+		uint32_t size;
+		Type type;
+		uint8_t pad[3];
+	};
+
+	static_assert(sizeof(Header) == 12 && sizeof(Entry) == 12);
+};
+
+#endif
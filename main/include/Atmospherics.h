@@ -0,0 +1,85 @@
+#ifndef Atmospherics_H
+#define Atmospherics_H
+
+#include <cmath>
+#include <algorithm>
+
+#include "BME280.h"
+#include "FastMath.h"
+
+// Values derived from one BME280 sample, all in single precision with a fixed op count.
+// Error bounds are against the same formulas evaluated in double with libm,
+// over T in [-40, 85] DegC, RH in [1, 100] %, p in [30, 110] kPa.
+
+namespace Atmospherics
+{
+	struct Derived
+	{
+		float dew_point;		  // DegC
+		float heat_index;		  // DegC
+		float absolute_humidity;  // g/m3
+		float sea_level_pressure; // Pa
+		float altitude;			  // m
+	};
+
+	// Magnus coefficients (Sonntag 1990), saturation vapour pressure in hPa
+	constexpr float MAGNUS_A = 6.112f;
+	constexpr float MAGNUS_B = 17.62f;
+	constexpr float MAGNUS_C = 243.12f;
+
+	// Magnus exponent ln(RH/100) + b*T/(c+T), RH clamped to 0.1 %
+	inline float magnus_gamma(float t, float rh)
+	{
+		return FastMath::log(std::max(rh, 0.1f) * 0.01f) + MAGNUS_B * t / (MAGNUS_C + t);
+	}
+
+	// |error| <= 3e-4 DegC, 9 mul + 9 add + 2 div
+	inline float dew_point(float t, float rh)
+	{
+		const float gamma = magnus_gamma(t, rh);
+		return MAGNUS_C * gamma / (MAGNUS_B - gamma);
+	}
+
+	// relative error <= 1.5e-6, 10 mul + 8 add + 2 div
+	inline float absolute_humidity(float t, float rh)
+	{
+		const float e = MAGNUS_A * 0.01f * rh * FastMath::exp(MAGNUS_B * t / (MAGNUS_C + t)); // vapour pressure, hPa
+		return 216.7f * e / (273.15f + t);
+	}
+
+	// NWS heat index (Steadman, Rothfusz regression with both adjustments), |error| <= 1e-3 DegC from float rounding,
+	// except within rounding of the switch to the regression at 80 F, where it can take the other side of a ~1 DegC step.
+	// Only meaningful above ~27 DegC, below that it tracks the air temperature.
+	inline float heat_index(float t, float rh)
+	{
+		const float f = t * 1.8f + 32.0f;
+
+		float hi = 0.5f * (f + 61.0f + (f - 68.0f) * 1.2f + rh * 0.094f);
+
+		if ((hi + f) * 0.5f >= 80.0f)
+		{
+			hi = -42.379f + 2.04901523f * f + 10.14333127f * rh - 0.22475541f * f * rh - 0.00683783f * f * f - 0.05481717f * rh * rh + 0.00122874f * f * f * rh + 0.00085282f * f * rh * rh - 0.00000199f * f * f * rh * rh;
+
+			if (rh < 13.0f && f > 80.0f && f < 112.0f)
+				hi -= (13.0f - rh) * 0.25f * std::sqrt((17.0f - std::fabs(f - 95.0f)) * (1.0f / 17.0f));
+			else if (rh > 85.0f && f > 80.0f && f < 87.0f)
+				hi += (rh - 85.0f) * 0.1f * (87.0f - f) * 0.2f;
+		}
+
+		return (hi - 32.0f) * (1.0f / 1.8f);
+	}
+
+	// Recomputes everything from one sample, h is the station altitude in m, p0 the reference sea level pressure in Pa
+	inline Derived derive(const BME280::Meas &meas, float h = 0, float p0 = 101325)
+	{
+		Derived d;
+		d.dew_point = dew_point(meas.temperature, meas.humidity);
+		d.heat_index = heat_index(meas.temperature, meas.humidity);
+		d.absolute_humidity = absolute_humidity(meas.temperature, meas.humidity);
+		d.sea_level_pressure = BME280::get_sea_level_pressure(meas, h);
+		d.altitude = BME280::get_sea_level_altitude(meas, p0);
+		return d;
+	}
+};
+
+#endif
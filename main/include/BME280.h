@@ -14,8 +14,10 @@
 #include <driver/i2c_master.h>
 #include <driver/spi_master.h>
 #include <rom/ets_sys.h>
+#include <nvs.h>
 
 #include "BME280_SensorAPI.h"
+#include "FastMath.h"
 
 //
 
@@ -133,30 +135,73 @@ protected:
 		HUML = 0xFE,
 	};
 
+	// Persisted in NVS so warm boots can skip the soft reset and calibration readout
+	struct Cache
+	{
+		uint8_t version;
+		uint8_t chip_id;
+		bme280_calib_data calib;
+		bme280_settings settings;
+	};
+
+	static constexpr uint8_t CACHE_VERSION = 1;
+	static constexpr const char *const NVS_NAMESPACE = "bme280";
+
 protected:
 	bme280_dev dev = {};
 
 	bme280_settings settings_current = {};
 	bme280_settings settings_desired = {};
+	uint8_t mode_current = BME280_POWERMODE_SLEEP;
 
 	uint32_t period = 0;
 	bool continuous = false;
 
+	uint8_t cache_id = 0; // tells apart sensors sharing a chip ID (CS pin, I2C address)
+	Cache cache = {};
+	bool cache_valid = false; // cache matches what is stored in NVS
+	bool warm = false;
+
 public:
 	BME280() = default;
 	~BME280() = default;
 
 	esp_err_t init()
 	{
-		BME_RETURN_ON_ERROR(
-			bme280_init(&dev),
-			TAG);
+		uint8_t chip_id = 0;
+		warm = false;
 
-		BME_RETURN_ON_ERROR(
-			bme280_get_sensor_settings(&settings_current, &dev),
-			TAG);
+		// Warm boot: a single chip ID read validates the sensor, calibration comes from NVS
+		if (bme280_get_regs(BME280_REG_CHIP_ID, &chip_id, 1, &dev) == BME280_OK && chip_id == BME280_CHIP_ID && cache_load(chip_id) == ESP_OK)
+		{
+			dev.chip_id = chip_id;
+			dev.calib_data = cache.calib;
+			cache_valid = true;
+			warm = true;
+		}
+		else
+		{
+			BME_RETURN_ON_ERROR(
+				bme280_init(&dev),
+				TAG);
+
+			cache = {};
+			cache_valid = false;
+			cache.version = CACHE_VERSION;
+			cache.chip_id = dev.chip_id;
+			cache.calib = dev.calib_data;
+		}
+
+		ESP_RETURN_ON_ERROR(
+			read_state(),
+			TAG, "Failed to read_state!");
 		settings_desired = settings_current;
 
+		if (warm && !settings_equal(settings_current, cache.settings))
+			ESP_LOGI(TAG, "Sensor lost its settings since the last boot, they will be rewritten");
+
+		ESP_LOGI(TAG, "Initialized (%s boot)", warm ? "warm" : "cold");
+
 		return ESP_OK;
 	}
 	esp_err_t deinit()
@@ -170,14 +215,15 @@ public:
 	{
 		continuous = c;
 
-		if (continuous)
-			BME_RETURN_ON_ERROR(
-				bme280_set_sensor_mode(BME280_POWERMODE_NORMAL, &dev),
-				TAG);
-		else
-			BME_RETURN_ON_ERROR(
-				bme280_set_sensor_mode(BME280_POWERMODE_SLEEP, &dev),
-				TAG);
+		const uint8_t mode = continuous ? BME280_POWERMODE_NORMAL : BME280_POWERMODE_SLEEP;
+
+		if (mode == mode_current) // already there, skip sleep + reload round trip
+			return ESP_OK;
+
+		BME_RETURN_ON_ERROR(
+			bme280_set_sensor_mode(mode, &dev),
+			TAG);
+		mode_current = mode;
 
 		return ESP_OK;
 	}
@@ -214,34 +260,70 @@ public:
 
 	esp_err_t apply_settings()
 	{
-		BME_RETURN_ON_ERROR(
-			bme280_set_sensor_settings(BME280_SEL_ALL_SETTINGS, &settings_desired, &dev),
-			TAG);
-		settings_current = settings_desired;
+		if (!settings_equal(settings_desired, settings_current))
+		{
+			BME_RETURN_ON_ERROR(
+				bme280_set_sensor_settings(BME280_SEL_ALL_SETTINGS, &settings_desired, &dev),
+				TAG);
+			settings_current = settings_desired;
+			mode_current = BME280_POWERMODE_SLEEP; // set_sensor_settings leaves the sensor asleep
+		}
 
 		BME_RETURN_ON_ERROR(
 			bme280_cal_meas_delay(&period, &settings_current),
 			TAG);
 
+		if (!cache_valid || !settings_equal(settings_current, cache.settings))
+		{
+			cache.settings = settings_current;
+			cache_valid = cache_store() == ESP_OK;
+			if (!cache_valid) // not fatal, next boot is just a cold one
+				ESP_LOGW(TAG, "Failed to cache_store!");
+		}
+
 		return continuous_mode(continuous); // reapply mode
 	}
 
+	bool warm_boot() const
+	{
+		return warm;
+	}
+
 	//
 
 	esp_err_t measure(Meas &out, bool force_dly = false)
 	{
-		uint8_t status_reg;
-		bme280_data comp_data;
+		ESP_RETURN_ON_ERROR(
+			trigger(),
+			TAG, "Failed to trigger!");
 
-		out = {};
+		if (!continuous || force_dly)
+			dev.delay_us(period, dev.intf_ptr);
 
+		return collect(out);
+	}
+
+	// Start a conversion, no-op in continuous mode. Result is ready after meas_period() us.
+	esp_err_t trigger()
+	{
 		if (!continuous)
+		{
 			BME_RETURN_ON_ERROR(
 				bme280_set_sensor_mode(BME280_POWERMODE_FORCED, &dev),
 				TAG);
+			mode_current = BME280_POWERMODE_SLEEP; // returns to sleep on its own
+		}
 
-		if (!continuous || force_dly)
-			dev.delay_us(period, dev.intf_ptr);
+		return ESP_OK;
+	}
+
+	// Read out the last conversion without waiting
+	esp_err_t collect(Meas &out)
+	{
+		uint8_t status_reg;
+		bme280_data comp_data;
+
+		out = {};
 
 		//*/ // throw error if not completed after delay (should not really happen but it was in the original example)
 		BME_RETURN_ON_ERROR(
@@ -266,16 +348,98 @@ public:
 		return ESP_OK;
 	}
 
+	uint32_t meas_period() const
+	{
+		return period;
+	}
+
+	bool is_continuous() const
+	{
+		return continuous;
+	}
+
 	//
 
+	// relative error <= 3.5e-5 for h in [0, 3000] m (FastMath::pow)
 	static float get_sea_level_pressure(const Meas &meas, float h = 0)
 	{
-		return meas.pressure * std::pow(1 - h * (g / cp / T0), -cp * M / R0);
+		return meas.pressure * FastMath::pow(1 - h * (g / cp / T0), -cp * M / R0);
 	}
 
+	// |error| <= 0.12 m for p0 in [95, 105] kPa (FastMath::pow)
 	static float get_sea_level_altitude(const Meas &meas, float p0 = 101325)
 	{
-		return cp * T0 / g * (1 - std::pow(meas.pressure / p0, R0 / cp / M));
+		return cp * T0 / g * (1 - FastMath::pow(meas.pressure / p0, R0 / cp / M));
+	}
+
+protected:
+	esp_err_t read_state()
+	{
+		uint8_t reg_data[4]; // CTRL_HUM, STATUS, CTRL_MEAS, CONFIG
+
+		BME_RETURN_ON_ERROR(
+			bme280_get_regs(BME280_REG_CTRL_HUM, reg_data, 4, &dev),
+			TAG);
+
+		settings_current.osr_h = BME280_GET_BITS_POS_0(reg_data[0], BME280_CTRL_HUM);
+		settings_current.osr_p = BME280_GET_BITS(reg_data[2], BME280_CTRL_PRESS);
+		settings_current.osr_t = BME280_GET_BITS(reg_data[2], BME280_CTRL_TEMP);
+		settings_current.filter = BME280_GET_BITS(reg_data[3], BME280_FILTER);
+		settings_current.standby_time = BME280_GET_BITS(reg_data[3], BME280_STANDBY);
+		mode_current = BME280_GET_BITS_POS_0(reg_data[2], BME280_SENSOR_MODE);
+
+		return ESP_OK;
+	}
+
+	esp_err_t cache_load(uint8_t chip_id)
+	{
+		nvs_handle_t nvs_hdl;
+		char key[NVS_KEY_NAME_MAX_SIZE];
+		size_t len = sizeof(cache);
+
+		snprintf(key, sizeof(key), "%02x%02x", chip_id, cache_id);
+
+		esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_hdl);
+		if (ret == ESP_ERR_NVS_NOT_FOUND) // first boot, the namespace is created by the first cache_store()
+			return ret;
+		ESP_RETURN_ON_ERROR(
+			ret,
+			TAG, "Failed to nvs_open!");
+
+		ret = nvs_get_blob(nvs_hdl, key, &cache, &len);
+		nvs_close(nvs_hdl);
+
+		if (ret != ESP_OK)
+			return ret;
+
+		if (len != sizeof(cache) || cache.version != CACHE_VERSION || cache.chip_id != chip_id)
+			return ESP_ERR_INVALID_VERSION;
+
+		return ESP_OK;
+	}
+
+	esp_err_t cache_store()
+	{
+		nvs_handle_t nvs_hdl;
+		char key[NVS_KEY_NAME_MAX_SIZE];
+
+		snprintf(key, sizeof(key), "%02x%02x", cache.chip_id, cache_id);
+
+		ESP_RETURN_ON_ERROR(
+			nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_hdl),
+			TAG, "Failed to nvs_open!");
+
+		esp_err_t ret = nvs_set_blob(nvs_hdl, key, &cache, sizeof(cache));
+		if (ret == ESP_OK)
+			ret = nvs_commit(nvs_hdl);
+		nvs_close(nvs_hdl);
+
+		return ret;
+	}
+
+	static bool settings_equal(const bme280_settings &a, const bme280_settings &b)
+	{
+		return a.osr_p == b.osr_p && a.osr_t == b.osr_t && a.osr_h == b.osr_h && a.filter == b.filter && a.standby_time == b.standby_time;
 	}
 
 protected:
@@ -338,7 +502,7 @@ protected:
 	}
 
 private:
-#ifdef BME280_DOUBLE_ENABLE
+#if defined(BME280_DOUBLE_ENABLE) || defined(BME280_FLOAT_ENABLE)
 	Meas bme_data_to_meas(const bme280_data &data)
 	{
 		Meas meas;
@@ -397,6 +561,7 @@ private:
 public:
 	BME280_I2C(i2c_master_bus_handle_t ih, uint16_t a = 0b0, uint32_t chz = 400'000) : i2c_host(ih), address(0x76 | (a & 0b1)), clk_hz(chz)
 	{
+		cache_id = address;
 		ESP_LOGI(TAG, "Constructed with address: %d", address); // port: %d, , ih
 	}
 	~BME280_I2C() = default;
@@ -482,9 +647,14 @@ private:
 	int clk_hz;
 	spi_device_handle_t spi_hdl = nullptr;
 
+	// Per instance, so sensors sharing the bus never share a transaction
+	spi_transaction_t trx_rd = {};
+	spi_transaction_t trx_wr = {};
+
 public:
 	BME280_SPI(spi_host_device_t sh, gpio_num_t csg, int chz = 10'000'000) : spi_host(sh), cs_gpio(csg), clk_hz(chz)
 	{
+		cache_id = cs_gpio;
 		ESP_LOGI(TAG, "Constructed with host: %d, pin: %d", spi_host, cs_gpio);
 	}
 	~BME280_SPI() = default;
@@ -517,7 +687,7 @@ public:
 			TAG, "Error in spi_bus_add_device!");
 
 		dev.intf = BME280_SPI_INTF;
-		dev.intf_ptr = static_cast<void *>(spi_hdl);
+		dev.intf_ptr = static_cast<void *>(this);
 
 		dev.read = bme280_read;
 		dev.write = bme280_write;
@@ -554,15 +724,15 @@ public:
 private:
 	static esp_err_t bme280_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
 	{
-		static spi_transaction_t trx = {};
-		spi_device_handle_t spi_hdl = static_cast<spi_device_handle_t>(intf_ptr);
+		BME280_SPI *self = static_cast<BME280_SPI *>(intf_ptr);
+		spi_transaction_t &trx = self->trx_rd;
 
 		trx.addr = reg_addr;
 		trx.rx_buffer = reg_data;
 		trx.rxlength = len * 8;
 
 		ESP_RETURN_ON_ERROR(
-			spi_device_polling_transmit(spi_hdl, &trx),
+			spi_device_polling_transmit(self->spi_hdl, &trx),
 			TAG, "Failed to spi_device_polling_transmit!");
 
 		return ESP_OK;
@@ -570,15 +740,15 @@ private:
 
 	static esp_err_t bme280_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
 	{
-		static spi_transaction_t trx = {};
-		spi_device_handle_t spi_hdl = static_cast<spi_device_handle_t>(intf_ptr);
+		BME280_SPI *self = static_cast<BME280_SPI *>(intf_ptr);
+		spi_transaction_t &trx = self->trx_wr;
 
 		trx.addr = reg_addr;
 		trx.tx_buffer = reg_data;
 		trx.length = len * 8;
 
 		ESP_RETURN_ON_ERROR(
-			spi_device_polling_transmit(spi_hdl, &trx),
+			spi_device_polling_transmit(self->spi_hdl, &trx),
 			TAG, "Failed to spi_device_polling_transmit!");
 
 		return ESP_OK;
@@ -1,13 +1,458 @@
 #pragma once
 
-#include <iostream>
 #include <algorithm>
 #include <array>
-#include <bitset>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iterator>
-#include <stdexcept>
+#include <tuple>
 #include <type_traits>
 
+#ifdef BITMATRIX_OSTREAM_ENABLE // operator<< for host tools and tests, keeps iostream out of the firmware
+#include <ostream>
+#endif
+
+// Side of the square block a transpose works on: the power of two covering n, the shorter side of the matrix, at most 64.
+// A block as wide as the longer side would be mostly padding for a strip like 8x128.
+constexpr size_t transpose_block_size(size_t n)
+{
+	size_t b = 1;
+	while (b < n && b < 64)
+		b <<= 1;
+	return b;
+}
+
+// Transposes the BxB bit matrix whose row r is a[r], column c at bit c, bits above B zero.
+// Recursive block swap (Hacker's Delight 7-3): log2(B) rounds of B/2 masked word swaps instead of B*B bit moves.
+template <size_t B>
+constexpr void transpose_bits(std::array<uint64_t, B> &a)
+{
+	static_assert(B >= 1 && B <= 64 && (B & (B - 1)) == 0, "Block must be a power of two up to 64!");
+
+	uint64_t m = B == 64 ? 0x00000000FFFFFFFFULL : (uint64_t(1) << (B / 2)) - 1; // low half of every 2j bits
+	for (size_t j = B / 2; j != 0; j >>= 1, m ^= m << j)
+		for (size_t k = 0; k < B; k = ((k | j) + 1) & ~j) // rows with bit j clear
+		{
+			const uint64_t t = ((a[k] >> j) ^ a[k | j]) & m;
+			a[k] ^= t << j;
+			a[k | j] ^= t;
+		}
+}
+
+// Row of W bits with the std::bitset interface BitMatrix uses, but constexpr throughout (std::bitset is only from C++23)
+// and stored in the smallest word that holds it. Bit i is bit i % WORD_BITS of word i / WORD_BITS, bits from W up stay 0.
+template <size_t W>
+class BitRow
+{
+public:
+	using word_t = std::conditional_t<(W <= 8), uint8_t, std::conditional_t<(W <= 16), uint16_t, std::conditional_t<(W <= 32), uint32_t, uint64_t>>>;
+	static constexpr size_t WORD_BITS = 8 * sizeof(word_t);
+	static constexpr size_t WORDS = (W + WORD_BITS - 1) / WORD_BITS;
+
+private:
+	static constexpr word_t ONES = word_t(~word_t(0));
+	static constexpr word_t LAST_MASK = W % WORD_BITS ? word_t((uint64_t(1) << (W % WORD_BITS)) - 1) : ONES;
+
+	std::array<word_t, WORDS> words = {};
+
+public:
+	class reference
+	{
+		friend class BitRow;
+
+		BitRow *row;
+		size_t pos;
+
+		constexpr reference(BitRow &r, size_t p) : row(&r), pos(p) {}
+
+	public:
+		constexpr operator bool() const
+		{
+			return row->test(pos);
+		}
+		constexpr bool operator~() const
+		{
+			return !row->test(pos);
+		}
+		constexpr reference &operator=(bool v)
+		{
+			row->set(pos, v);
+			return *this;
+		}
+		constexpr reference &operator=(const reference &r)
+		{
+			return *this = bool(r);
+		}
+		constexpr reference &flip()
+		{
+			row->flip(pos);
+			return *this;
+		}
+	};
+
+	constexpr BitRow() = default;
+	constexpr BitRow(unsigned long long v)
+	{
+		for (size_t i = 0; i < WORDS && i * WORD_BITS < 64; ++i)
+			words[i] = word_t(v >> (i * WORD_BITS));
+		trim();
+	}
+
+	static constexpr size_t size()
+	{
+		return W;
+	}
+
+	constexpr bool operator[](size_t pos) const
+	{
+		return test(pos);
+	}
+	constexpr reference operator[](size_t pos)
+	{
+		return reference(*this, pos);
+	}
+
+	constexpr bool test(size_t pos) const
+	{
+		return words[pos / WORD_BITS] >> (pos % WORD_BITS) & 1;
+	}
+
+	constexpr BitRow &set()
+	{
+		words.fill(ONES);
+		return trim();
+	}
+	constexpr BitRow &set(size_t pos, bool v = true)
+	{
+		const word_t m = word_t(word_t(1) << (pos % WORD_BITS));
+		word_t &w = words[pos / WORD_BITS];
+		w = v ? word_t(w | m) : word_t(w & ~m);
+		return *this;
+	}
+
+	constexpr BitRow &reset()
+	{
+		words.fill(0);
+		return *this;
+	}
+	constexpr BitRow &reset(size_t pos)
+	{
+		return set(pos, false);
+	}
+
+	constexpr BitRow &flip()
+	{
+		for (word_t &w : words)
+			w = word_t(~w);
+		return trim();
+	}
+	constexpr BitRow &flip(size_t pos)
+	{
+		words[pos / WORD_BITS] ^= word_t(word_t(1) << (pos % WORD_BITS));
+		return *this;
+	}
+
+	constexpr size_t count() const
+	{
+		size_t n = 0;
+		for (word_t w : words)
+			n += std::popcount(w);
+		return n;
+	}
+
+	constexpr bool any() const
+	{
+		for (word_t w : words)
+			if (w)
+				return true;
+		return false;
+	}
+	constexpr bool none() const
+	{
+		return !any();
+	}
+	constexpr bool all() const
+	{
+		for (size_t i = 0; i + 1 < WORDS; ++i)
+			if (words[i] != ONES)
+				return false;
+		return words[WORDS - 1] == LAST_MASK;
+	}
+
+	// Low 64 bits, the rest is ignored (std::bitset would throw)
+	constexpr unsigned long long to_ullong() const
+	{
+		return extract(0);
+	}
+
+	// 64 bits from bit i up, 0 past the end
+	constexpr uint64_t extract(size_t i) const
+	{
+		if constexpr (WORDS == 1)
+			return i < WORD_BITS ? uint64_t(words[0]) >> i : 0;
+		else // uint64_t words
+		{
+			const size_t k = i / 64;
+			const size_t s = i % 64;
+			uint64_t r = k < WORDS ? words[k] >> s : 0;
+			if (s && k + 1 < WORDS)
+				r |= words[k + 1] << (64 - s);
+			return r;
+		}
+	}
+
+	constexpr word_t word(size_t i) const
+	{
+		return words[i];
+	}
+
+	constexpr BitRow &operator&=(const BitRow &b)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] &= b.words[i];
+		return *this;
+	}
+	constexpr BitRow &operator|=(const BitRow &b)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] |= b.words[i];
+		return *this;
+	}
+	constexpr BitRow &operator^=(const BitRow &b)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] ^= b.words[i];
+		return *this;
+	}
+
+	// Towards higher bits, like std::bitset
+	constexpr BitRow &operator<<=(size_t n)
+	{
+		if (n >= W)
+			return reset();
+		if constexpr (WORDS == 1)
+		{
+			words[0] = word_t(words[0] << n);
+			return trim();
+		}
+
+		const size_t ws = n / WORD_BITS;
+		const size_t bs = n % WORD_BITS;
+		for (size_t i = WORDS; i-- > ws;)
+		{
+			word_t w = word_t(words[i - ws] << bs);
+			if (bs && i > ws)
+				w |= word_t(words[i - ws - 1] >> (WORD_BITS - bs));
+			words[i] = w;
+		}
+		for (size_t i = 0; i < ws; ++i)
+			words[i] = 0;
+		return trim();
+	}
+	constexpr BitRow &operator>>=(size_t n)
+	{
+		if (n >= W)
+			return reset();
+		if constexpr (WORDS == 1)
+		{
+			words[0] >>= n;
+			return *this;
+		}
+
+		const size_t ws = n / WORD_BITS;
+		const size_t bs = n % WORD_BITS;
+		for (size_t i = 0; i + ws < WORDS; ++i)
+		{
+			word_t w = word_t(words[i + ws] >> bs);
+			if (bs && i + ws + 1 < WORDS)
+				w |= word_t(words[i + ws + 1] << (WORD_BITS - bs));
+			words[i] = w;
+		}
+		for (size_t i = WORDS - ws; i < WORDS; ++i)
+			words[i] = 0;
+		return *this;
+	}
+
+	constexpr BitRow operator~() const
+	{
+		return BitRow(*this).flip();
+	}
+	constexpr BitRow operator<<(size_t n) const
+	{
+		return BitRow(*this) <<= n;
+	}
+	constexpr BitRow operator>>(size_t n) const
+	{
+		return BitRow(*this) >>= n;
+	}
+
+	friend constexpr BitRow operator&(const BitRow &a, const BitRow &b)
+	{
+		return BitRow(a) &= b;
+	}
+	friend constexpr BitRow operator|(const BitRow &a, const BitRow &b)
+	{
+		return BitRow(a) |= b;
+	}
+	friend constexpr BitRow operator^(const BitRow &a, const BitRow &b)
+	{
+		return BitRow(a) ^= b;
+	}
+
+	friend constexpr bool operator==(const BitRow &a, const BitRow &b)
+	{
+		return a.words == b.words;
+	}
+	friend constexpr bool operator!=(const BitRow &a, const BitRow &b)
+	{
+		return !(a == b);
+	}
+
+private:
+	constexpr BitRow &trim()
+	{
+		words[WORDS - 1] &= LAST_MASK;
+		return *this;
+	}
+};
+
+// Row operations of the lazy BitMatrix operators, see BitExpr
+namespace BitOp
+{
+	struct Or
+	{
+		template <typename R>
+		static constexpr R apply(const R &a, const R &b) { return a | b; }
+	};
+	struct And
+	{
+		template <typename R>
+		static constexpr R apply(const R &a, const R &b) { return a & b; }
+	};
+	struct Xor
+	{
+		template <typename R>
+		static constexpr R apply(const R &a, const R &b) { return a ^ b; }
+	};
+	struct Minus // A↛B
+	{
+		template <typename R>
+		static constexpr R apply(const R &a, const R &b) { return a & ~b; }
+	};
+	struct OrNot // A←B
+	{
+		template <typename R>
+		static constexpr R apply(const R &a, const R &b) { return a | ~b; }
+	};
+	struct Nor
+	{
+		template <typename R>
+		static constexpr R apply(const R &a, const R &b) { return ~(a | b); }
+	};
+	struct Nand
+	{
+		template <typename R>
+		static constexpr R apply(const R &a, const R &b) { return ~(a & b); }
+	};
+	struct Xnor
+	{
+		template <typename R>
+		static constexpr R apply(const R &a, const R &b) { return ~(a ^ b); }
+	};
+	struct Not
+	{
+		template <typename R>
+		static constexpr R apply(const R &a) { return ~a; }
+	};
+};
+
+template <typename Op, typename... Args>
+class BitExpr;
+
+template <typename T, size_t H, size_t W>
+class Matrix;
+
+template <size_t H, size_t W, typename L, typename RowBits>
+constexpr size_t label_runs(Matrix<L, H, W> *labels, char conn, bool mirrored, RowBits row_bits);
+
+// Not constexpr and never defined: a call from BitMatrix::parse() stops the compilation with the reason in the message
+void bitmatrix_art_error(const char *why);
+
+// Bounding box of the set pixels: rows y0..y1-1, columns x0..x1-1, empty if nothing is set
+struct BitBox
+{
+	size_t y0 = 0;
+	size_t x0 = 0;
+	size_t y1 = 0;
+	size_t x1 = 0;
+
+	constexpr bool empty() const
+	{
+		return y1 <= y0;
+	}
+	constexpr size_t height() const
+	{
+		return y1 - y0;
+	}
+	constexpr size_t width() const
+	{
+		return x1 - x0;
+	}
+};
+
+// Text output without iostream. A sink is called as sink(const char *line, size_t len) once per line,
+// without the '\n' but NUL-terminated, so it can go straight to ESP_LOGI(TAG, "%s", line).
+namespace MatrixDump
+{
+	// Joins the lines of dump(sink) with '\n' into buf, always NUL-terminated, returns the full length like snprintf
+	template <typename Dump>
+	size_t to_buffer(char *buf, size_t size, Dump dump)
+	{
+		size_t len = 0;
+		auto append = [&](const char *line, size_t n)
+		{
+			for (size_t i = 0; i <= n; ++i, ++len)
+				if (len + 1 < size)
+					buf[len] = i < n ? line[i] : '\n';
+		};
+		dump(append);
+
+		if (size)
+			buf[std::min(len, size - 1)] = 0;
+		return len;
+	}
+
+	// Rows as '.'/'#' with their index, two lines of column digits, a summary and an empty line
+	template <size_t H, size_t W, typename Test, typename Sink>
+	void bits(Test test, bool any, bool all, bool none, Sink &&sink)
+	{
+		char line[W + 24];
+
+		for (size_t y = 0; y < H; ++y)
+		{
+			for (size_t x = 0; x < W; ++x)
+				line[x] = test(y, x) ? '#' : '.';
+			const int n = std::snprintf(line + W, sizeof(line) - W, " %u", unsigned(y));
+			sink(static_cast<const char *>(line), W + n);
+		}
+
+		for (size_t x = 0; x < W; ++x)
+			line[x] = '0' + (x % 100) / 10;
+		line[W] = 0;
+		sink(static_cast<const char *>(line), W);
+
+		for (size_t x = 0; x < W; ++x)
+			line[x] = '0' + x % 10;
+		sink(static_cast<const char *>(line), W);
+
+		const int n = std::snprintf(line, sizeof(line), "Any: %d, All: %d, None: %d", any, all, none);
+		sink(static_cast<const char *>(line), std::min<size_t>(n, sizeof(line) - 1));
+		sink("", 0);
+	}
+};
+
 template <size_t H, size_t W>
 class BitMatrix
 {
@@ -15,7 +460,7 @@ class BitMatrix
 	static_assert(W >= 1, "Width  must be greater than 0!");
 
 public:
-	using row_t = std::bitset<W>;
+	using row_t = BitRow<W>;
 	using this_t = BitMatrix<H, W>;
 	using crd_t = size_t;
 	using idx_t = size_t;
@@ -24,8 +469,60 @@ protected:
 	std::array<row_t, H> content;
 
 public:
-	BitMatrix() {}
-	~BitMatrix() {}
+	constexpr BitMatrix() : content({}) {}
+	~BitMatrix() = default;
+
+	// Evaluates a whole operator expression in one pass over the rows, see BitExpr
+	template <typename Op, typename... Args>
+	constexpr BitMatrix(const BitExpr<Op, Args...> &e)
+	{
+		assign(e);
+	}
+	template <typename Op, typename... Args>
+	constexpr this_t &operator=(const BitExpr<Op, Args...> &e)
+	{
+		return assign(e);
+	}
+
+	// Matrix from string art at compile time, '#' set and '.' clear, one row per line:
+	//   static constexpr auto arrow = BitMatrix<3, 4>::parse("..#.\n"
+	//                                                        "####\n"
+	//                                                        "..#.");
+	// Spaces, tabs and empty lines are ignored, so an indented raw string works too. Wrong sizes or characters do not compile.
+	static consteval this_t parse(const char *art)
+	{
+		this_t m;
+		size_t y = 0;
+		size_t x = 0;
+		for (const char *c = art;; ++c)
+		{
+			if (*c == '#' || *c == '.')
+			{
+				if (y >= H)
+					bitmatrix_art_error("Too many rows!");
+				if (x >= W)
+					bitmatrix_art_error("Row too long!");
+				m.set(y, x++, *c == '#');
+			}
+			else if (*c == '\n' || *c == 0)
+			{
+				if (x)
+				{
+					if (x != W)
+						bitmatrix_art_error("Row too short!");
+					++y;
+					x = 0;
+				}
+				if (!*c)
+					break;
+			}
+			else if (*c != ' ' && *c != '\t')
+				bitmatrix_art_error("Only '#', '.' and whitespace allowed!");
+		}
+		if (y != H)
+			bitmatrix_art_error("Too few rows!");
+		return m;
+	}
 
 	// typename???
 
@@ -33,12 +530,16 @@ public:
 	{
 		return content[pos];
 	}
+	inline constexpr const row_t &operator[](size_t pos) const
+	{
+		return content[pos];
+	}
 
 	inline constexpr bool operator()(size_t y, size_t x) const
 	{
 		return content[y][W - x - 1];
 	}
-	inline typename row_t::reference operator()(size_t y, size_t x)
+	inline constexpr typename row_t::reference operator()(size_t y, size_t x)
 	{
 		return content[y][W - x - 1];
 	}
@@ -47,7 +548,7 @@ public:
 	{
 		return content[yx.first][W - yx.second - 1];
 	}
-	inline typename row_t::reference operator()(std::pair<size_t, size_t> yx)
+	inline constexpr typename row_t::reference operator()(std::pair<size_t, size_t> yx)
 	{
 		return content[yx.first][W - yx.second - 1];
 	}
@@ -56,7 +557,7 @@ public:
 	{
 		return content[pos / W][W - pos % W - 1];
 	}
-	inline typename row_t::reference operator()(size_t pos)
+	inline constexpr typename row_t::reference operator()(size_t pos)
 	{
 		return content[pos / W][W - pos % W - 1];
 	}
@@ -91,7 +592,7 @@ public:
 	}
 
 	// Contradiction           | 0    | 0
-	this_t &Opq()
+	constexpr this_t &Opq()
 	{
 		for (size_t y = 0; y < H; ++y)
 			content[y].reset();
@@ -99,7 +600,7 @@ public:
 	}
 
 	template <size_t Hb, size_t Wb> // Logical conjunction     | A∧B | A&B
-	this_t &Kpq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Kpq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -110,7 +611,7 @@ public:
 	}
 
 	template <size_t Hb, size_t Wb> // Material nonimplication | A↛B  | A&~B
-	this_t &Lpq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Lpq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -121,13 +622,13 @@ public:
 	}
 
 	// Projection function     | A    | A
-	this_t &Ipq()
+	constexpr this_t &Ipq()
 	{
 		return *this;
 	}
 
 	template <size_t Hb, size_t Wb> // Converse nonimplication | A↚B  | ~A&B
-	this_t &Mpq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Mpq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -135,13 +636,13 @@ public:
 		for (size_t y = 0; y < H; ++y)
 		{
 			content[y].flip();
-			content[y] &= ~B.content[y];
+			content[y] &= B.content[y];
 		}
 		return *this;
 	}
 
 	template <size_t Hb, size_t Wb> // Projection function     | B    | B
-	this_t &Hpq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Hpq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -152,7 +653,7 @@ public:
 	}
 
 	template <size_t Hb, size_t Wb> // Exclusive disjunction   | A⊕B  | A^B
-	this_t &Jpq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Jpq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -163,7 +664,7 @@ public:
 	}
 
 	template <size_t Hb, size_t Wb> // Logical disjunction     | A∨B | A|B
-	this_t &Apq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Apq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -174,21 +675,21 @@ public:
 	}
 
 	template <size_t Hb, size_t Wb> // Logical NOR             | A↓B  | ~(A|B)
-	this_t &Xpq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Xpq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
 
 		for (size_t y = 0; y < H; ++y)
 		{
-			content[y] &= B.content[y];
+			content[y] |= B.content[y];
 			content[y].flip();
 		}
 		return *this;
 	}
 
 	template <size_t Hb, size_t Wb> // Logical biconditional   | A↔B  | ~(A^B)
-	this_t &Epq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Epq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -202,7 +703,7 @@ public:
 	}
 
 	template <size_t Hb, size_t Wb> // Negation                | ¬B   | ~B
-	this_t &Gpq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Gpq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -213,7 +714,7 @@ public:
 	}
 
 	template <size_t Hb, size_t Wb> // Converse implication    | A←B  | A|~B
-	this_t &Bpq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Bpq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -224,7 +725,7 @@ public:
 	}
 
 	// Negation                | ¬A   | ~A
-	this_t &Fpq()
+	constexpr this_t &Fpq()
 	{
 		for (size_t y = 0; y < H; ++y)
 			content[y].flip();
@@ -232,7 +733,7 @@ public:
 	}
 
 	template <size_t Hb, size_t Wb> // Material implication    | A→B  | ~A|B
-	this_t &Cpq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Cpq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -246,7 +747,7 @@ public:
 	}
 
 	template <size_t Hb, size_t Wb> // Logical NAND            | A↑B  | ~(A&B)
-	this_t &Dpq(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &Dpq(const BitMatrix<Hb, Wb> &B)
 	{
 		static_assert(H == Hb, "Matrix heights must match!");
 		static_assert(W == Wb, "Matrix widths  must match!");
@@ -260,121 +761,93 @@ public:
 	}
 
 	// Tautology               | 1    | 1
-	this_t &Vpq()
+	constexpr this_t &Vpq()
 	{
 		for (size_t y = 0; y < H; ++y)
 			content[y].set();
 		return *this;
 	}
 
-	this_t &flip()
+	constexpr this_t &flip()
 	{
 		return Fpq();
 	}
 
-	this_t &operator-()
+	constexpr this_t &operator-()
 	{
 		return Opq();
 	}
-	this_t &operator+()
+	constexpr this_t &operator+()
 	{
 		return Vpq();
 	}
-	this_t &operator~()
+	constexpr this_t &operator~()
 	{
 		return Fpq();
 	}
-	this_t operator!() const
-	{
-		this_t temp(*this);
-		return temp.Fpq();
-	}
 
 	template <size_t Hb, size_t Wb>
-	this_t &operator|=(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &operator|=(const BitMatrix<Hb, Wb> &B)
 	{
 		return Apq(B);
 	}
 
 	template <size_t Hb, size_t Wb>
-	this_t &operator&=(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &operator&=(const BitMatrix<Hb, Wb> &B)
 	{
 		return Kpq(B);
 	}
 
 	template <size_t Hb, size_t Wb>
-	this_t &operator^=(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &operator^=(const BitMatrix<Hb, Wb> &B)
 	{
 		return Jpq(B);
 	}
 
 	template <size_t Hb, size_t Wb>
-	this_t &operator-=(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &operator-=(const BitMatrix<Hb, Wb> &B)
 	{
 		return Lpq(B);
 	}
 
 	template <size_t Hb, size_t Wb>
-	this_t &operator/=(const BitMatrix<Hb, Wb> &B)
+	constexpr this_t &operator/=(const BitMatrix<Hb, Wb> &B)
 	{
 		return Bpq(B);
 	}
 
-	template <size_t Ha, size_t Wa, size_t Hb, size_t Wb>
-	friend BitMatrix<Ha, Wa> operator|(BitMatrix<Ha, Wa> A, const BitMatrix<Hb, Wb> &B)
-	{
-		return A.operator|=(B);
-	}
-
-	template <size_t Ha, size_t Wa, size_t Hb, size_t Wb>
-	friend BitMatrix<Ha, Wa> operator&(BitMatrix<Ha, Wa> A, const BitMatrix<Hb, Wb> &B)
+	// Compound assignment from an expression, row by row, so the matrix may appear in it
+	template <typename Op, typename... Args>
+	constexpr this_t &operator|=(const BitExpr<Op, Args...> &e)
 	{
-		return A.operator&=(B);
+		return combine<BitOp::Or>(e);
 	}
 
-	template <size_t Ha, size_t Wa, size_t Hb, size_t Wb>
-	friend BitMatrix<Ha, Wa> operator^(BitMatrix<Ha, Wa> A, const BitMatrix<Hb, Wb> &B)
+	template <typename Op, typename... Args>
+	constexpr this_t &operator&=(const BitExpr<Op, Args...> &e)
 	{
-		return A.operator^=(B);
+		return combine<BitOp::And>(e);
 	}
 
-	template <size_t Ha, size_t Wa, size_t Hb, size_t Wb>
-	friend BitMatrix<Ha, Wa> operator-(BitMatrix<Ha, Wa> A, const BitMatrix<Hb, Wb> &B)
+	template <typename Op, typename... Args>
+	constexpr this_t &operator^=(const BitExpr<Op, Args...> &e)
 	{
-		return A.operator-=(B);
+		return combine<BitOp::Xor>(e);
 	}
 
-	template <size_t Ha, size_t Wa, size_t Hb, size_t Wb>
-	friend BitMatrix<Ha, Wa> operator/(BitMatrix<Ha, Wa> A, const BitMatrix<Hb, Wb> &B)
+	template <typename Op, typename... Args>
+	constexpr this_t &operator-=(const BitExpr<Op, Args...> &e)
 	{
-		return A.operator/=(B);
+		return combine<BitOp::Minus>(e);
 	}
 
-	template <size_t Ha, size_t Wa, size_t Hb, size_t Wb>
-	friend BitMatrix<Ha, Wa> operator||(BitMatrix<Ha, Wa> A, const BitMatrix<Hb, Wb> &B)
+	template <typename Op, typename... Args>
+	constexpr this_t &operator/=(const BitExpr<Op, Args...> &e)
 	{
-		return A.Xpq(B);
+		return combine<BitOp::OrNot>(e);
 	}
 
-	template <size_t Ha, size_t Wa, size_t Hb, size_t Wb>
-	friend BitMatrix<Ha, Wa> operator&&(BitMatrix<Ha, Wa> A, const BitMatrix<Hb, Wb> &B)
-	{
-		return A.Dpq(B);
-	}
-
-	template <size_t Ha, size_t Wa, size_t Hb, size_t Wb>
-	friend BitMatrix<Ha, Wa> operator==(BitMatrix<Ha, Wa> A, const BitMatrix<Hb, Wb> &B)
-	{
-		return A.Epq(B);
-	}
-
-	template <size_t Ha, size_t Wa, size_t Hb, size_t Wb>
-	friend BitMatrix<Ha, Wa> operator!=(BitMatrix<Ha, Wa> A, const BitMatrix<Hb, Wb> &B)
-	{
-		return A.Jpq(B);
-	}
-
-	bool any() const
+	constexpr bool any() const
 	{
 		for (size_t y = 0; y < H; ++y)
 			if (content[y].any())
@@ -382,7 +855,7 @@ public:
 		return false;
 	}
 
-	bool all() const
+	constexpr bool all() const
 	{
 		for (size_t y = 0; y < H; ++y)
 			if (!content[y].all())
@@ -390,7 +863,7 @@ public:
 		return true;
 	}
 
-	bool none() const
+	constexpr bool none() const
 	{
 		for (size_t y = 0; y < H; ++y)
 			if (!content[y].none())
@@ -398,78 +871,221 @@ public:
 		return true;
 	}
 
-	//	template <size_t Ha, size_t Wa>
-	//	friend std::ostream &operator<<(std::ostream &os, const BitMatrix<Ha, Wa> &A)
-	friend std::ostream &operator<<(std::ostream &os, const this_t &A)
+	//  COUNTS AND SEARCH
+
+	static constexpr size_t npos = H * W;
+
+	constexpr size_t count() const
 	{
+		size_t n = 0;
 		for (size_t y = 0; y < H; ++y)
-			os << A.content[y].to_string('.', '#') << " " << y << std::endl;
+			n += content[y].count();
+		return n;
+	}
 
-		for (size_t x = 0; x < W; ++x)
-			os << (x % 100) / 10;
-		os << std::endl;
-		for (size_t x = 0; x < W; ++x)
-			os << x % 10;
-		os << std::endl;
+	constexpr std::array<size_t, H> row_counts() const
+	{
+		std::array<size_t, H> n;
+		for (size_t y = 0; y < H; ++y)
+			n[y] = content[y].count();
+		return n;
+	}
 
-		os << "Any: " << A.any() << ", All: " << A.all() << ", None: " << A.none() << std::endl
-		   << std::endl;
+	// Columns are the rows of the transpose
+	constexpr std::array<size_t, W> col_counts() const
+	{
+		return transposed().row_counts();
+	}
 
-		return os;
+	// Position y * W + x of the first set pixel in raster order, npos if none
+	constexpr size_t find_first() const
+	{
+		for (size_t y = 0; y < H; ++y)
+			if (content[y].any())
+				return y * W + first_col(content[y]);
+		return npos;
 	}
 
-	constexpr this_t &dilate(char conn = '4', size_t num = 1)
+	// Position of the last set pixel in raster order, npos if none
+	constexpr size_t find_last() const
 	{
-		if (conn == '8' || conn == 'o' || conn == 'O')
-		{
-			for (; num > 0; --num)
-			{
-				for (size_t y = 0; y < H; ++y)
-				{
-					content[y] |= content[y] << 1 | content[y] >> 1;
-				}
+		for (size_t y = H; y-- > 0;)
+			if (content[y].any())
+				return y * W + last_col(content[y]);
+		return npos;
+	}
 
-				if constexpr (H == 1)
-				{
-				}
-				else
-				{
-					row_t prev = content[0];
-					content[0] |= content[1];
+	constexpr BitBox bounding_box() const
+	{
+		row_t u;
+		for (size_t y = 0; y < H; ++y)
+			u |= content[y];
+		if (u.none())
+			return {};
 
-					for (size_t y = 1; y < H - 1; ++y)
-					{
-						row_t temp = content[y];
-						content[y] |= content[y + 1] | prev;
-						prev = temp;
-					}
+		BitBox box;
+		box.y0 = find_first() / W;
+		box.y1 = find_last() / W + 1;
+		box.x0 = first_col(u);
+		box.x1 = last_col(u) + 1;
+		return box;
+	}
 
-					content[H - 1] |= prev;
-				}
+	// The 4 ('4'/'+') or 8 ('8'/'o') connected component holding pixel (y, x), empty if the pixel is not set.
+	// Grows the pixel by dilation constrained to the matrix until it stops changing.
+	constexpr this_t component(size_t y, size_t x, char conn = '4') const
+	{
+		this_t c;
+		if (test(y, x))
+			c.set(y, x);
+
+		for (;;)
+		{
+			this_t next = c.dilation(conn, 1) & *this;
+			if ((next != c).none())
+				return c;
+			c = next;
+		}
+	}
+
+	constexpr size_t components(char conn = '4') const
+	{
+		return label_runs<H, W, uint16_t>(nullptr, conn, true, [this](size_t y, size_t i)
+										  { return row_bits(content[y], i); });
+	}
+
+	// Writes 1..n to the pixels of each component in raster order of their first pixel, 0 elsewhere, returns n
+	template <typename L>
+	constexpr size_t label(Matrix<L, H, W> &labels, char conn = '4') const
+	{
+		return label_runs(&labels, conn, true, [this](size_t y, size_t i)
+						  { return row_bits(content[y], i); });
+	}
+
+	// Writes the rows as '.'/'#' with their index, column digits and any/all/none, one sink(line, len) call per line
+	template <typename Sink>
+	void dump(Sink &&sink) const
+	{
+		MatrixDump::bits<H, W>([this](size_t y, size_t x)
+							   { return test(y, x); },
+							   any(), all(), none(), sink);
+	}
+
+	// Same text into buf, returns the full length like snprintf
+	size_t dump(char *buf, size_t size) const
+	{
+		return MatrixDump::to_buffer(buf, size, [this](auto &&sink)
+									 { dump(sink); });
+	}
+
+#ifdef BITMATRIX_OSTREAM_ENABLE
+	friend std::ostream &operator<<(std::ostream &os, const this_t &A)
+	{
+		A.dump([&os](const char *line, size_t n)
+			   { os.write(line, n) << '\n'; });
+		return os;
+	}
+#endif
+
+	// Structuring element of radius num: the square for 8-connectivity ('8'/'o'), the diamond for 4 ('4'/'+').
+	// Outside the matrix counts as 0, so erosion clears the border.
+	constexpr this_t &dilate(char conn = '4', size_t num = 1)
+	{
+		return morph<BitOp::Or>(conn, num);
+	}
+	constexpr this_t &erode(char conn = '4', size_t num = 1)
+	{
+		return morph<BitOp::And>(conn, num);
+	}
+
+	constexpr this_t dilation(char conn = '4', size_t num = 1) const
+	{
+		this_t temp(*this);
+		temp.dilate(conn, num);
+		return temp;
+	}
+	constexpr this_t erosion(char conn = '4', size_t num = 1) const
+	{
+		this_t temp(*this);
+		temp.erode(conn, num);
+		return temp;
+	}
+
+	constexpr this_t &open(char conn = '4', size_t num = 1)
+	{
+		return erode(conn, num).dilate(conn, num);
+	}
+	constexpr this_t &close(char conn = '4', size_t num = 1)
+	{
+		return dilate(conn, num).erode(conn, num);
+	}
+
+	constexpr this_t opening(char conn = '4', size_t num = 1) const
+	{
+		this_t temp(*this);
+		temp.open(conn, num);
+		return temp;
+	}
+	constexpr this_t closing(char conn = '4', size_t num = 1) const
+	{
+		this_t temp(*this);
+		temp.close(conn, num);
+		return temp;
+	}
+
+	constexpr this_t gradient(char conn = '4', size_t num = 1) const
+	{
+		this_t temp = dilation(conn, num);
+		temp.Lpq(erosion(conn, num));
+		return temp;
+	}
+
+	// Rows become columns, e.g. grid-major to anode-major. Bit i of a row is column W - 1 - i,
+	// so counting rows from the bottom as well it is a plain transpose of B x B blocks of row bits.
+	constexpr BitMatrix<W, H> transposed() const
+	{
+		constexpr size_t B = transpose_block_size(std::min(H, W));
+		constexpr uint64_t BLOCK_MASK = B == 64 ? ~uint64_t(0) : (uint64_t(1) << B) - 1;
+		using trow_t = typename BitMatrix<W, H>::row_t;
+
+		BitMatrix<W, H> T;
+		for (size_t by = 0; by < H; by += B)
+			for (size_t bx = 0; bx < W; bx += B)
+			{
+				std::array<uint64_t, B> a = {};
+				for (size_t r = 0; r < B && by + r < H; ++r)
+					a[r] = row_bits(content[H - 1 - by - r], bx) & BLOCK_MASK;
+
+				transpose_bits(a);
+
+				for (size_t c = 0; c < B && bx + c < W; ++c)
+					T[W - 1 - bx - c] |= trow_t(a[c]) << by;
 			}
+		return T;
+	}
+
+	constexpr this_t &transpose()
+	{
+		static_assert(H == W, "Only a square matrix can be transposed in place!");
+		*this = transposed();
+		return *this;
+	}
+
+private:
+	template <typename Op>
+	constexpr this_t &morph(char conn, size_t num)
+	{
+		if (conn == '8' || conn == 'o' || conn == 'O')
+		{
+			// the square is separable, and beyond the matrix size the result no longer changes
+			stretch<Op>(std::min(num, W), false);
+			stretch<Op>(std::min(num, H), true);
 		}
 		else if (conn == '4' || conn == '+')
 		{
-			for (; num > 0; --num)
+			// the diamond is not, one cross per step until nothing changes (e.g. empty or full)
+			for (; num > 0 && cross<Op>(num > 1); --num)
 			{
-				if constexpr (H == 1)
-				{
-					content[0] |= content[0] << 1 | content[0] >> 1;
-				}
-				else
-				{
-					row_t prev = content[0];
-					content[0] |= content[0] << 1 | content[0] >> 1 | content[1];
-
-					for (size_t y = 1; y < H - 1; ++y)
-					{
-						row_t temp = content[y];
-						content[y] |= content[y] << 1 | content[y] >> 1 | content[y + 1] | prev;
-						prev = temp;
-					}
-
-					content[H - 1] |= content[H - 1] << 1 | content[H - 1] >> 1 | prev;
-				}
 			}
 		}
 		// else
@@ -477,81 +1093,252 @@ public:
 
 		return *this;
 	}
-	constexpr this_t &erode(char conn = '4', size_t num = 1)
+
+	// Radius covered after the next step from radius c towards r. Merging with the shifts by -s and +s grows [-c, c] to
+	// [-c - s, c + s], so r takes ceil(log2(r + 1)) steps instead of r. With s <= c + 1 every offset d is reached through
+	// offsets between 0 and d, so nothing is lost when the border clips the intermediate results.
+	static constexpr size_t stretch_step(size_t c, size_t r)
 	{
-		if (conn == '8' || conn == 'o' || conn == 'O')
+		return std::min(c + 1, r - c);
+	}
+
+	// Merges every row with itself shifted by -r..r columns, or with the rows -r..r away (outside counts as 0)
+	template <typename Op>
+	constexpr void stretch(size_t r, bool vertical)
+	{
+		for (size_t c = 0, s; c < r; c += s)
 		{
-			for (; num > 0; --num)
-			{
-				for (size_t y = 0; y < H; ++y)
-				{
-					content[y] &= content[y] << 1 & content[y] >> 1;
-				}
+			s = stretch_step(c, r);
+			if (vertical)
+				s == 1 ? merge_y1<Op>() : merge_y<Op>(s);
+			else
+				s == 1 ? merge_x<Op, 1>() : merge_x<Op>(s);
+		}
+	}
 
-				if constexpr (H == 1)
-				{
-					content[0].reset();
-				}
-				else
-				{
-					row_t prev = content[0];
-					content[0].reset();
+	// Every row with itself shifted by -s and +s columns, S fixes s at compile time for the constant shifts of a first step
+	template <typename Op, size_t S = 0>
+	constexpr void merge_x(size_t s = S)
+	{
+		if constexpr (S != 0)
+			s = S;
+		for (size_t y = 0; y < H; ++y)
+			content[y] = Op::apply(content[y], Op::apply(content[y] << s, content[y] >> s));
+	}
 
-					for (size_t y = 1; y < H - 1; ++y)
-					{
-						row_t temp = content[y];
-						content[y] &= content[y + 1] & prev;
-						prev = temp;
-					}
+	// Every row with the rows s above and below, in place: a pass down and a pass up that only read rows they have not written yet
+	template <typename Op>
+	constexpr void merge_y(size_t s)
+	{
+		for (size_t y = H; y-- > s;)
+			content[y] = Op::apply(content[y], content[y - s]);
+		for (size_t y = 0; y < s; ++y)
+			content[y] = Op::apply(content[y], row_t());
+		for (size_t y = 0; y + s < H; ++y)
+			content[y] = Op::apply(content[y], content[y + s]);
+		for (size_t y = H - s; y < H; ++y)
+			content[y] = Op::apply(content[y], row_t());
+	}
 
-					content[H - 1].reset();
-				}
-			}
+	// The same for s = 1 in one pass, keeping the previous row as it was in a register
+	template <typename Op>
+	constexpr void merge_y1()
+	{
+		row_t prev; // 0 above the first row
+		for (size_t y = 0; y < H; ++y)
+		{
+			const row_t cur = content[y];
+			content[y] = Op::apply(cur, Op::apply(prev, y + 1 < H ? content[y + 1] : row_t()));
+			prev = cur;
 		}
-		else if (conn == '4' || conn == '+')
+	}
+
+	// One step of the 4-connected cross in a single pass, keeping the previous row as it was.
+	// False if nothing changed, only looked at if more steps follow.
+	template <typename Op>
+	constexpr bool cross(bool more)
+	{
+		row_t prev; // 0 above the first row
+		row_t changed;
+		for (size_t y = 0; y < H; ++y)
 		{
-			for (; num > 0; --num)
-			{
-				if constexpr (H == 1)
-				{
-					content[0].reset();
-				}
-				else
-				{
-					row_t prev = content[0];
-					content[0].reset();
+			const row_t cur = content[y];
+			const row_t next = y + 1 < H ? content[y + 1] : row_t();
+			content[y] = Op::apply(Op::apply(cur, Op::apply(cur << 1, cur >> 1)), Op::apply(prev, next));
+			if (more)
+				changed |= content[y] ^ cur;
+			prev = cur;
+		}
+		return changed.any();
+	}
 
-					for (size_t y = 1; y < H - 1; ++y)
-					{
-						row_t temp = content[y];
-						content[y] &= content[y] << 1 & content[y] >> 1 & content[y + 1] & prev;
-						prev = temp;
-					}
+	// 64 bits of a row from bit i up
+	static constexpr uint64_t row_bits(const row_t &row, size_t i)
+	{
+		return row.extract(i);
+	}
 
-					content[H - 1].reset();
-				}
-			}
-		}
-		// else
-		// throw std::invalid_argument("Invalid connectivity/shape! Use 4/+ or 8/o");
+	// Leftmost set column (highest bit) of a non-empty row, a word at a time
+	static constexpr size_t first_col(const row_t &row)
+	{
+		for (size_t i = (W - 1) / 64 * 64;; i -= 64)
+			if (const uint64_t b = row_bits(row, i))
+				return W - 1 - (i + 63 - std::countl_zero(b));
+	}
+
+	// Rightmost set column (lowest bit) of a non-empty row
+	static constexpr size_t last_col(const row_t &row)
+	{
+		for (size_t i = 0;; i += 64)
+			if (const uint64_t b = row_bits(row, i))
+				return W - 1 - (i + std::countr_zero(b));
+	}
 
+	template <typename E>
+	constexpr this_t &assign(const E &e)
+	{
+		static_assert(std::is_same_v<typename E::matrix_t, this_t>, "Matrix sizes must match!");
+		for (size_t y = 0; y < H; ++y)
+			content[y] = e[y];
 		return *this;
 	}
 
-	constexpr this_t dilation(char conn = '4', size_t num = 1) const
+	template <typename Op, typename E>
+	constexpr this_t &combine(const E &e)
 	{
-		this_t temp(*this);
-		temp.dilate(conn, num);
-		return temp;
+		static_assert(std::is_same_v<typename E::matrix_t, this_t>, "Matrix sizes must match!");
+		for (size_t y = 0; y < H; ++y)
+			content[y] = Op::apply(content[y], e[y]);
+		return *this;
 	}
-	constexpr this_t erosion(char conn = '4', size_t num = 1) const
+};
+
+// Lazy BitMatrix operators. A | B does not compute anything, it returns a BitExpr that remembers the operation,
+// and the whole expression, e.g. (clock | symbols) - mask ^ blink, is evaluated row by row once it is assigned to a BitMatrix,
+// with no intermediate matrices. Row y of the result only reads row y of the operands, so A = (A | B) ^ C is safe.
+// Same operators and meanings as before: | & ^, - (A&~B), / (A|~B), || (NOR), && (NAND), == (XNOR), != (XOR), ! (NOT).
+// Named BitMatrix operands are held by reference, temporaries by value, so keep an expression with auto only as long as its operands live.
+template <typename T>
+struct bit_operand : std::false_type
+{
+};
+
+template <size_t H, size_t W>
+struct bit_operand<BitMatrix<H, W>> : std::true_type
+{
+	using matrix_t = BitMatrix<H, W>;
+	static constexpr size_t height = H;
+	static constexpr size_t width = W;
+};
+
+template <typename Op, typename... Args>
+struct bit_operand<BitExpr<Op, Args...>> : std::true_type
+{
+	using matrix_t = typename BitExpr<Op, Args...>::matrix_t;
+};
+
+template <typename T>
+inline constexpr bool is_bit_operand_v = bit_operand<std::decay_t<T>>::value;
+
+// How an operand is stored: named matrices by reference, temporaries and expressions by value
+template <typename T>
+using bit_arg_t = std::conditional_t<std::is_lvalue_reference_v<T> && std::is_same_v<std::decay_t<T>, typename bit_operand<std::decay_t<T>>::matrix_t>,
+									 const std::decay_t<T> &,
+									 std::decay_t<T>>;
+
+template <typename Op, typename... Args>
+class BitExpr
+{
+public:
+	using matrix_t = typename bit_operand<std::decay_t<std::tuple_element_t<0, std::tuple<Args...>>>>::matrix_t;
+	using row_t = typename matrix_t::row_t;
+	static constexpr size_t H = bit_operand<matrix_t>::height;
+	static constexpr size_t W = bit_operand<matrix_t>::width;
+
+	static_assert((std::is_same_v<typename bit_operand<std::decay_t<Args>>::matrix_t, matrix_t> && ...), "Matrix sizes must match!");
+
+private:
+	std::tuple<Args...> args;
+
+public:
+	template <typename... A>
+	constexpr explicit BitExpr(A &&...a) : args(std::forward<A>(a)...)
 	{
-		this_t temp(*this);
-		temp.erode(conn, num);
-		return temp;
+	}
+
+	// Row y of the result
+	constexpr row_t operator[](size_t y) const
+	{
+		return std::apply([y](const auto &...a)
+						  { return Op::apply(row_t(a[y])...); },
+						  args);
+	}
+
+	constexpr matrix_t eval() const
+	{
+		return matrix_t(*this);
+	}
+
+	constexpr bool test(size_t y, size_t x) const
+	{
+		return (*this)[y].test(W - x - 1);
+	}
+	constexpr bool operator()(size_t y, size_t x) const
+	{
+		return test(y, x);
+	}
+
+	constexpr bool any() const
+	{
+		for (size_t y = 0; y < H; ++y)
+			if ((*this)[y].any())
+				return true;
+		return false;
+	}
+	constexpr bool all() const
+	{
+		for (size_t y = 0; y < H; ++y)
+			if (!(*this)[y].all())
+				return false;
+		return true;
+	}
+	constexpr bool none() const
+	{
+		return !any();
 	}
 };
 
+template <typename Op, typename... T>
+constexpr BitExpr<Op, bit_arg_t<T &&>...> make_bit_expr(T &&...a)
+{
+	return BitExpr<Op, bit_arg_t<T &&>...>(std::forward<T>(a)...);
+}
+
+#define BITMATRIX_LAZY_OPERATOR(op, Op)                                                                      \
+	template <typename A, typename B, std::enable_if_t<is_bit_operand_v<A> && is_bit_operand_v<B>, bool> = true> \
+	constexpr auto operator op(A &&a, B &&b)                                                                     \
+	{                                                                                                            \
+		return make_bit_expr<BitOp::Op>(std::forward<A>(a), std::forward<B>(b));                                 \
+	}
+
+BITMATRIX_LAZY_OPERATOR(|, Or)
+BITMATRIX_LAZY_OPERATOR(&, And)
+BITMATRIX_LAZY_OPERATOR(^, Xor)
+BITMATRIX_LAZY_OPERATOR(-, Minus)
+BITMATRIX_LAZY_OPERATOR(/, OrNot)
+BITMATRIX_LAZY_OPERATOR(||, Nor)
+BITMATRIX_LAZY_OPERATOR(&&, Nand)
+BITMATRIX_LAZY_OPERATOR(==, Xnor)
+BITMATRIX_LAZY_OPERATOR(!=, Xor)
+
+#undef BITMATRIX_LAZY_OPERATOR
+
+template <typename A, std::enable_if_t<is_bit_operand_v<A>, bool> = true>
+constexpr auto operator!(A &&a)
+{
+	return make_bit_expr<BitOp::Not>(std::forward<A>(a));
+}
+
 //
 
 //
@@ -584,7 +1371,7 @@ public:
 
 public:
 	constexpr Matrix() : content({}) {}
-	~Matrix() {}
+	~Matrix() = default;
 
 	constexpr row_t &operator[](size_t pos)
 	{
@@ -600,7 +1387,7 @@ public:
 		return content[y][x];
 	}
 
-	T &operator()(size_t y, size_t x)
+	constexpr T &operator()(size_t y, size_t x)
 	{
 		return content[y][x];
 	}
@@ -610,77 +1397,71 @@ public:
 		return content[pos / W][pos % W];
 	}
 
-	T &operator()(size_t pos)
+	constexpr T &operator()(size_t pos)
 	{
 		return content[pos / W][pos % W];
 	}
 
-	T &first()
+	constexpr T &first()
 	{
 		return content[0][0];
 	}
 
-	template <typename Ta, size_t Ha, size_t Wa>
-	friend BitMatrix<Ha, Wa> operator==(const Matrix<Ta, Ha, Wa> &A, Ta c)
+	friend constexpr this_bool_t operator==(const this_t &A, T c)
 	{
-		BitMatrix<Ha, Wa> temp;
+		this_bool_t temp;
 		for (size_t y = 0; y < H; ++y)
 			for (size_t x = 0; x < W; ++x)
 				temp(y, x) = A.content[y][x] == c;
 		return temp;
 	}
 
-	template <typename Ta, size_t Ha, size_t Wa>
-	friend BitMatrix<Ha, Wa> operator!=(const Matrix<Ta, Ha, Wa> &A, Ta c)
+	friend constexpr this_bool_t operator!=(const this_t &A, T c)
 	{
-		BitMatrix<Ha, Wa> temp;
+		this_bool_t temp;
 		for (size_t y = 0; y < H; ++y)
 			for (size_t x = 0; x < W; ++x)
 				temp(y, x) = A.content[y][x] != c;
 		return temp;
 	}
 
-	template <typename Ta, size_t Ha, size_t Wa>
-	friend BitMatrix<Ha, Wa> operator<=(const Matrix<Ta, Ha, Wa> &A, Ta c)
+	friend constexpr this_bool_t operator<=(const this_t &A, T c)
 	{
-		BitMatrix<Ha, Wa> temp;
+		this_bool_t temp;
 		for (size_t y = 0; y < H; ++y)
 			for (size_t x = 0; x < W; ++x)
 				temp(y, x) = A.content[y][x] <= c;
 		return temp;
 	}
 
-	template <typename Ta, size_t Ha, size_t Wa>
-	friend BitMatrix<Ha, Wa> operator>=(const Matrix<Ta, Ha, Wa> &A, Ta c)
+	friend constexpr this_bool_t operator>=(const this_t &A, T c)
 	{
-		BitMatrix<Ha, Wa> temp;
+		this_bool_t temp;
 		for (size_t y = 0; y < H; ++y)
 			for (size_t x = 0; x < W; ++x)
 				temp(y, x) = A.content[y][x] >= c;
 		return temp;
 	}
 
-	template <typename Ta, size_t Ha, size_t Wa>
-	friend BitMatrix<Ha, Wa> operator<(const Matrix<Ta, Ha, Wa> &A, Ta c)
+	friend constexpr this_bool_t operator<(const this_t &A, T c)
 	{
-		BitMatrix<Ha, Wa> temp;
+		this_bool_t temp;
 		for (size_t y = 0; y < H; ++y)
 			for (size_t x = 0; x < W; ++x)
 				temp(y, x) = A.content[y][x] < c;
 		return temp;
 	}
 
-	template <typename Ta, size_t Ha, size_t Wa>
-	friend BitMatrix<Ha, Wa> operator>(const Matrix<Ta, Ha, Wa> &A, Ta c)
+	friend constexpr this_bool_t operator>(const this_t &A, T c)
 	{
-		BitMatrix<Ha, Wa> temp;
+		this_bool_t temp;
 		for (size_t y = 0; y < H; ++y)
 			for (size_t x = 0; x < W; ++x)
 				temp(y, x) = A.content[y][x] > c;
 		return temp;
 	}
 
-	bool any() const
+	constexpr bool any() const
 	{
 		for (size_t y = 0; y < H; ++y)
 			for (size_t x = 0; x < W; ++x)
@@ -688,7 +1469,7 @@ public:
 					return true;
 		return false;
 	}
-	bool all() const
+	constexpr bool all() const
 	{
 		for (size_t y = 0; y < H; ++y)
 			for (size_t x = 0; x < W; ++x)
@@ -696,7 +1477,7 @@ public:
 					return false;
 		return true;
 	}
-	bool none() const
+	constexpr bool none() const
 	{
 		for (size_t y = 0; y < H; ++y)
 			for (size_t x = 0; x < W; ++x)
@@ -705,59 +1486,226 @@ public:
 		return true;
 	}
 
-	const_iterator min_element() const
+	// Row by row rather than one pointer run over the rows, which a constant expression does not allow
+	constexpr const_iterator min_element() const
 	{
-		return std::min_element(begin(), end());
+		return extreme_element([](const T &a, const T &b)
+							   { return a < b; });
 	}
-	const_iterator max_element() const
+	constexpr const_iterator max_element() const
 	{
-		return std::max_element(begin(), end());
+		return extreme_element([](const T &a, const T &b)
+							   { return b < a; });
 	}
 
-	T min() const
+	constexpr T min() const
 	{
 		return *min_element();
 	}
-	T max() const
+	constexpr T max() const
 	{
 		return *max_element();
 	}
 
-	sum_t sum() const
+	constexpr sum_t sum() const
 	{
 		sum_t sum = 0;
-		for (auto it = begin(); it != end(); ++it)
-			sum += *it;
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				sum += content[y][x];
 		return sum;
 	}
-	T avg() const
+	constexpr T avg() const
 	{
 		return sum() / (W * H);
 	}
 
-	std::pair<crd_t, crd_t> ind2sub(const_iterator it) const
+	// Bit-plane b holds bit b of every element, what BCM multiplexing shows for 2^b time slots.
+	// Eight pixels are loaded as one word and bit-transposed, so a plane byte costs a few word operations instead of 8 tests.
+	template <size_t N = 8>
+	constexpr std::array<this_bool_t, N> bitplanes() const
+	{
+		static_assert(std::is_same_v<T, uint8_t>, "Bit-planes need uint8_t elements!");
+		static_assert(N >= 1 && N <= 8, "uint8_t has 8 bit-planes!");
+
+		constexpr size_t G = (W + 7) / 8; // groups of 8 pixels, aligned to the right end, the first one zero padded
+		std::array<this_bool_t, N> planes;
+
+		for (size_t y = 0; y < H; ++y)
+		{
+			std::array<typename this_bool_t::row_t, N> rows = {};
+			std::array<uint64_t, N> acc = {};
+
+			for (size_t g = 0; g < G; ++g)
+			{
+				const uint64_t x = transpose8(load8(content[y], ptrdiff_t(W) - ptrdiff_t(8 * (G - g))));
+				for (size_t b = 0; b < N; ++b)
+					acc[b] = acc[b] << 8 | (x >> (8 * b) & 0xFF);
+
+				if ((G - g - 1) % 8 == 0) // 64 pixels gathered, or the row ended
+				{
+					for (size_t b = 0; b < N; ++b)
+					{
+						if constexpr (W <= 64)
+							rows[b] = typename this_bool_t::row_t(acc[b]);
+						else
+							rows[b] = rows[b] << 64 | typename this_bool_t::row_t(acc[b]);
+						acc[b] = 0;
+					}
+				}
+			}
+
+			for (size_t b = 0; b < N; ++b)
+				planes[b][y] = rows[b];
+		}
+
+		return planes;
+	}
+
+	// Inverse of bitplanes(), bits above N are cleared
+	template <size_t N>
+	constexpr this_t &from_bitplanes(const std::array<this_bool_t, N> &planes)
+	{
+		static_assert(std::is_same_v<T, uint8_t>, "Bit-planes need uint8_t elements!");
+		static_assert(N >= 1 && N <= 8, "uint8_t has 8 bit-planes!");
+
+		constexpr size_t G = (W + 7) / 8;
+
+		for (size_t y = 0; y < H; ++y)
+		{
+			std::array<uint64_t, N> acc = {};
+
+			for (size_t k = 0; k < G; ++k) // from the right end
+			{
+				if (k % 8 == 0) // next 64 pixels
+				{
+					for (size_t b = 0; b < N; ++b)
+					{
+						if constexpr (W <= 64)
+							acc[b] = planes[b][y].to_ullong();
+						else
+							acc[b] = (planes[b][y] >> (8 * k) & typename this_bool_t::row_t(~0ULL)).to_ullong();
+					}
+				}
+
+				uint64_t x = 0;
+				for (size_t b = 0; b < N; ++b)
+					x |= (acc[b] >> (8 * (k % 8)) & 0xFF) << (8 * b);
+
+				store8(content[y], ptrdiff_t(W) - ptrdiff_t(8 * (k + 1)), transpose8(x));
+			}
+		}
+
+		return *this;
+	}
+
+	constexpr std::pair<crd_t, crd_t> ind2sub(const_iterator it) const
 	{
 		// size_t pos = &(*it) - &(*begin());
 		size_t pos = it - begin();
 		return {pos / W, pos % W};
 	}
 
-	//	template <typename Ta, size_t Ha, size_t Wa>
-	//	friend std::ostream &operator<<(std::ostream &os, const Matrix<Ta, Ha, Wa> &A)
-	friend std::ostream &operator<<(std::ostream &os, const this_t &A)
+	// Writes the values tab-separated, one row per line, then the size and any/all/none, one sink(line, len) call per line
+	template <typename Sink>
+	void dump(Sink &&sink) const
 	{
+		static_assert(std::is_arithmetic_v<T>, "dump() prints numbers only!");
+
+		char line[W * 24 + 1];
 		for (size_t y = 0; y < H; ++y)
 		{
+			size_t n = 0;
 			for (size_t x = 0; x < W; ++x)
-				os << +A.content[y][x] << '\t';
-			os << std::endl;
+			{
+				const T v = content[y][x];
+				if constexpr (std::is_floating_point_v<T>)
+					n += std::snprintf(line + n, sizeof(line) - n, "%g\t", double(v));
+				else if constexpr (std::is_signed_v<T>)
+					n += std::snprintf(line + n, sizeof(line) - n, "%lld\t", (long long)v);
+				else
+					n += std::snprintf(line + n, sizeof(line) - n, "%llu\t", (unsigned long long)v);
+			}
+			sink(static_cast<const char *>(line), n);
 		}
-		os << H << "x" << W << ", Any: " << A.any() << ", All: " << A.all() << ", None: " << A.none() << std::endl
-		   << std::endl;
 
+		const int n = std::snprintf(line, sizeof(line), "%ux%u, Any: %d, All: %d, None: %d", unsigned(H), unsigned(W), any(), all(), none());
+		sink(static_cast<const char *>(line), std::min<size_t>(n, sizeof(line) - 1));
+		sink("", 0);
+	}
+
+	// Same text into buf, returns the full length like snprintf
+	size_t dump(char *buf, size_t size) const
+	{
+		return MatrixDump::to_buffer(buf, size, [this](auto &&sink)
+									 { dump(sink); });
+	}
+
+#ifdef BITMATRIX_OSTREAM_ENABLE
+	friend std::ostream &operator<<(std::ostream &os, const this_t &A)
+	{
+		A.dump([&os](const char *line, size_t n)
+			   { os.write(line, n) << '\n'; });
 		return os;
 	}
+#endif
+
+private:
+	// First element for which no other one goes before it
+	template <typename Before>
+	constexpr const_iterator extreme_element(Before before) const
+	{
+		size_t by = 0, bx = 0;
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				if (before(content[y][x], content[by][bx]))
+				{
+					by = y;
+					bx = x;
+				}
+		return const_iterator(&content[by][bx]);
+	}
+
+	// Transposes the 8x8 bit matrix whose row r is byte r (Hacker's Delight 7-3), its own inverse
+	static constexpr uint64_t transpose8(uint64_t x)
+	{
+		uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+		x ^= t ^ (t << 7);
+		t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+		x ^= t ^ (t << 14);
+		t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+		x ^= t ^ (t << 28);
+		return x;
+	}
+
+	// Pixels x0..x0+7 of a row, x0 in the top byte, so byte r is pixel x0+7-r; pixels left of the row read 0
+	static constexpr uint64_t load8(const row_t &row, ptrdiff_t x0)
+	{
+		uint64_t x = 0;
+		if (x0 >= 0 && !std::is_constant_evaluated())
+		{
+			std::memcpy(&x, &row[x0], 8);
+			return __builtin_bswap64(x);
+		}
+		for (ptrdiff_t i = x0; i < x0 + 8; ++i)
+			x = x << 8 | (i >= 0 ? row[i] : 0);
+		return x;
+	}
+
+	static constexpr void store8(row_t &row, ptrdiff_t x0, uint64_t x)
+	{
+		if (x0 >= 0 && !std::is_constant_evaluated())
+		{
+			x = __builtin_bswap64(x);
+			std::memcpy(&row[x0], &x, 8);
+			return;
+		}
+		for (ptrdiff_t i = x0 + 7; i >= x0; --i, x >>= 8)
+			if (i >= 0)
+				row[i] = x & 0xFF;
+	}
 
+public:
 	// ITERATORS, DONT INTERVENE
 
 	typedef size_t size_type;
@@ -771,36 +1719,36 @@ public:
 		typedef T *pointer;
 		typedef std::forward_iterator_tag iterator_category;
 		typedef std::ptrdiff_t difference_type;
-		iterator(pointer ptr) : ptr_(ptr) {}
-		reference operator*() { return *ptr_; }
-		pointer operator->() { return ptr_; }
-		bool operator==(const self_type &rhs) { return ptr_ == rhs.ptr_; }
-		bool operator!=(const self_type &rhs) { return ptr_ != rhs.ptr_; }
-		self_type operator++()
+		constexpr iterator(pointer ptr) : ptr_(ptr) {}
+		constexpr reference operator*() { return *ptr_; }
+		constexpr pointer operator->() { return ptr_; }
+		constexpr bool operator==(const self_type &rhs) { return ptr_ == rhs.ptr_; }
+		constexpr bool operator!=(const self_type &rhs) { return ptr_ != rhs.ptr_; }
+		constexpr self_type operator++()
 		{
 			++ptr_;
 			return *this;
 		}
-		self_type operator++(int post)
+		constexpr self_type operator++(int post)
 		{
 			self_type i = *this;
 			++ptr_;
 			return i;
 		}
-		self_type operator--()
+		constexpr self_type operator--()
 		{
 			--ptr_;
 			return *this;
 		}
-		self_type operator--(int post)
+		constexpr self_type operator--(int post)
 		{
 			self_type i = *this;
 			--ptr_;
 			return i;
 		}
-		self_type operator+(const difference_type &dif) { return ptr_ + dif; }
-		self_type operator-(const difference_type &dif) { return ptr_ - dif; }
-		difference_type operator-(const self_type &rhs) { return std::distance(rhs.ptr_, ptr_); }
+		constexpr self_type operator+(const difference_type &dif) { return ptr_ + dif; }
+		constexpr self_type operator-(const difference_type &dif) { return ptr_ - dif; }
+		constexpr difference_type operator-(const self_type &rhs) { return std::distance(rhs.ptr_, ptr_); }
 
 	private:
 		pointer ptr_;
@@ -815,60 +1763,201 @@ public:
 		typedef const T *pointer;
 		typedef std::ptrdiff_t difference_type;
 		typedef std::forward_iterator_tag iterator_category;
-		const_iterator(pointer ptr) : ptr_(ptr) {}
-		reference operator*() { return *ptr_; }
-		pointer operator->() { return ptr_; }
-		bool operator==(const self_type &rhs) { return ptr_ == rhs.ptr_; }
-		bool operator!=(const self_type &rhs) { return ptr_ != rhs.ptr_; }
-		self_type operator++()
+		constexpr const_iterator(pointer ptr) : ptr_(ptr) {}
+		constexpr reference operator*() { return *ptr_; }
+		constexpr pointer operator->() { return ptr_; }
+		constexpr bool operator==(const self_type &rhs) { return ptr_ == rhs.ptr_; }
+		constexpr bool operator!=(const self_type &rhs) { return ptr_ != rhs.ptr_; }
+		constexpr self_type operator++()
 		{
 			++ptr_;
 			return *this;
 		}
-		self_type operator++(int post)
+		constexpr self_type operator++(int post)
 		{
 			self_type i = *this;
 			++ptr_;
 			return i;
 		}
-		self_type operator--()
+		constexpr self_type operator--()
 		{
 			--ptr_;
 			return *this;
 		}
-		self_type operator--(int post)
+		constexpr self_type operator--(int post)
 		{
 			self_type i = *this;
 			--ptr_;
 			return i;
 		}
-		self_type operator+(const difference_type &dif) { return ptr_ + dif; }
-		self_type operator-(const difference_type &dif) { return ptr_ - dif; }
-		difference_type operator-(const self_type &rhs) { return std::distance(rhs.ptr_, ptr_); }
+		constexpr self_type operator+(const difference_type &dif) { return ptr_ + dif; }
+		constexpr self_type operator-(const difference_type &dif) { return ptr_ - dif; }
+		constexpr difference_type operator-(const self_type &rhs) { return std::distance(rhs.ptr_, ptr_); }
 
 	private:
 		pointer ptr_;
 	};
 
-	iterator begin()
+	constexpr iterator begin()
 	{
 		return iterator(&content[0][0]);
 	}
 
-	iterator end()
+	constexpr iterator end()
 	{
 		return iterator(&content[H - 1][W - 1] + 1);
 	}
 
-	const_iterator begin() const
+	constexpr const_iterator begin() const
 	{
 		return const_iterator(&content[0][0]);
 	}
 
-	const_iterator end() const
+	constexpr const_iterator end() const
 	{
 		return const_iterator(&content[H - 1][W - 1] + 1);
 	}
 };
 
-// common_type_t<int, float> xd = 5.0;
\ No newline at end of file
+// Run-based connected component labelling for BitMatrix and PackedBitMatrix. row_bits(y, i) gives bits i..i+63 of row y,
+// mirrored when bit i is column W - 1 - i. Runs of set bits come out of the words with ctz and countr_one,
+// each run is joined (union-find, smaller label wins) with the runs of the previous row it touches (4: overlaps, 8: also diagonally),
+// and a second pass numbers the components in raster order of their first pixel. Needs about 2 * H * W bytes of stack.
+template <size_t H, size_t W, typename L, typename RowBits>
+constexpr size_t label_runs(Matrix<L, H, W> *labels, char conn, bool mirrored, RowBits row_bits)
+{
+	constexpr size_t ROW_RUNS = (W + 1) / 2;
+	constexpr size_t RUNS = H * ROW_RUNS;
+	static_assert(RUNS < 0x8000, "Matrix too large to label!");
+	constexpr uint16_t NUMBERED = 0x8000; // parent of a root once it has its final number
+
+	struct Run
+	{
+		uint16_t begin, end; // bits, end exclusive
+	};
+
+	// runs of row y, in bit order
+	const auto row_runs = [&](size_t y, std::array<Run, ROW_RUNS> &runs)
+	{
+		size_t n = 0;
+		size_t begin = 0;
+		bool in_run = false;
+		for (size_t i = 0; i < W; i += 64)
+		{
+			const uint64_t w = row_bits(y, i);
+			for (size_t b = 0; b < 64;)
+			{
+				const uint64_t rest = w >> b;
+				if (!in_run)
+				{
+					if (!rest)
+						break;
+					b += std::countr_zero(rest);
+					begin = i + b;
+					in_run = true;
+				}
+				else
+				{
+					b += std::countr_one(rest);
+					if (b >= 64) // goes on in the next word
+						break;
+					runs[n++] = {uint16_t(begin), uint16_t(i + b)};
+					in_run = false;
+				}
+			}
+		}
+		if (in_run)
+			runs[n++] = {uint16_t(begin), uint16_t(W)};
+		return n;
+	};
+
+	std::array<uint16_t, RUNS + 1> parent; // provisional labels, 0 unused
+	std::array<uint16_t, RUNS> run_label = {};
+
+	const auto find = [&](uint16_t a)
+	{
+		while (parent[a] != a)
+			a = parent[a] = parent[parent[a]];
+		return a;
+	};
+
+	const size_t touch = conn == '8' || conn == 'o' || conn == 'O' ? 1 : 0;
+
+	std::array<Run, ROW_RUNS> prev, cur;
+	size_t n_prev = 0;
+	size_t n_labels = 0;
+	size_t k = 0;
+
+	for (size_t y = 0; y < H; ++y)
+	{
+		const size_t n_cur = row_runs(y, cur);
+		const size_t k0 = k;
+
+		for (size_t r = 0, j = 0; r < n_cur; ++r, ++k)
+		{
+			const Run &c = cur[r];
+			while (j < n_prev && prev[j].end + touch <= c.begin) // behind this and every later run
+				++j;
+
+			uint16_t label = 0;
+			for (size_t q = j; q < n_prev && prev[q].begin < c.end + touch; ++q)
+			{
+				const uint16_t other = find(run_label[k0 - n_prev + q]);
+				if (!label)
+					label = other;
+				else if (other != label)
+				{
+					const uint16_t lo = std::min(label, other);
+					parent[std::max(label, other)] = lo;
+					label = lo;
+				}
+			}
+
+			if (!label)
+			{
+				label = ++n_labels;
+				parent[label] = label;
+			}
+			run_label[k] = label;
+		}
+
+		prev = cur;
+		n_prev = n_cur;
+	}
+
+	// links always point to a smaller label, so one upward sweep points every label at its root
+	for (size_t l = 1; l <= n_labels; ++l)
+		parent[l] = parent[parent[l]];
+
+	if (labels)
+		*labels = Matrix<L, H, W>();
+
+	// number the roots in raster order, runs of a mirrored row are visited back to front
+	size_t n = 0;
+	k = 0;
+	for (size_t y = 0; y < H; ++y)
+	{
+		const size_t n_cur = row_runs(y, cur);
+		for (size_t r = 0; r < n_cur; ++r)
+		{
+			const size_t idx = mirrored ? k + n_cur - 1 - r : k + r;
+			const Run &c = cur[mirrored ? n_cur - 1 - r : r];
+
+			const uint16_t label = run_label[idx];
+			const uint16_t root = parent[label] & NUMBERED ? label : parent[label]; // a numbered root no longer points at itself
+			if (!(parent[root] & NUMBERED))
+				parent[root] = NUMBERED | ++n;
+			if (!labels)
+				continue;
+
+			const L value = parent[root] & ~NUMBERED;
+			const size_t x0 = mirrored ? W - c.end : c.begin;
+			const size_t x1 = mirrored ? W - c.begin : c.end;
+			for (size_t x = x0; x < x1; ++x)
+				(*labels)(y, x) = value;
+		}
+		k += n_cur;
+	}
+
+	return n;
+}
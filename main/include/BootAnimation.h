@@ -0,0 +1,15 @@
+// Generated by tools/anim_encode.cpp, do not edit
+
+static const uint8_t boot_animation[168] = {
+	0x56, 0x41, 0x01, 0x10, 0x29, 0x00, 0x28, 0x00, 0x40, 0x01, 0x00, 0xFF, 0xFF, 0x40, 0x02, 0x00,
+	0xFF, 0xFF, 0x40, 0x04, 0x00, 0xFF, 0xFF, 0x40, 0x08, 0x00, 0xFF, 0xFF, 0x40, 0x10, 0x00, 0xFF,
+	0xFF, 0x40, 0x20, 0x00, 0xFF, 0xFF, 0x40, 0x40, 0x00, 0xFF, 0xFF, 0x40, 0x80, 0x00, 0xFF, 0xFF,
+	0x40, 0x00, 0x01, 0xFF, 0xFF, 0x40, 0x00, 0x02, 0xFF, 0xFF, 0x40, 0x00, 0x04, 0xFF, 0xFF, 0x40,
+	0x00, 0x08, 0xFF, 0xFF, 0x40, 0x00, 0x10, 0xFF, 0xFF, 0x40, 0x00, 0x20, 0xFF, 0xFF, 0x40, 0x00,
+	0x40, 0xFF, 0xFF, 0x49, 0x00, 0x80, 0xFF, 0xFF, 0x40, 0x01, 0x00, 0xFF, 0xFF, 0x40, 0x02, 0x00,
+	0xFF, 0xFF, 0x40, 0x04, 0x00, 0xFF, 0xFF, 0x40, 0x08, 0x00, 0xFF, 0xFF, 0x40, 0x10, 0x00, 0xFF,
+	0xFF, 0x40, 0x20, 0x00, 0xFF, 0xFF, 0x40, 0x40, 0x00, 0xFF, 0xFF, 0x40, 0x80, 0x00, 0xFF, 0xFF,
+	0x40, 0x00, 0x01, 0xFF, 0xFF, 0x40, 0x00, 0x02, 0xFF, 0xFF, 0x40, 0x00, 0x04, 0xFF, 0xFF, 0x40,
+	0x00, 0x08, 0xFF, 0xFF, 0x40, 0x00, 0x10, 0xFF, 0xFF, 0x40, 0x00, 0x20, 0xFF, 0xFF, 0x40, 0x00,
+	0x40, 0xFF, 0xFF, 0x40, 0x00, 0x80, 0xFF, 0xFF,
+};
@@ -0,0 +1,274 @@
+#ifndef DataFlow_H
+#define DataFlow_H
+
+#include <cstdint>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <initializer_list>
+#include <algorithm>
+
+#include <esp_cpu.h>
+
+#include "FunctionChain.h"
+
+// Argument and return types of a callable with any number of arguments (function_traits only handles one)
+template <typename T>
+struct callable_traits : callable_traits<decltype(&T::operator())>
+{
+};
+
+template <typename Out, typename... In>
+struct callable_traits<Out (*)(In...)>
+{
+	using Args = std::tuple<std::decay_t<In>...>;
+	using ReturnType = std::decay_t<Out>;
+};
+
+template <typename Out, typename ClassType, typename... In>
+struct callable_traits<Out (ClassType::*)(In...)> : callable_traits<Out (*)(In...)>
+{
+};
+
+template <typename Out, typename ClassType, typename... In>
+struct callable_traits<Out (ClassType::*)(In...) const> : callable_traits<Out (*)(In...)>
+{
+};
+
+// Small DAG of derived values, one sample fans out to every consumer through shared intermediates.
+// Sources are set from outside, nodes are callables over earlier nodes, so insertion order is a topological order
+// and cycles cannot be built. evaluate() walks the nodes once and re-runs a node only if one of its inputs changed
+// in this pass, and a node whose result compares equal stops the propagation there.
+// Stateful callables (filters) therefore only step when their inputs change.
+// Values are VALUE (a TaggedValue), callables are stored in place like in StaticFunctionManager, nothing allocates.
+template <typename VALUE = TaggedValue<bool, int32_t, float>, size_t MAX_NODES = 16, size_t MAX_INPUTS = 4, size_t BUF = 16>
+class DataFlow
+{
+public:
+	using NodeId = uint8_t;
+	static constexpr NodeId INVALID = 0xFF;
+
+	static_assert(MAX_NODES < INVALID);
+
+private:
+	struct Node
+	{
+		alignas(std::max_align_t) std::byte buf[BUF];
+		VALUE (*invoke)(void *, const VALUE *const *); // nullptr for sources
+		void (*destroy)(void *);
+
+		std::array<NodeId, MAX_INPUTS> inputs;
+		uint8_t n_inputs;
+
+		VALUE value;
+		uint8_t type; // VALUE tag, fixed when added
+		bool dirty;	  // set since the last pass (source), never evaluated (node)
+		bool changed; // value changed in the last pass
+
+		uint32_t evals;		  // total evaluations
+		uint64_t cost_cycles; // total evaluation time
+	};
+
+	std::array<Node, MAX_NODES> nodes;
+	size_t count = 0;
+
+	uint32_t pass_evals = 0;
+	uint32_t pass_cycles = 0;
+
+public:
+	DataFlow() = default;
+	DataFlow(const DataFlow &) = delete;
+	DataFlow &operator=(const DataFlow &) = delete;
+	~DataFlow()
+	{
+		while (count)
+		{
+			Node &n = nodes[--count];
+			if (n.invoke)
+				n.destroy(n.buf);
+		}
+	}
+
+	// The initial value also fixes the type of the source
+	NodeId add_source(VALUE initial)
+	{
+		if (count >= MAX_NODES)
+			return INVALID;
+
+		Node &n = nodes[count];
+		n.invoke = nullptr;
+		n.destroy = nullptr;
+		n.n_inputs = 0;
+		n.value = initial;
+		n.type = initial.type();
+		n.dirty = true;
+		n.changed = false;
+		n.evals = 0;
+		n.cost_cycles = 0;
+
+		return count++;
+	}
+
+	// f is called with the values of the inputs, in order, as its argument types.
+	// Returns INVALID if full or if the inputs do not exist yet or do not match the argument types.
+	template <typename F>
+	NodeId add_node(std::initializer_list<NodeId> inputs, F f)
+	{
+		using Fn = std::decay_t<F>;
+		using Args = typename callable_traits<Fn>::Args;
+		using Out = typename callable_traits<Fn>::ReturnType;
+		constexpr size_t N = std::tuple_size_v<Args>;
+
+		static_assert(N > 0 && N <= MAX_INPUTS, "Wrong number of node inputs!");
+		static_assert(sizeof(Fn) <= BUF && alignof(Fn) <= alignof(std::max_align_t), "Callable too large for the inline buffer!");
+		static_assert(VALUE::template supports<Out>, "Node type not in the TaggedValue!");
+
+		if (count >= MAX_NODES || inputs.size() != N)
+			return INVALID;
+		if (!inputs_match<Args>(inputs.begin(), std::make_index_sequence<N>()))
+			return INVALID;
+
+		Node &n = nodes[count];
+		new (n.buf) Fn(std::move(f));
+		n.invoke = [](void *p, const VALUE *const *in) -> VALUE
+		{
+			return call<Fn, Out, Args>(*std::launder(reinterpret_cast<Fn *>(p)), in, std::make_index_sequence<N>());
+		};
+		n.destroy = [](void *p)
+		{
+			std::launder(reinterpret_cast<Fn *>(p))->~Fn();
+		};
+		n.n_inputs = N;
+		std::copy(inputs.begin(), inputs.end(), n.inputs.begin());
+		n.value = VALUE();
+		n.type = VALUE::template tag_of<Out>();
+		n.dirty = true;
+		n.changed = false;
+		n.evals = 0;
+		n.cost_cycles = 0;
+
+		return count++;
+	}
+
+	// Type must stay the one given to add_source()
+	void set(NodeId id, VALUE v)
+	{
+		Node &n = nodes[id];
+		assert(!n.invoke && v.type() == n.type);
+
+		if (!(v == n.value))
+		{
+			n.value = v;
+			n.dirty = true;
+		}
+	}
+
+	// Propagates the sources set since the last call, in topological order
+	void evaluate()
+	{
+		const esp_cpu_cycle_count_t t_pass = esp_cpu_get_cycle_count();
+		pass_evals = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			Node &n = nodes[i];
+
+			if (!n.invoke)
+			{
+				n.changed = n.dirty;
+				n.dirty = false;
+				continue;
+			}
+
+			const VALUE *in[MAX_INPUTS];
+			bool stale = n.dirty;
+			for (size_t k = 0; k < n.n_inputs; ++k)
+			{
+				const Node &src = nodes[n.inputs[k]];
+				stale |= src.changed;
+				in[k] = &src.value;
+			}
+
+			n.changed = false;
+			n.dirty = false;
+			if (!stale)
+				continue;
+
+			const esp_cpu_cycle_count_t t_node = esp_cpu_get_cycle_count();
+			const VALUE v = n.invoke(n.buf, in);
+			n.cost_cycles += esp_cpu_cycle_count_t(esp_cpu_get_cycle_count() - t_node);
+			++n.evals;
+			++pass_evals;
+
+			if (!(v == n.value))
+			{
+				n.value = v;
+				n.changed = true;
+			}
+		}
+
+		pass_cycles = esp_cpu_get_cycle_count() - t_pass;
+	}
+
+	template <typename T>
+	T get(NodeId id) const
+	{
+		return nodes[id].value.template get<T>();
+	}
+
+	// Whether the value changed in the last evaluate()
+	bool changed(NodeId id) const
+	{
+		return nodes[id].changed;
+	}
+
+	//  METRICS
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	uint32_t evals(NodeId id) const
+	{
+		return nodes[id].evals;
+	}
+
+	// Total time spent in the node, CPU cycles. Most nodes take well under a microsecond, too short for esp_timer.
+	// The counter is per core and wraps after ~18 s at 240 MHz, which only matters for a single evaluation.
+	uint64_t cost(NodeId id) const
+	{
+		return nodes[id].cost_cycles;
+	}
+
+	// Nodes evaluated by the last evaluate()
+	uint32_t last_evals() const
+	{
+		return pass_evals;
+	}
+
+	// Duration of the last evaluate(), CPU cycles
+	uint32_t last_cost() const
+	{
+		return pass_cycles;
+	}
+
+private:
+	template <typename Args, size_t... I>
+	bool inputs_match(const NodeId *in, std::index_sequence<I...>) const
+	{
+		static_assert((VALUE::template supports<std::tuple_element_t<I, Args>> && ...), "Node input type not in the TaggedValue!");
+		return ((in[I] < count && nodes[in[I]].type == VALUE::template tag_of<std::tuple_element_t<I, Args>>()) && ...);
+	}
+
+	template <typename Fn, typename Out, typename Args, size_t... I>
+	static VALUE call(Fn &f, const VALUE *const *in, std::index_sequence<I...>)
+	{
+		return VALUE(static_cast<Out>(f(in[I]->template get<std::tuple_element_t<I, Args>>()...)));
+	}
+};
+
+#endif
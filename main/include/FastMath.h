@@ -0,0 +1,55 @@
+#ifndef FastMath_H
+#define FastMath_H
+
+#include <cstdint>
+#include <bit>
+
+// Single precision log/exp replacements with a fixed op count and no branches on the value.
+// Coefficients are least-squares fits on Chebyshev nodes, error bounds measured over the full interval.
+// Valid for finite, normal, positive arguments only (no NaN/inf/denormal handling).
+
+namespace FastMath
+{
+	// |error| <= 2.1e-5 (absolute), 5 mul + 5 add
+	inline float log2(float x)
+	{
+		const uint32_t bits = std::bit_cast<uint32_t>(x);
+		const float e = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+		const float t = std::bit_cast<float>((bits & 0x007FFFFFu) | 0x3F800000u) - 1.0f; // mantissa - 1, [0, 1)
+
+		const float p = t * (1.44187984f + t * (-0.708864546f + t * (0.415243258f + t * (-0.193513454f + t * 0.045266897f))));
+		return e + p;
+	}
+
+	// |error| <= 1.8e-7 (relative), x in [-126, 127], 5 mul + 5 add
+	inline float exp2(float x)
+	{
+		int32_t i = static_cast<int32_t>(x);
+		i -= static_cast<float>(i) > x; // floor
+		const float f = x - static_cast<float>(i); // [0, 1)
+
+		const float p = 1.0f + f * (0.693152536f + f * (0.240152438f + f * (0.0558366208f + f * (0.00897286887f + f * 0.00188541762f))));
+		const uint32_t scale = static_cast<uint32_t>(i + 127) << 23;
+		return p * std::bit_cast<float>(scale);
+	}
+
+	// |error| <= 2e-5 (absolute), 1.5e-5 from log2 and the rest from rounding the product for |log(x)| up to 88
+	inline float log(float x)
+	{
+		return log2(x) * 0.693147181f;
+	}
+
+	// relative error <= 1.8e-7 + 1.2e-7 * |x| (argument rounding)
+	inline float exp(float x)
+	{
+		return exp2(x * 1.44269504f);
+	}
+
+	// relative error <= 1.8e-7 + 1.5e-5 * |y|
+	inline float pow(float x, float y)
+	{
+		return exp2(y * log2(x));
+	}
+};
+
+#endif
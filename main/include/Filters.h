@@ -0,0 +1,342 @@
+#ifndef Filters_H
+#define Filters_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <array>
+#include <type_traits>
+
+// Filter kernels templated on the sample type:
+//   float    - plain single precision
+//   int16_t  - Q15 samples, 32-bit EMA state, 64-bit IIR accumulator
+//   int32_t  - Q31 samples, 64-bit state and accumulator
+// Every filter has evaluate() for one sample and process() for a block (in and out may alias).
+// Coefficients are given as float (biquad designs in double, for Q31) and converted once in the constructor.
+
+template <typename T>
+struct FilterTraits;
+
+template <>
+struct FilterTraits<float>
+{
+	using coef_t = float;
+	using acc_t = float;
+	using wide_t = float;
+	static constexpr int EMA_FRAC = 0;
+	static constexpr int IIR_FRAC = 0;
+};
+
+template <>
+struct FilterTraits<int16_t>
+{
+	using coef_t = int32_t;
+	using acc_t = int32_t; // EMA state, Q15 sample with 15 more fraction bits
+	using wide_t = int64_t;
+	static constexpr int EMA_FRAC = 15; // alpha in Q15
+	static constexpr int IIR_FRAC = 14; // biquad coefficients in Q2.14, range [-2, 2)
+};
+
+template <>
+struct FilterTraits<int32_t>
+{
+	using coef_t = int32_t;
+	using acc_t = int64_t; // EMA state, Q31 sample with 31 more fraction bits
+	using wide_t = int64_t;
+	static constexpr int EMA_FRAC = 31; // alpha in Q31
+	static constexpr int IIR_FRAC = 28; // biquad coefficients in Q4.28, range [-8, 8), 5 products fit in 64 bits
+};
+
+namespace FilterMath
+{
+	template <typename T, typename W>
+	constexpr T saturate(W v)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+			return v;
+		else
+			return static_cast<T>(std::clamp<W>(v, std::numeric_limits<T>::min(), std::numeric_limits<T>::max()));
+	}
+
+	// Round to nearest, right shift of a signed accumulator
+	template <typename W>
+	constexpr W round_shift(W v, int frac)
+	{
+		if constexpr (std::is_floating_point_v<W>)
+			return v;
+		else
+			return frac ? (v + (W(1) << (frac - 1))) >> frac : v;
+	}
+
+	template <typename C>
+	C to_coef(double c, int frac)
+	{
+		if constexpr (std::is_floating_point_v<C>)
+			return static_cast<C>(c);
+		else
+			return static_cast<C>(std::clamp<double>(std::round(c * double(int64_t(1) << frac)), std::numeric_limits<C>::min(), std::numeric_limits<C>::max()));
+	}
+};
+
+// Exponential moving average y += alpha * (x - y), alpha in (0, 1).
+// Fixed point keeps EMA_FRAC extra fraction bits in the state and takes the difference at that precision,
+// so small steps are not lost and value() settles to the input from above and from below.
+template <typename T>
+class EMA
+{
+	using Tr = FilterTraits<T>;
+
+private:
+	typename Tr::coef_t alpha;
+	typename Tr::acc_t state;
+
+public:
+	EMA(float a, T initial = 0) : alpha(FilterMath::to_coef<typename Tr::coef_t>(a, Tr::EMA_FRAC))
+	{
+		reset(initial);
+	}
+	~EMA() = default;
+
+	void reset(T value)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+			state = value;
+		else
+			state = static_cast<typename Tr::acc_t>(value) << Tr::EMA_FRAC;
+	}
+
+	T value() const
+	{
+		return FilterMath::saturate<T>(FilterMath::round_shift(state, Tr::EMA_FRAC));
+	}
+
+	T evaluate(T x)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+			state += alpha * (x - state);
+		else
+		{
+			// alpha * ((x << FRAC) - state) >> FRAC, split into the integer and the fraction part of the state
+			// so no product needs more than 64 bits
+			using wide_t = typename Tr::wide_t;
+			constexpr int FRAC = Tr::EMA_FRAC;
+
+			const wide_t hi = state >> FRAC;
+			const wide_t lo = state & ((wide_t(1) << FRAC) - 1);
+			state += static_cast<typename Tr::acc_t>(wide_t(alpha) * (x - hi) - FilterMath::round_shift(wide_t(alpha) * lo, FRAC));
+		}
+
+		return value();
+	}
+
+	void process(const T *in, T *out, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+			out[i] = evaluate(in[i]);
+	}
+};
+
+// Second order IIR section, a0 normalised to 1:
+// y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+// Float runs transposed direct form II, fixed point direct form I in a wide accumulator with error feedback
+// (the truncated fraction is carried into the next sample), so limit cycles and DC error stay below 1 LSB.
+template <typename T>
+class Biquad
+{
+	using Tr = FilterTraits<T>;
+	using coef_t = typename Tr::coef_t;
+	using wide_t = typename Tr::wide_t;
+
+public:
+	struct Coefs
+	{
+		double b0, b1, b2, a1, a2; // double so the design does not limit Q31
+	};
+
+private:
+	coef_t b0, b1, b2, a1, a2;
+
+	// float: TDF-II state, fixed: x[n-1], x[n-2], y[n-1], y[n-2]
+	wide_t s1 = 0, s2 = 0;
+	T x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+	wide_t err = 0;
+
+public:
+	Biquad(const Coefs &c) : b0(conv(c.b0)), b1(conv(c.b1)), b2(conv(c.b2)), a1(conv(c.a1)), a2(conv(c.a2))
+	{
+	}
+	~Biquad() = default;
+
+	// RBJ cookbook designs, f0 and fs in the same unit
+	static Coefs lowpass(double fs, double f0, double q = M_SQRT1_2)
+	{
+		const double w = 2 * M_PI * f0 / fs;
+		const double cw = std::cos(w);
+		const double alpha = std::sin(w) / (2 * q);
+		const double a0 = 1 + alpha;
+		return {(1 - cw) / 2 / a0, (1 - cw) / a0, (1 - cw) / 2 / a0, -2 * cw / a0, (1 - alpha) / a0};
+	}
+
+	static Coefs highpass(double fs, double f0, double q = M_SQRT1_2)
+	{
+		const double w = 2 * M_PI * f0 / fs;
+		const double cw = std::cos(w);
+		const double alpha = std::sin(w) / (2 * q);
+		const double a0 = 1 + alpha;
+		return {(1 + cw) / 2 / a0, -(1 + cw) / a0, (1 + cw) / 2 / a0, -2 * cw / a0, (1 - alpha) / a0};
+	}
+
+	void reset()
+	{
+		s1 = s2 = err = 0;
+		x1 = x2 = y1 = y2 = 0;
+	}
+
+	T evaluate(T x)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			const T y = b0 * x + s1;
+			s1 = b1 * x - a1 * y + s2;
+			s2 = b2 * x - a2 * y;
+			return y;
+		}
+		else
+		{
+			wide_t acc = err;
+			acc += wide_t(b0) * x + wide_t(b1) * x1 + wide_t(b2) * x2;
+			acc -= wide_t(a1) * y1 + wide_t(a2) * y2;
+
+			const wide_t q = acc >> Tr::IIR_FRAC;
+			err = acc - (q << Tr::IIR_FRAC);
+
+			const T y = FilterMath::saturate<T>(q);
+			x2 = x1;
+			x1 = x;
+			y2 = y1;
+			y1 = y;
+			return y;
+		}
+	}
+
+	void process(const T *in, T *out, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+			out[i] = evaluate(in[i]);
+	}
+
+private:
+	static coef_t conv(double c)
+	{
+		return FilterMath::to_coef<coef_t>(c, Tr::IIR_FRAC);
+	}
+};
+
+// Boxcar average of the last N samples from a running sum, O(1) per sample.
+// Fixed point sums exactly in 64 bits, float rebuilds the sum once per wrap so rounding error cannot accumulate.
+template <typename T, size_t N>
+class MovingAverage
+{
+	static_assert(N > 0);
+	using sum_t = std::conditional_t<std::is_floating_point_v<T>, T, int64_t>;
+
+private:
+	std::array<T, N> buf = {};
+	size_t head = 0;
+	sum_t sum = 0;
+
+public:
+	MovingAverage(T initial = 0)
+	{
+		reset(initial);
+	}
+	~MovingAverage() = default;
+
+	void reset(T value)
+	{
+		buf.fill(value);
+		sum = sum_t(value) * sum_t(N);
+		head = 0;
+	}
+
+	T evaluate(T x)
+	{
+		sum += sum_t(x) - sum_t(buf[head]);
+		buf[head] = x;
+
+		if (++head == N)
+		{
+			head = 0;
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				sum = 0;
+				for (T v : buf)
+					sum += v;
+			}
+		}
+
+		if constexpr (std::is_floating_point_v<T>)
+			return sum * (T(1) / T(N));
+		else // round to nearest
+			return static_cast<T>((sum + (sum >= 0 ? sum_t(N / 2) : -sum_t(N / 2))) / sum_t(N));
+	}
+
+	void process(const T *in, T *out, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+			out[i] = evaluate(in[i]);
+	}
+};
+
+// Median of the last N samples (N odd, small), removes single-sample spikes up to (N-1)/2 wide and keeps steps sharp.
+// Sorts a copy of the window with insertion sort, which for N <= 9 beats anything cleverer.
+template <typename T, size_t N>
+class Median
+{
+	static_assert(N % 2 == 1, "Median needs an odd window!");
+
+private:
+	std::array<T, N> buf = {};
+	size_t head = 0;
+
+public:
+	Median(T initial = 0)
+	{
+		reset(initial);
+	}
+	~Median() = default;
+
+	void reset(T value)
+	{
+		buf.fill(value);
+		head = 0;
+	}
+
+	T evaluate(T x)
+	{
+		buf[head] = x;
+		head = (head + 1) % N;
+
+		std::array<T, N> s = buf;
+		for (size_t i = 1; i < N; ++i)
+		{
+			const T v = s[i];
+			size_t j = i;
+			for (; j > 0 && s[j - 1] > v; --j)
+				s[j] = s[j - 1];
+			s[j] = v;
+		}
+
+		return s[N / 2];
+	}
+
+	void process(const T *in, T *out, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+			out[i] = evaluate(in[i]);
+	}
+};
+
+#endif
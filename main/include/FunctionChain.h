@@ -1,9 +1,15 @@
+#ifndef FunctionChain_H
+#define FunctionChain_H
 
-#include <any>
 #include <functional>
 #include <vector>
-#include <typeindex>
 #include <memory> // For std::unique_ptr
+#include <tuple>
+#include <array>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
 
 #include <type_traits>
 
@@ -41,6 +47,12 @@ struct function_traits : function_traits<decltype(&Functor::operator())>
 {
 };
 
+// Needs RTTI and exceptions, which the firmware builds without, use StaticFunctionManager there
+#if defined(__GXX_RTTI) && defined(__cpp_exceptions)
+#include <any>
+#include <typeindex>
+#include <stdexcept>
+
 class FunctionManager
 {
 private:
@@ -128,10 +140,261 @@ public:
 		return value;
 	}
 };
+#endif
+
+// A stage is called with operator() or, like the SignalProcessing.h classes, with evaluate()
+template <typename Stage, typename In>
+decltype(auto) invoke_stage(Stage &stage, In &&input)
+{
+	if constexpr (std::is_invocable_v<Stage &, In>)
+		return stage(std::forward<In>(input));
+	else if constexpr (requires { stage.evaluate(std::forward<In>(input)); })
+		return stage.evaluate(std::forward<In>(input));
+	else
+		static_assert(sizeof(Stage) == 0, "Stage cannot be called with the output of the previous stage!");
+}
+
+template <typename Stage, typename In>
+decltype(auto) invoke_stage(std::reference_wrapper<Stage> stage, In &&input)
+{
+	return invoke_stage(stage.get(), std::forward<In>(input));
+}
+
+// Argument and return type of a stage, from evaluate() if it has no operator()
+template <typename Stage>
+struct stage_traits : function_traits<Stage>
+{
+};
+
+template <typename Stage>
+	requires(!requires { &Stage::operator(); } && requires { &Stage::evaluate; })
+struct stage_traits<Stage> : function_traits<decltype(&Stage::evaluate)>
+{
+};
+
+template <typename Stage>
+struct stage_traits<std::reference_wrapper<Stage>> : stage_traits<Stage>
+{
+};
+
+// Tagged union over a fixed set of trivially copyable types, the allocation-free replacement for std::any
+template <typename... Ts>
+class TaggedValue
+{
+	static_assert(sizeof...(Ts) > 0 && sizeof...(Ts) < 0xFF);
+	static_assert((std::is_trivially_copyable_v<Ts> && ...), "Only trivially copyable types can be stored!");
+
+public:
+	static constexpr uint8_t NONE = 0xFF;
+
+	template <typename T>
+	static constexpr bool supports = (std::is_same_v<T, Ts> || ...);
+
+	template <typename T>
+	static constexpr uint8_t tag_of()
+	{
+		static_assert(supports<T>, "Type is not in the TaggedValue!");
+		uint8_t i = 0;
+		((std::is_same_v<T, Ts> ? false : (++i, true)) && ...);
+		return i;
+	}
+
+private:
+	alignas(Ts...) std::byte data[std::max({sizeof(Ts)...})];
+	uint8_t tag = NONE;
+
+public:
+	TaggedValue() = default;
+
+	template <typename T>
+	TaggedValue(T value) : tag(tag_of<T>())
+	{
+		new (data) T(value);
+	}
+
+	uint8_t type() const
+	{
+		return tag;
+	}
+
+	template <typename T>
+	bool holds() const
+	{
+		return tag == tag_of<T>();
+	}
+
+	template <typename T>
+	T get() const
+	{
+		assert(holds<T>());
+		return *std::launder(reinterpret_cast<const T *>(data));
+	}
+
+	bool operator==(const TaggedValue &other) const
+	{
+		if (tag != other.tag)
+			return false;
+		if (tag == NONE)
+			return true;
+		return ((holds<Ts>() && get<Ts>() == other.get<Ts>()) || ...);
+	}
+};
+
+// Runtime-configured chain like FunctionManager, but with no heap, RTTI or exceptions:
+// stages live in a fixed inline array (callable stored in place, at most BUF bytes), values travel as VALUE (a TaggedValue),
+// and the types are checked once in addFunction(), so executeChain() only dispatches through one function pointer per stage.
+template <typename VALUE = TaggedValue<bool, int32_t, float>, size_t CAPACITY = 8, size_t BUF = 16>
+class StaticFunctionManager
+{
+private:
+	struct Stage
+	{
+		alignas(std::max_align_t) std::byte buf[BUF];
+		VALUE (*invoke)(void *, const VALUE &);
+		void (*destroy)(void *);
+		uint8_t in;
+		uint8_t out;
+	};
+
+	std::array<Stage, CAPACITY> stages;
+	size_t count = 0;
+
+public:
+	StaticFunctionManager() = default;
+	StaticFunctionManager(const StaticFunctionManager &) = delete;
+	StaticFunctionManager &operator=(const StaticFunctionManager &) = delete;
+	~StaticFunctionManager()
+	{
+		clear();
+	}
+
+	// Functor, lambda, function pointer, a stage with evaluate() or std::ref of any of them, as for pipe().
+	// Returns false (and adds nothing) if the chain is full or the input type does not match the previous output.
+	template <typename F>
+	bool addFunction(F func)
+	{
+		using Fn = std::decay_t<F>;
+		using Traits = stage_traits<Fn>;
+		using In = std::decay_t<typename Traits::ArgType>;
+		using Out = std::decay_t<typename Traits::ReturnType>;
+
+		static_assert(sizeof(Fn) <= BUF && alignof(Fn) <= alignof(std::max_align_t), "Callable too large for the inline buffer!");
+		static_assert(VALUE::template supports<In> && VALUE::template supports<Out>, "Stage type not in the TaggedValue!");
+
+		if (count >= CAPACITY)
+			return false;
+		if (count && stages[count - 1].out != VALUE::template tag_of<In>())
+			return false;
+
+		Stage &s = stages[count];
+		new (s.buf) Fn(std::move(func));
+		s.invoke = [](void *f, const VALUE &v) -> VALUE
+		{
+			return VALUE(static_cast<Out>(invoke_stage(*std::launder(reinterpret_cast<Fn *>(f)), v.template get<In>())));
+		};
+		s.destroy = [](void *f)
+		{
+			std::launder(reinterpret_cast<Fn *>(f))->~Fn();
+		};
+		s.in = VALUE::template tag_of<In>();
+		s.out = VALUE::template tag_of<Out>();
+
+		++count;
+		return true;
+	}
+
+	void clear()
+	{
+		while (count)
+		{
+			Stage &s = stages[--count];
+			s.destroy(s.buf);
+		}
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	// Type of the value executeChain() expects, NONE if empty
+	uint8_t inputType() const
+	{
+		return count ? stages[0].in : VALUE::NONE;
+	}
+
+	uint8_t outputType() const
+	{
+		return count ? stages[count - 1].out : VALUE::NONE;
+	}
+
+	// Returns false if the initial value has the wrong type, the only check left at run time
+	bool executeChain(const VALUE &initialValue, VALUE &result)
+	{
+		if (count && initialValue.type() != stages[0].in)
+			return false;
+
+		VALUE value = initialValue;
+		for (size_t i = 0; i < count; ++i)
+			value = stages[i].invoke(stages[i].buf, value);
+
+		result = value;
+		return true;
+	}
+};
+
+// Compile-time counterpart of FunctionManager: pipe(LowPassFilter(0.1f), Hysteresis(0.4f, 0.6f), BoolLowpass(5), PosEdge())
+// Stages are stored by value (std::ref for shared state) and called through invoke_stage(),
+// each output must be accepted by the next stage or it does not compile. No allocation, no virtual calls, no std::any.
+template <typename... Stages>
+class Pipeline
+{
+private:
+	std::tuple<Stages...> stages;
+
+	template <size_t I, typename V>
+	auto run(V value)
+	{
+		if constexpr (I == sizeof...(Stages))
+			return value;
+		else
+			return run<I + 1>(invoke_stage(std::get<I>(stages), value));
+	}
+
+public:
+	Pipeline(Stages... s) : stages(std::move(s)...)
+	{
+	}
+	~Pipeline() = default;
+
+	template <typename In>
+	auto operator()(In input)
+	{
+		return run<0>(input);
+	}
+
+	template <typename In>
+	auto evaluate(In input)
+	{
+		return run<0>(input);
+	}
+
+	template <size_t I>
+	auto &stage()
+	{
+		return std::get<I>(stages);
+	}
+};
+
+template <typename... Stages>
+Pipeline<Stages...> pipe(Stages... stages)
+{
+	return Pipeline<Stages...>(std::move(stages)...);
+}
 
 // Example Functions
-bool floatToBool(float x) { return x > 0.5f; }
-float boolToFloat(bool b) { return b ? 1.0f : 0.0f; }
+inline bool floatToBool(float x) { return x > 0.5f; }
+inline float boolToFloat(bool b) { return b ? 1.0f : 0.0f; }
 
 // Low-pass filter class
 class LowPassFilter
@@ -150,4 +413,6 @@ public:
 		state = alpha * input + (1 - alpha) * state;
 		return state;
 	}
-};
\ No newline at end of file
+};
+
+#endif
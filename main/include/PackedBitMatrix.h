@@ -0,0 +1,878 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <algorithm>
+#include <bit>
+
+#include "BitMatrix.h"
+
+// Same boolean algebra as BitMatrix, but the whole matrix lives in one contiguous uint64_t array,
+// so every whole-matrix op is a single loop over words (vectorised on host, 2 words per op pair on ESP32).
+// Rows narrower than a word that tile it exactly are packed back to back (16x16 -> 4 words),
+// any other width starts each row on a word boundary and pads it (ROW_WORDS words per row).
+// Bit x of a row is column x, padding bits are kept 0 so reductions and comparisons need no masking.
+template <size_t H, size_t W>
+class PackedBitMatrix
+{
+	static_assert(H >= 1, "Height must be greater than 0!");
+	static_assert(W >= 1, "Width  must be greater than 0!");
+
+public:
+	using word_t = uint64_t;
+	using this_t = PackedBitMatrix<H, W>;
+
+	static constexpr size_t WORD_BITS = 64;
+	static constexpr bool PACKED_ROWS = W < WORD_BITS && WORD_BITS % W == 0;
+	static constexpr size_t ROWS_PER_WORD = PACKED_ROWS ? WORD_BITS / W : 1;
+	static constexpr size_t ROW_WORDS = PACKED_ROWS ? 1 : (W + WORD_BITS - 1) / WORD_BITS; // words a row spans
+	static constexpr size_t WORDS = PACKED_ROWS ? (H + ROWS_PER_WORD - 1) / ROWS_PER_WORD : H * ROW_WORDS;
+
+	static constexpr word_t ROW_MASK = W >= WORD_BITS ? ~word_t(0) : (word_t(1) << (W % WORD_BITS)) - 1; // one row of a packed word
+
+	// Masks of the bits that are pixels: packed rows only pad the last word, padded rows the last word of every row
+	static constexpr bool EXACT = PACKED_ROWS ? H % ROWS_PER_WORD == 0 : W % WORD_BITS == 0; // no padding at all
+	static constexpr word_t LAST_MASK = PACKED_ROWS && !EXACT ? (word_t(1) << (H % ROWS_PER_WORD * W)) - 1 : ~word_t(0);
+	static constexpr word_t TAIL_MASK = !PACKED_ROWS && !EXACT ? (word_t(1) << (W % WORD_BITS)) - 1 : ~word_t(0);
+
+	static constexpr size_t ROW_BITS = PACKED_ROWS ? W : ROW_WORDS * WORD_BITS; // distance between rows
+	static constexpr word_t ROW_REP = []
+	{
+		word_t r = 0;
+		for (size_t i = 0; i < ROWS_PER_WORD; ++i)
+			r |= word_t(1) << (i * ROW_BITS % WORD_BITS);
+		return r;
+	}(); // bit 0 of every row in a packed word, multiply a row mask by it to repeat it
+
+	static constexpr word_t valid(size_t i)
+	{
+		if constexpr (EXACT)
+			return ~word_t(0);
+		else if constexpr (PACKED_ROWS)
+			return i == WORDS - 1 ? LAST_MASK : ~word_t(0);
+		else
+			return i % ROW_WORDS == ROW_WORDS - 1 ? TAIL_MASK : ~word_t(0);
+	}
+
+protected:
+	std::array<word_t, WORDS> words;
+
+	static constexpr size_t word_of(size_t y, size_t x)
+	{
+		if constexpr (PACKED_ROWS)
+			return y / ROWS_PER_WORD;
+		else
+			return y * ROW_WORDS + x / WORD_BITS;
+	}
+	static constexpr size_t bit_of(size_t y, size_t x)
+	{
+		if constexpr (PACKED_ROWS)
+			return y % ROWS_PER_WORD * W + x;
+		else
+			return x % WORD_BITS;
+	}
+
+public:
+	constexpr PackedBitMatrix() : words({}) {}
+	~PackedBitMatrix() = default;
+
+	template <size_t Hb, size_t Wb>
+	constexpr explicit PackedBitMatrix(const BitMatrix<Hb, Wb> &B) : words({})
+	{
+		static_assert(H == Hb, "Matrix heights must match!");
+		static_assert(W == Wb, "Matrix widths  must match!");
+
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				set(y, x, B.test(y, x));
+	}
+
+	constexpr BitMatrix<H, W> to_bitmatrix() const
+	{
+		BitMatrix<H, W> B;
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				B.set(y, x, test(y, x));
+		return B;
+	}
+
+	// String art as in BitMatrix::parse()
+	static consteval this_t parse(const char *art)
+	{
+		return this_t(BitMatrix<H, W>::parse(art));
+	}
+
+	// Same text as BitMatrix::dump(), one sink(line, len) call per line
+	template <typename Sink>
+	void dump(Sink &&sink) const
+	{
+		MatrixDump::bits<H, W>([this](size_t y, size_t x)
+							   { return test(y, x); },
+							   any(), all(), none(), sink);
+	}
+
+	// Same text into buf, returns the full length like snprintf
+	size_t dump(char *buf, size_t size) const
+	{
+		return MatrixDump::to_buffer(buf, size, [this](auto &&sink)
+									 { dump(sink); });
+	}
+
+	constexpr word_t *data()
+	{
+		return words.data();
+	}
+	constexpr const word_t *data() const
+	{
+		return words.data();
+	}
+
+	inline constexpr bool test(size_t y, size_t x) const
+	{
+		return words[word_of(y, x)] >> bit_of(y, x) & 1;
+	}
+	inline constexpr bool test(size_t pos) const
+	{
+		return test(pos / W, pos % W);
+	}
+	inline constexpr bool operator()(size_t y, size_t x) const
+	{
+		return test(y, x);
+	}
+
+	inline constexpr this_t &set(size_t y, size_t x, bool v = true)
+	{
+		const word_t m = word_t(1) << bit_of(y, x);
+		word_t &w = words[word_of(y, x)];
+		w = v ? w | m : w & ~m;
+		return *this;
+	}
+	inline constexpr this_t &set(size_t pos, bool v = true)
+	{
+		return set(pos / W, pos % W, v);
+	}
+	inline constexpr this_t &reset(size_t y, size_t x)
+	{
+		return set(y, x, false);
+	}
+
+	// Word k of row y, column k * 64 at bit 0
+	inline constexpr word_t row(size_t y, size_t k = 0) const
+	{
+		if constexpr (PACKED_ROWS)
+			return words[y / ROWS_PER_WORD] >> (y % ROWS_PER_WORD * W) & ROW_MASK;
+		else
+			return words[y * ROW_WORDS + k];
+	}
+	inline constexpr this_t &set_row(size_t y, word_t v, size_t k = 0)
+	{
+		if constexpr (PACKED_ROWS)
+		{
+			const size_t s = y % ROWS_PER_WORD * W;
+			word_t &w = words[y / ROWS_PER_WORD];
+			w = (w & ~(ROW_MASK << s)) | (v & ROW_MASK) << s;
+		}
+		else
+			words[y * ROW_WORDS + k] = v & valid(y * ROW_WORDS + k);
+		return *this;
+	}
+
+	// Contradiction           | 0    | 0
+	constexpr this_t &Opq()
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] = 0;
+		return *this;
+	}
+
+	// Logical conjunction     | A∧B | A&B
+	constexpr this_t &Kpq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] &= B.words[i];
+		return *this;
+	}
+
+	// Material nonimplication | A↛B  | A&~B
+	constexpr this_t &Lpq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] &= ~B.words[i];
+		return *this;
+	}
+
+	// Projection function     | A    | A
+	constexpr this_t &Ipq()
+	{
+		return *this;
+	}
+
+	// Converse nonimplication | A↚B  | ~A&B
+	constexpr this_t &Mpq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] = ~words[i] & B.words[i];
+		return *this;
+	}
+
+	// Projection function     | B    | B
+	constexpr this_t &Hpq(const this_t &B)
+	{
+		words = B.words;
+		return *this;
+	}
+
+	// Exclusive disjunction   | A⊕B  | A^B
+	constexpr this_t &Jpq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] ^= B.words[i];
+		return *this;
+	}
+
+	// Logical disjunction     | A∨B | A|B
+	constexpr this_t &Apq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] |= B.words[i];
+		return *this;
+	}
+
+	// Logical NOR             | A↓B  | ~(A|B)
+	constexpr this_t &Xpq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] = ~(words[i] | B.words[i]) & valid(i);
+		return *this;
+	}
+
+	// Logical biconditional   | A↔B  | ~(A^B)
+	constexpr this_t &Epq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] = ~(words[i] ^ B.words[i]) & valid(i);
+		return *this;
+	}
+
+	// Negation                | ¬B   | ~B
+	constexpr this_t &Gpq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] = ~B.words[i] & valid(i);
+		return *this;
+	}
+
+	// Converse implication    | A←B  | A|~B
+	constexpr this_t &Bpq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] = (words[i] | ~B.words[i]) & valid(i);
+		return *this;
+	}
+
+	// Negation                | ¬A   | ~A
+	constexpr this_t &Fpq()
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] ^= valid(i);
+		return *this;
+	}
+
+	// Material implication    | A→B  | ~A|B
+	constexpr this_t &Cpq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] = (~words[i] | B.words[i]) & valid(i);
+		return *this;
+	}
+
+	// Logical NAND            | A↑B  | ~(A&B)
+	constexpr this_t &Dpq(const this_t &B)
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] = ~(words[i] & B.words[i]) & valid(i);
+		return *this;
+	}
+
+	// Tautology               | 1    | 1
+	constexpr this_t &Vpq()
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i] = valid(i);
+		return *this;
+	}
+
+	constexpr this_t &flip()
+	{
+		return Fpq();
+	}
+
+	constexpr this_t operator~() const
+	{
+		this_t temp(*this);
+		return temp.Fpq();
+	}
+
+	constexpr this_t &operator|=(const this_t &B)
+	{
+		return Apq(B);
+	}
+	constexpr this_t &operator&=(const this_t &B)
+	{
+		return Kpq(B);
+	}
+	constexpr this_t &operator^=(const this_t &B)
+	{
+		return Jpq(B);
+	}
+	constexpr this_t &operator-=(const this_t &B)
+	{
+		return Lpq(B);
+	}
+	constexpr this_t &operator/=(const this_t &B)
+	{
+		return Bpq(B);
+	}
+
+	friend constexpr this_t operator|(this_t A, const this_t &B)
+	{
+		return A |= B;
+	}
+	friend constexpr this_t operator&(this_t A, const this_t &B)
+	{
+		return A &= B;
+	}
+	friend constexpr this_t operator^(this_t A, const this_t &B)
+	{
+		return A ^= B;
+	}
+	friend constexpr this_t operator-(this_t A, const this_t &B)
+	{
+		return A -= B;
+	}
+	friend constexpr this_t operator/(this_t A, const this_t &B)
+	{
+		return A /= B;
+	}
+
+	// Whole-matrix equality (BitMatrix::operator== is the elementwise Epq)
+	friend constexpr bool operator==(const this_t &A, const this_t &B)
+	{
+		return A.words == B.words;
+	}
+
+	constexpr bool any() const
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			if (words[i])
+				return true;
+		return false;
+	}
+
+	constexpr bool all() const
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			if (words[i] != valid(i))
+				return false;
+		return true;
+	}
+
+	constexpr bool none() const
+	{
+		return !any();
+	}
+
+	//  COUNTS AND SEARCH, on whole words with the popcount/clz/ctz instructions where the target has them
+
+	static constexpr size_t npos = H * W;
+
+	constexpr size_t count() const
+	{
+		size_t n = 0;
+		for (word_t w : words)
+			n += std::popcount(w);
+		return n;
+	}
+
+	constexpr std::array<size_t, H> row_counts() const
+	{
+		std::array<size_t, H> n = {};
+		for (size_t y = 0; y < H; ++y)
+			for (size_t k = 0; k < ROW_WORDS; ++k)
+				n[y] += std::popcount(row(y, k));
+		return n;
+	}
+
+	// Columns are the rows of the transpose
+	constexpr std::array<size_t, W> col_counts() const
+	{
+		return transposed().row_counts();
+	}
+
+	// Position y * W + x of the first set pixel in raster order, npos if none
+	constexpr size_t find_first() const
+	{
+		for (size_t i = 0; i < WORDS; ++i)
+			if (words[i])
+				return pos_of(i, std::countr_zero(words[i]));
+		return npos;
+	}
+
+	// Position of the last set pixel in raster order, npos if none
+	constexpr size_t find_last() const
+	{
+		for (size_t i = WORDS; i-- > 0;)
+			if (words[i])
+				return pos_of(i, WORD_BITS - 1 - std::countl_zero(words[i]));
+		return npos;
+	}
+
+	constexpr BitBox bounding_box() const
+	{
+		const size_t first = find_first();
+		if (first == npos)
+			return {};
+
+		BitBox box;
+		box.y0 = first / W;
+		box.y1 = find_last() / W + 1;
+
+		// union of all rows, then the first and last set column
+		box.x0 = W;
+		for (size_t k = 0; k < ROW_WORDS; ++k)
+		{
+			word_t u = 0;
+			if constexpr (PACKED_ROWS)
+			{
+				for (word_t w : words)
+					u |= w;
+				for (size_t s = WORD_BITS / 2; s >= W; s /= 2) // fold the rows of a word onto row 0
+					u |= u >> s;
+				u &= ROW_MASK;
+			}
+			else
+			{
+				for (size_t y = 0; y < H; ++y)
+					u |= row(y, k);
+			}
+
+			if (u)
+			{
+				box.x0 = std::min(box.x0, k * WORD_BITS + std::countr_zero(u));
+				box.x1 = k * WORD_BITS + WORD_BITS - std::countl_zero(u);
+			}
+		}
+		return box;
+	}
+
+	// The 4 ('4'/'+') or 8 ('8'/'o') connected component holding pixel (y, x), empty if the pixel is not set.
+	// Grows the pixel by dilation constrained to the matrix until it stops changing, whole words at a time.
+	constexpr this_t component(size_t y, size_t x, char conn = '4') const
+	{
+		this_t c;
+		if (test(y, x))
+			c.set(y, x);
+
+		for (;;)
+		{
+			this_t next(c);
+			next.dilate(conn, 1).Kpq(*this);
+			if (next == c)
+				return c;
+			c = next;
+		}
+	}
+
+	size_t components(char conn = '4') const
+	{
+		return label_runs<H, W, uint16_t>(nullptr, conn, false, [this](size_t y, size_t i)
+										  { return row(y, i / WORD_BITS); });
+	}
+
+	// Writes 1..n to the pixels of each component in raster order of their first pixel, 0 elsewhere, returns n
+	template <typename L>
+	size_t label(Matrix<L, H, W> &labels, char conn = '4') const
+	{
+		return label_runs(&labels, conn, false, [this](size_t y, size_t i)
+						  { return row(y, i / WORD_BITS); });
+	}
+
+	// Moves the content down by dy rows and right by dx columns, shifting in zeros
+	constexpr this_t &shift(ptrdiff_t dy, ptrdiff_t dx)
+	{
+		if (dx)
+			shift_x(dx);
+		if (dy)
+			shift_y(dy);
+		return *this;
+	}
+	constexpr this_t shifted(ptrdiff_t dy, ptrdiff_t dx) const
+	{
+		this_t temp(*this);
+		return temp.shift(dy, dx);
+	}
+
+	// Same results as BitMatrix::dilate/erode (outside the matrix counts as 0), but
+	// 8 (square) is separable, the horizontal and vertical segments grow by doubling: O(log num) passes instead of num,
+	// 4 (diamond) is not, so it fuses one whole cross per pass and stops early once nothing changes.
+	constexpr this_t &dilate(char conn = '4', size_t num = 1)
+	{
+		return morph<Merge::OR>(conn, num);
+	}
+	constexpr this_t &erode(char conn = '4', size_t num = 1)
+	{
+		return morph<Merge::AND>(conn, num);
+	}
+
+	constexpr this_t dilation(char conn = '4', size_t num = 1) const
+	{
+		this_t temp(*this);
+		return temp.dilate(conn, num);
+	}
+	constexpr this_t erosion(char conn = '4', size_t num = 1) const
+	{
+		this_t temp(*this);
+		return temp.erode(conn, num);
+	}
+
+	// Removes features smaller than the structuring element
+	constexpr this_t &open(char conn = '4', size_t num = 1)
+	{
+		return erode(conn, num).dilate(conn, num);
+	}
+	// Fills gaps smaller than the structuring element
+	constexpr this_t &close(char conn = '4', size_t num = 1)
+	{
+		return dilate(conn, num).erode(conn, num);
+	}
+
+	constexpr this_t opening(char conn = '4', size_t num = 1) const
+	{
+		this_t temp(*this);
+		return temp.open(conn, num);
+	}
+	constexpr this_t closing(char conn = '4', size_t num = 1) const
+	{
+		this_t temp(*this);
+		return temp.close(conn, num);
+	}
+
+	// Outline: dilation minus erosion
+	constexpr this_t gradient(char conn = '4', size_t num = 1) const
+	{
+		return dilation(conn, num).Lpq(erosion(conn, num));
+	}
+
+	// Rows become columns, e.g. grid-major to anode-major.
+	// B x B blocks of row bits are cut out with row(), transposed by block swaps and or-ed into the rows of the result.
+	constexpr PackedBitMatrix<W, H> transposed() const
+	{
+		constexpr size_t B = transpose_block_size(std::min(H, W));
+		constexpr word_t BLOCK_MASK = B == WORD_BITS ? ~word_t(0) : (word_t(1) << B) - 1;
+
+		PackedBitMatrix<W, H> T;
+		for (size_t by = 0; by < H; by += B)
+			for (size_t bx = 0; bx < W; bx += B)
+			{
+				std::array<word_t, B> a = {};
+				for (size_t r = 0; r < B && by + r < H; ++r)
+					a[r] = row(by + r, bx / WORD_BITS) >> (bx % WORD_BITS) & BLOCK_MASK;
+
+				transpose_bits(a);
+
+				const size_t k = by / WORD_BITS;
+				for (size_t c = 0; c < B && bx + c < W; ++c)
+					T.set_row(bx + c, T.row(bx + c, k) | a[c] << (by % WORD_BITS), k);
+			}
+		return T;
+	}
+
+	constexpr this_t &transpose()
+	{
+		static_assert(H == W, "Only a square matrix can be transposed in place!");
+		*this = transposed();
+		return *this;
+	}
+
+private:
+	using words_t = std::array<word_t, WORDS>;
+
+	static constexpr size_t pos_of(size_t i, size_t bit)
+	{
+		if constexpr (PACKED_ROWS)
+			return i * WORD_BITS + bit; // rows are back to back, so the bit index is the position
+		else
+			return i / ROW_WORDS * W + i % ROW_WORDS * WORD_BITS + bit;
+	}
+
+	enum class Merge
+	{
+		SET, // shift
+		OR,	 // dilate
+		AND, // erode
+	};
+
+	template <Merge M>
+	static constexpr void merge(word_t &dst, word_t v)
+	{
+		if constexpr (M == Merge::SET)
+			dst = v;
+		else if constexpr (M == Merge::OR)
+			dst |= v;
+		else
+			dst &= v;
+	}
+
+	// w (len words, little-endian) merged with itself shifted by n bits towards the higher (shl) or lower words (shr), zeros shifted in.
+	// In place: shl runs downwards and shr upwards, so every source word is read before it is overwritten.
+	// (v >> 1) >> (63 - bs) is v >> (64 - bs) that is also defined for bs == 0.
+	template <Merge M>
+	static constexpr void merge_shl(word_t *w, size_t len, size_t n)
+	{
+		const size_t ws = std::min(n / WORD_BITS, len);
+		const size_t bs = n % WORD_BITS;
+
+		if (ws < len && bs == 0) // whole words, e.g. padded rows moved vertically
+		{
+			for (size_t i = len - 1; i >= ws && i < len; --i)
+				merge<M>(w[i], w[i - ws]);
+		}
+		else if (ws < len)
+		{
+			for (size_t i = len - 1; i > ws; --i)
+				merge<M>(w[i], w[i - ws] << bs | (w[i - ws - 1] >> 1) >> (WORD_BITS - 1 - bs));
+			merge<M>(w[ws], w[0] << bs);
+		}
+		if constexpr (M != Merge::OR)
+			for (size_t i = 0; i < ws; ++i)
+				w[i] = 0;
+	}
+	template <Merge M>
+	static constexpr void merge_shr(word_t *w, size_t len, size_t n)
+	{
+		const size_t ws = std::min(n / WORD_BITS, len);
+		const size_t bs = n % WORD_BITS;
+
+		if (ws < len && bs == 0)
+		{
+			for (size_t i = 0; i + ws < len; ++i)
+				merge<M>(w[i], w[i + ws]);
+		}
+		else if (ws < len)
+		{
+			for (size_t i = 0; i + ws + 1 < len; ++i)
+				merge<M>(w[i], w[i + ws] >> bs | (w[i + ws + 1] << 1) << (WORD_BITS - 1 - bs));
+			merge<M>(w[len - ws - 1], w[len - 1] >> bs);
+		}
+		if constexpr (M != Merge::OR)
+			for (size_t i = len - ws; i < len; ++i)
+				w[i] = 0;
+	}
+
+	// Merges the matrix with itself moved right by dx columns
+	template <Merge M>
+	constexpr void merge_x(ptrdiff_t dx)
+	{
+		const size_t n = dx > 0 ? dx : -dx;
+
+		if (n >= W)
+		{
+			if constexpr (M != Merge::OR)
+				Opq();
+		}
+		else if constexpr (PACKED_ROWS || ROW_WORDS == 1)
+		{
+			// whole word at once, then drop what crossed into the neighbouring row or the padding
+			const word_t keep = PACKED_ROWS ? (dx > 0 ? (ROW_MASK << n) & ROW_MASK : ROW_MASK >> n) * ROW_REP : TAIL_MASK;
+			for (size_t i = 0; i < WORDS; ++i)
+				merge<M>(words[i], (dx > 0 ? words[i] << n : words[i] >> n) & keep);
+			if constexpr (PACKED_ROWS && !EXACT)
+				words[WORDS - 1] &= LAST_MASK;
+		}
+		else
+		{
+			for (size_t i = 0; i < WORDS; i += ROW_WORDS)
+			{
+				if (dx > 0)
+					merge_shl<M>(&words[i], ROW_WORDS, n);
+				else
+					merge_shr<M>(&words[i], ROW_WORDS, n);
+				words[i + ROW_WORDS - 1] &= TAIL_MASK;
+			}
+		}
+	}
+
+	// Merges the matrix with itself moved down by dy rows.
+	// Rows are ROW_BITS apart, so this is one shift of the whole array as a long number.
+	template <Merge M>
+	constexpr void merge_y(ptrdiff_t dy)
+	{
+		const size_t n = dy > 0 ? dy : -dy;
+
+		if (n >= H)
+		{
+			if constexpr (M != Merge::OR)
+				Opq();
+			return;
+		}
+
+		if (dy > 0)
+			merge_shl<M>(words.data(), WORDS, n * ROW_BITS);
+		else
+			merge_shr<M>(words.data(), WORDS, n * ROW_BITS);
+		words[WORDS - 1] &= valid(WORDS - 1);
+	}
+
+	constexpr void shift_x(ptrdiff_t dx)
+	{
+		merge_x<Merge::SET>(dx);
+	}
+
+	constexpr void shift_y(ptrdiff_t dy)
+	{
+		merge_y<Merge::SET>(dy);
+	}
+
+	// Word i of m moved by one column right (or left), with constant shifts
+	template <bool RIGHT>
+	static constexpr word_t col_neighbour(const words_t &m, size_t i)
+	{
+		if constexpr (PACKED_ROWS || ROW_WORDS == 1)
+		{
+			constexpr word_t keep = PACKED_ROWS ? (RIGHT ? (ROW_MASK << 1) & ROW_MASK : ROW_MASK >> 1) * ROW_REP : TAIL_MASK;
+			return (RIGHT ? m[i] << 1 : m[i] >> 1) & keep;
+		}
+		else
+		{
+			const size_t j = i % ROW_WORDS; // word within the row
+			if constexpr (RIGHT)
+				return (m[i] << 1 | (j ? m[i - 1] >> (WORD_BITS - 1) : 0)) & (j == ROW_WORDS - 1 ? TAIL_MASK : ~word_t(0));
+			else
+				return m[i] >> 1 | (j + 1 < ROW_WORDS ? m[i + 1] << (WORD_BITS - 1) : 0);
+		}
+	}
+
+	// Word i of m moved by one row down (or up), with constant shifts, padding not cleared
+	template <bool DOWN>
+	static constexpr word_t row_neighbour(const words_t &m, size_t i)
+	{
+		constexpr size_t ws = ROW_BITS / WORD_BITS;
+		constexpr size_t bs = ROW_BITS % WORD_BITS;
+		word_t v = 0;
+
+		if constexpr (DOWN)
+		{
+			if (i >= ws)
+				v = m[i - ws] << bs;
+			if constexpr (bs != 0)
+				if (i > ws)
+					v |= m[i - ws - 1] >> (WORD_BITS - bs);
+		}
+		else
+		{
+			if (i + ws < WORDS)
+				v = m[i + ws] >> bs;
+			if constexpr (bs != 0)
+				if (i + ws + 1 < WORDS)
+					v |= m[i + ws + 1] << (WORD_BITS - bs);
+		}
+		return v;
+	}
+
+	// Merges the matrix shifted by -r..r columns, r < W. When a row does not leave its word, every word
+	// runs all the doubling steps of both directions in a register, in one pass over the matrix.
+	template <Merge M>
+	constexpr void stretch_x(size_t r)
+	{
+		if constexpr (PACKED_ROWS || ROW_WORDS == 1)
+		{
+			std::array<size_t, WORD_BITS> steps; // at most log2(W) used
+			std::array<word_t, WORD_BITS> keep_r, keep_l;
+			size_t n = 0;
+			for (size_t covered = 1; covered <= r; ++n)
+			{
+				steps[n] = std::min(covered, r + 1 - covered);
+				keep_r[n] = PACKED_ROWS ? ((ROW_MASK << steps[n]) & ROW_MASK) * ROW_REP : TAIL_MASK;
+				keep_l[n] = PACKED_ROWS ? (ROW_MASK >> steps[n]) * ROW_REP : TAIL_MASK;
+				covered += steps[n];
+			}
+
+			for (size_t i = 0; i < WORDS; ++i)
+			{
+				word_t v = words[i];
+				for (size_t k = 0; k < n; ++k)
+					merge<M>(v, (v << steps[k]) & keep_r[k]);
+				for (size_t k = 0; k < n; ++k)
+					merge<M>(v, (v >> steps[k]) & keep_l[k]);
+				words[i] = v;
+			}
+		}
+		else
+		{
+			stretch<M>(false, r);
+			stretch<M>(false, -ptrdiff_t(r));
+		}
+	}
+
+	// Merges the matrix shifted by 0..|r| along one axis, in the direction of r.
+	// Each step doubles the covered segment, so a segment of length |r| + 1 takes ceil(log2(|r| + 1)) passes.
+	template <Merge M>
+	constexpr void stretch(bool vertical, ptrdiff_t r)
+	{
+		const size_t n = r > 0 ? r : -r;
+		const ptrdiff_t dir = r > 0 ? 1 : -1;
+
+		for (size_t covered = 1; covered <= n;)
+		{
+			const ptrdiff_t step = std::min(covered, n + 1 - covered);
+			covered += step;
+
+			if (vertical)
+				merge_y<M>(dir * step);
+			else
+				merge_x<M>(dir * step);
+		}
+	}
+
+	template <Merge M>
+	constexpr this_t &morph(char conn, size_t num)
+	{
+		if (conn == '8' || conn == 'o' || conn == 'O')
+		{
+			if (M == Merge::AND && num >= W) // every pixel has a neighbour outside
+				Opq();
+			else
+				stretch_x<M>(std::min(num, W - 1));
+
+			num = std::min(num, H); // beyond that the result no longer changes
+			stretch<M>(true, num);
+			stretch<M>(true, -ptrdiff_t(num));
+		}
+		else if (conn == '4' || conn == '+')
+		{
+			for (; num > 0; --num)
+			{
+				// whole cross in one pass over a copy, outside counts as 0
+				const words_t m = words;
+				bool changed = false;
+				for (size_t i = 0; i < WORDS; ++i)
+				{
+					word_t v = m[i];
+					merge<M>(v, col_neighbour<true>(m, i));
+					merge<M>(v, col_neighbour<false>(m, i));
+					merge<M>(v, row_neighbour<true>(m, i));
+					merge<M>(v, row_neighbour<false>(m, i));
+					v &= valid(i);
+
+					changed |= v != m[i];
+					words[i] = v;
+				}
+				if (!changed) // fixed point, e.g. empty or full
+					break;
+			}
+		}
+
+		return *this;
+	}
+};
@@ -1,9 +1,11 @@
-#ifndef MCP230XX_H
-#define MCP230XX_H
+#ifndef SegmentDisplay_H
+#define SegmentDisplay_H
 
 #include <cstdint>
+#include <cstddef>
 
-#include <vector>
+#include <initializer_list>
+#include <type_traits>
 
 // Enum-like structure defining the 7-segment display segments
 
@@ -47,11 +49,32 @@ namespace SegmentDisplay
 		DiagUpperLeft = 1 << 15,
 	};
 
+	// Function template to create custom char
+	template <typename ET = Default16Segment, typename T = uint16_t>
+	constexpr T custom_char_seg(std::initializer_list<ET> segs)
+	{
+		static_assert(std::is_integral<T>::value, "Return type must be an integer");
+		// static_assert(std::is_unsigned<T>::value, "Return type must be unsigned");
+
+		T aggr = 0;
+
+		for (ET seg : segs)
+			aggr |= static_cast<T>(seg);
+
+		return aggr;
+	}
+
+	// std::toupper is not constexpr
+	constexpr char to_upper(char c)
+	{
+		return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+	}
+
 	// Function template to map a character to a 7-segment bit pattern
 	template <typename ET = Default7Segment, typename T = uint8_t>
 	constexpr T char_to_7seg(char c)
 	{
-		c = std::toupper((unsigned char)c);
+		c = to_upper(c);
 
 		switch (c)
 		{
@@ -89,6 +112,8 @@ namespace SegmentDisplay
 		case 'F':
 			return custom_char_seg<ET, T>({ET::Top, ET::LowerLeft, ET::UpperLeft, ET::Middle});
 
+		case '-':
+			return custom_char_seg<ET, T>({ET::Middle});
 		case ' ':
 			return custom_char_seg<ET, T>({});
 
@@ -97,11 +122,11 @@ namespace SegmentDisplay
 		}
 	}
 
-	// Function template to map a character to a 7-segment bit pattern
+	// Function template to map a character to a 16-segment bit pattern
 	template <typename ET = Default16Segment, typename T = uint16_t>
 	constexpr T char_to_16seg(char c)
 	{
-		c = std::toupper((unsigned char)c);
+		c = to_upper(c);
 
 		switch (c)
 		{
@@ -170,7 +195,7 @@ namespace SegmentDisplay
 		case 'T':
 			return custom_char_seg<ET, T>({ET::TopLeft, ET::TopRight, ET::UpperCenter, ET::LowerCenter});
 		case 'U':
-			return custom_char_seg<ET, T>({ | ET::UpperRight, ET::LowerRight, ET::BottomLeft, ET::BottomRight, ET::LowerLeft, ET::UpperLeft});
+			return custom_char_seg<ET, T>({ET::UpperRight, ET::LowerRight, ET::BottomLeft, ET::BottomRight, ET::LowerLeft, ET::UpperLeft});
 		//
 		case 'V':
 			return custom_char_seg<ET, T>({ET::LowerLeft, ET::UpperLeft, ET::DiagLowerLeft, ET::DiagUpperRight});
@@ -183,6 +208,8 @@ namespace SegmentDisplay
 		case 'Z':
 			return custom_char_seg<ET, T>({ET::TopLeft, ET::TopRight, ET::DiagUpperRight, ET::DiagLowerLeft, ET::BottomLeft, ET::BottomRight});
 
+		case '-':
+			return custom_char_seg<ET, T>({ET::MiddleLeft, ET::MiddleRight});
 		case ' ':
 			return custom_char_seg<ET, T>({});
 
@@ -191,21 +218,23 @@ namespace SegmentDisplay
 		}
 	}
 
-	// Function template to create custom char
-	template <typename ET = Default16Segment, typename T = uint16_t>
-	constexpr T custom_char_seg(const std::vector<ET> &segs)
-	{
-		static_assert(std::is_integral<T>::value, "Return type must be an integer");
-		// static_assert(std::is_unsigned<T>::value, "Return type must be unsigned");
-
-		T aggr = 0;
+	// Characters a font table holds, indexed by ASCII code (AssetFormat::GLYPHS)
+	constexpr size_t FONT_GLYPHS = 128;
 
-		for (ET seg : segs)
-			aggr |= static_cast<T>(seg);
-
-		return aggr;
+	// Pattern of c from a font table (e.g. AssetBundle::font()), the built-in table above without one
+	template <typename ET = Default7Segment, typename T = uint8_t>
+	constexpr T char_to_7seg(const uint16_t *font, char c)
+	{
+		const unsigned char i = c;
+		return font && i < FONT_GLYPHS ? static_cast<T>(font[i]) : char_to_7seg<ET, T>(c);
 	}
 
+	template <typename ET = Default16Segment, typename T = uint16_t>
+	constexpr T char_to_16seg(const uint16_t *font, char c)
+	{
+		const unsigned char i = c;
+		return font && i < FONT_GLYPHS ? static_cast<T>(font[i]) : char_to_16seg<ET, T>(c);
+	}
 }
 
 #endif
@@ -0,0 +1,264 @@
+#ifndef SensorHistory_H
+#define SensorHistory_H
+
+#include <cstdint>
+#include <cassert>
+#include <cmath>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "BME280.h"
+
+// Sliding window over N quantised samples.
+// min/max are kept in monotonic deques of ring positions (amortised O(1) insert, O(1) query),
+// mean and least-squares slope from exact integer running sums (O(1) insert and query).
+template <size_t N>
+class RollingWindow
+{
+	static_assert(N >= 2, "Window must hold at least 2 samples!");
+
+public:
+	using sample_t = int16_t;
+	using pos_t = std::conditional_t<(N <= std::numeric_limits<uint16_t>::max()), uint16_t, uint32_t>;
+
+private:
+	// Fixed-capacity deque of ring positions, no heap
+	class PosDeque
+	{
+		std::array<pos_t, N> buf;
+		size_t first = 0;
+		size_t len = 0;
+
+	public:
+		bool empty() const { return len == 0; }
+		pos_t front() const { return buf[first]; }
+		pos_t back() const { return buf[(first + len - 1) % N]; }
+		void push_back(pos_t p) { buf[(first + len++) % N] = p; }
+		void pop_front()
+		{
+			first = (first + 1) % N;
+			--len;
+		}
+		void pop_back() { --len; }
+		void clear() { first = len = 0; }
+	};
+
+	std::array<sample_t, N> ring;
+	size_t head = 0; // next write position
+	size_t count = 0;
+
+	PosDeque min_q;
+	PosDeque max_q;
+
+	int64_t sum_y = 0;	// sum of y_i
+	int64_t sum_iy = 0; // sum of i * y_i, i = 0 for the oldest sample
+
+public:
+	RollingWindow() = default;
+	~RollingWindow() = default;
+
+	void push(sample_t y)
+	{
+		if (count == N) // evict the oldest sample, which sits where we are about to write
+		{
+			const sample_t y0 = ring[head];
+
+			if (min_q.front() == head)
+				min_q.pop_front();
+			if (max_q.front() == head)
+				max_q.pop_front();
+
+			sum_y -= y0;
+			sum_iy -= sum_y; // every remaining sample moves one position towards the oldest
+			--count;
+		}
+
+		ring[head] = y;
+
+		while (!min_q.empty() && ring[min_q.back()] >= y)
+			min_q.pop_back();
+		min_q.push_back(head);
+
+		while (!max_q.empty() && ring[max_q.back()] <= y)
+			max_q.pop_back();
+		max_q.push_back(head);
+
+		sum_iy += static_cast<int64_t>(count) * y;
+		sum_y += y;
+		++count;
+
+		head = (head + 1) % N;
+	}
+
+	void clear()
+	{
+		head = count = 0;
+		min_q.clear();
+		max_q.clear();
+		sum_y = sum_iy = 0;
+	}
+
+	size_t size() const { return count; }
+	static constexpr size_t capacity() { return N; }
+	bool empty() const { return count == 0; }
+
+	// age 0 is the newest sample
+	sample_t at(size_t age) const
+	{
+		assert(age < count);
+		return ring[(head + N - 1 - age) % N];
+	}
+
+	// Not on an empty window
+	sample_t min() const
+	{
+		assert(!empty());
+		return ring[min_q.front()];
+	}
+	sample_t max() const
+	{
+		assert(!empty());
+		return ring[max_q.front()];
+	}
+
+	// NaN on an empty window
+	float mean() const
+	{
+		if (empty())
+			return std::numeric_limits<float>::quiet_NaN();
+
+		return static_cast<float>(sum_y) / count;
+	}
+
+	// Least-squares slope in quanta per sample, 0 with fewer than 2 samples
+	float slope() const
+	{
+		if (count < 2)
+			return 0;
+
+		const int64_t n = count;
+		const int64_t sum_i = n * (n - 1) / 2;
+		const int64_t sum_ii = (n - 1) * n * (2 * n - 1) / 6;
+
+		const int64_t num = n * sum_iy - sum_i * sum_y;
+		const int64_t den = n * sum_ii - sum_i * sum_i;
+
+		return static_cast<float>(num) / static_cast<float>(den);
+	}
+};
+
+//
+
+// Quantised BME280 history, default 24 h at 1 sample per minute.
+// Temperature: 0.01 DegC, pressure: 2 Pa around 70 kPa, humidity: 0.01 %RH.
+template <size_t N = 24 * 60>
+class SensorHistory
+{
+public:
+	enum class Channel : uint8_t
+	{
+		TEMPERATURE = 0,
+		PRESSURE,
+		HUMIDITY,
+	};
+
+	using window_t = RollingWindow<N>;
+	using sample_t = typename window_t::sample_t;
+
+private:
+	struct Quant
+	{
+		float offset;
+		float step;
+	};
+
+	static constexpr std::array<Quant, 3> quant = {{
+		{0.0f, 0.01f},	   // DegC
+		{70000.0f, 2.0f},  // Pa
+		{0.0f, 0.01f},	   // %RH
+	}};
+
+	std::array<window_t, 3> windows;
+
+public:
+	SensorHistory() = default;
+	~SensorHistory() = default;
+
+	void push(const BME280::Meas &meas)
+	{
+		windows[0].push(quantise(Channel::TEMPERATURE, meas.temperature));
+		windows[1].push(quantise(Channel::PRESSURE, meas.pressure));
+		windows[2].push(quantise(Channel::HUMIDITY, meas.humidity));
+	}
+
+	void clear()
+	{
+		for (window_t &w : windows)
+			w.clear();
+	}
+
+	size_t size() const { return windows[0].size(); }
+	static constexpr size_t capacity() { return N; }
+	bool empty() const { return windows[0].empty(); }
+
+	BME280::Meas at(size_t age) const
+	{
+		BME280::Meas meas;
+		meas.temperature = dequantise(Channel::TEMPERATURE, windows[0].at(age));
+		meas.pressure = dequantise(Channel::PRESSURE, windows[1].at(age));
+		meas.humidity = dequantise(Channel::HUMIDITY, windows[2].at(age));
+		return meas;
+	}
+
+	// min, max and mean are NaN while the history is empty
+	float min(Channel c) const
+	{
+		if (empty())
+			return std::numeric_limits<float>::quiet_NaN();
+
+		return dequantise(c, window(c).min());
+	}
+	float max(Channel c) const
+	{
+		if (empty())
+			return std::numeric_limits<float>::quiet_NaN();
+
+		return dequantise(c, window(c).max());
+	}
+	float mean(Channel c) const
+	{
+		if (empty())
+			return std::numeric_limits<float>::quiet_NaN();
+
+		const Quant &q = quant[static_cast<size_t>(c)];
+		return q.offset + q.step * window(c).mean();
+	}
+	// Unit per sample period
+	float slope(Channel c) const
+	{
+		return quant[static_cast<size_t>(c)].step * window(c).slope();
+	}
+
+	const window_t &window(Channel c) const
+	{
+		return windows[static_cast<size_t>(c)];
+	}
+
+private:
+	static sample_t quantise(Channel c, float value)
+	{
+		const Quant &q = quant[static_cast<size_t>(c)];
+		const float v = std::round((value - q.offset) / q.step);
+		return static_cast<sample_t>(std::clamp<float>(v, std::numeric_limits<sample_t>::min(), std::numeric_limits<sample_t>::max()));
+	}
+
+	static float dequantise(Channel c, sample_t raw)
+	{
+		const Quant &q = quant[static_cast<size_t>(c)];
+		return q.offset + q.step * raw;
+	}
+};
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef SensorHub_H
+#define SensorHub_H
+
+#include <cstdint>
+#include <array>
+#include <algorithm>
+
+#include <esp_log.h>
+#include <esp_check.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+#include "BME280.h"
+
+// Drives any number of BME280s, whichever bus they sit on (SPI or I2C).
+// Every round triggers all conversions back to back, sleeps once for the longest one,
+// then collects all results, so the sensors convert in parallel and adding one costs
+// only its two short bus transfers. Samples leave through a single queue, which drops the
+// oldest sample when the consumer falls behind (counted by get_dropped()).
+template <size_t MAX_SENSORS = 4>
+class SensorHub
+{
+	static constexpr const char *const TAG = "SensorHub";
+
+	static_assert(MAX_SENSORS <= 32, "round() keeps the triggered sensors in a uint32_t!");
+
+public:
+	struct Sample
+	{
+		int64_t timestamp; // us since boot, taken when the conversion was triggered
+		uint8_t sensor;	   // index returned by add()
+		BME280::Meas meas;
+	};
+
+private:
+	std::array<BME280 *, MAX_SENSORS> sensors = {};
+	size_t count = 0;
+
+	uint32_t period_ms;
+	size_t queue_len;
+
+	QueueHandle_t queue = nullptr;
+	TaskHandle_t task = nullptr;
+	volatile bool exit_flag = false;
+
+	volatile uint32_t drops = 0; // oldest samples overwritten because the consumer fell behind
+
+public:
+	SensorHub(uint32_t pms = 1000, size_t ql = 16) : period_ms(pms), queue_len(ql)
+	{
+	}
+	~SensorHub() = default;
+
+	// Sensors must be initialised, configured and must outlive the hub
+	esp_err_t add(BME280 &sensor, uint8_t *index = nullptr)
+	{
+		ESP_RETURN_ON_FALSE(
+			!task,
+			ESP_ERR_INVALID_STATE, TAG, "Cannot add sensors while running!");
+
+		ESP_RETURN_ON_FALSE(
+			count < MAX_SENSORS,
+			ESP_ERR_NO_MEM, TAG, "Too many sensors!");
+
+		if (index)
+			*index = count;
+		sensors[count++] = &sensor;
+
+		return ESP_OK;
+	}
+
+	esp_err_t init(UBaseType_t prio, BaseType_t core, uint32_t stack = 4 * 1024)
+	{
+		assert(!task);
+
+		queue = xQueueCreate(queue_len, sizeof(Sample));
+		ESP_RETURN_ON_FALSE(
+			queue,
+			ESP_ERR_NO_MEM, TAG, "Failed to xQueueCreate!");
+
+		exit_flag = false;
+
+		ESP_RETURN_ON_FALSE(
+			xTaskCreatePinnedToCore(task_fn, "SensorHub", stack, this, prio, &task, core),
+			ESP_ERR_NO_MEM, TAG, "Failed to xTaskCreatePinnedToCore!");
+
+		return ESP_OK;
+	}
+
+	// Safe after a failed or without any init()
+	esp_err_t deinit()
+	{
+		exit_flag = true;
+
+		while (task)
+			vTaskDelay(10); // 10 RTOS ticks
+
+		if (queue)
+		{
+			vQueueDelete(queue);
+			queue = nullptr;
+		}
+
+		return ESP_OK;
+	}
+
+	bool receive(Sample &out, TickType_t wait = 0)
+	{
+		return queue && xQueueReceive(queue, &out, wait) == pdTRUE;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	uint32_t get_dropped() const
+	{
+		return drops;
+	}
+
+private:
+	void round()
+	{
+		const int64_t timestamp = esp_timer_get_time();
+		uint32_t wait_us = 0;
+		uint32_t triggered = 0; // bit i: sensor i has a conversion of this round to collect
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			BME280 &s = *sensors[i];
+
+			if (s.trigger() != ESP_OK)
+				continue;
+
+			triggered |= 1u << i;
+			if (!s.is_continuous())
+				wait_us = std::max(wait_us, s.meas_period());
+		}
+
+		if (wait_us)
+			vTaskDelay(pdMS_TO_TICKS((wait_us + 999) / 1000) + 1); // yield instead of busy waiting
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!(triggered & 1u << i)) // in forced mode its registers still hold the previous round
+				continue;
+
+			Sample sample;
+			sample.timestamp = timestamp;
+			sample.sensor = i;
+
+			if (sensors[i]->collect(sample.meas) != ESP_OK)
+				continue;
+
+			if (xQueueSend(queue, &sample, 0) != pdTRUE)
+			{
+				// Full, the consumer is behind: the oldest sample makes room, newest data wins
+				Sample oldest;
+				xQueueReceive(queue, &oldest, 0);
+				xQueueSend(queue, &sample, 0);
+				drops = drops + 1;
+			}
+		}
+	}
+
+	static void task_fn(void *arg)
+	{
+		SensorHub *self = static_cast<SensorHub *>(arg);
+		TickType_t last_wake = xTaskGetTickCount();
+
+		ESP_LOGI(TAG, "Starting with %u sensors...", unsigned(self->count));
+
+		while (!self->exit_flag)
+		{
+			self->round();
+			xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(self->period_ms));
+		}
+
+		ESP_LOGI(TAG, "Exiting...");
+
+		self->task = nullptr;
+		vTaskDelete(nullptr);
+		// *dies*
+	}
+};
+
+#endif
@@ -1,7 +1,10 @@
 #ifndef Processing_H
 #define Processing_H
 
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <array>
 
 class Hysteresis
 {
@@ -54,7 +57,10 @@ public:
 		if (value == state)
 			curr_cont = 0;
 		else if (++curr_cont >= req_cont)
+		{
 			state = value;
+			curr_cont = 0;
+		}
 
 		return state;
 	}
@@ -104,4 +110,84 @@ public:
 	}
 };
 
+// BoolLowpass for every bit of T at once: a vertical counter (bit b of every channel's counter lives in cnt[b])
+// counts consecutive samples that differ from the state, any agreeing sample clears it.
+// A few bitwise ops per plane per sample for all channels, no branches. req_cont must fit in BITS bits.
+template <typename T = uint16_t, size_t BITS = 3>
+class BoolLowpassBank
+{
+private:
+	T req_mask[BITS]; // all ones where bit b of req_cont is set
+
+	mutable std::array<T, BITS> cnt = {};
+	mutable T state;
+
+public:
+	BoolLowpassBank(size_t rs = 1, T s = 0) : state(s)
+	{
+		rs = rs ? rs : 1;
+		assert(rs < (size_t(1) << BITS));
+		for (size_t b = 0; b < BITS; ++b)
+			req_mask[b] = (rs >> b) & 1 ? T(~T(0)) : T(0);
+	}
+	~BoolLowpassBank()
+	{
+	}
+
+	T evaluate(T value) const
+	{
+		const T diff = value ^ state;
+
+		// cnt = diff ? cnt + 1 : 0
+		T carry = diff;
+		for (size_t b = 0; b < BITS; ++b)
+		{
+			const T c = cnt[b];
+			cnt[b] = (c ^ carry) & diff;
+			carry &= c;
+		}
+
+		// flip the channels whose counter reached req_cont, and restart them
+		T flip = diff;
+		for (size_t b = 0; b < BITS; ++b)
+			flip &= ~(cnt[b] ^ req_mask[b]);
+
+		state ^= flip;
+		for (size_t b = 0; b < BITS; ++b)
+			cnt[b] &= ~flip;
+
+		return state;
+	}
+};
+
+// PosEdge and NegEdge for every bit of T at once, masks match SmartTouch::touch_pe/touch_ne
+template <typename T = uint16_t>
+class EdgeBank
+{
+private:
+	mutable T prev;
+
+public:
+	mutable T pe = 0;
+	mutable T ne = 0;
+
+public:
+	EdgeBank(T p = 0) : prev(p)
+	{
+	}
+	~EdgeBank()
+	{
+	}
+
+	// Returns pe | ne, the channels that changed
+	T evaluate(T value) const
+	{
+		pe = value & ~prev;
+		ne = ~value & prev;
+		prev = value;
+
+		return pe | ne;
+	}
+};
+
 #endif
\ No newline at end of file
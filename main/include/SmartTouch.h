@@ -1,7 +1,7 @@
 #ifndef SmartTouch_H
 #define SmartTouch_H
 
-// #include <cmath>
+#include <cmath>
 
 #include <atomic>
 #include <algorithm>
@@ -10,32 +10,71 @@
 
 #include <esp_log.h>
 #include <esp_check.h>
+#include <esp_timer.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
 #include <driver/touch_pad.h>
+#include <rom/ets_sys.h>
+#include <nvs.h>
+
+#include "Filters.h"
 
 class SmartTouch
 {
 	static constexpr const char *const TAG = "SmartTouch";
 
 private:
-	static std::atomic<size_t> InstanceCount;
+	static inline std::atomic<size_t> InstanceCount = 0;
 
 private:
 	static constexpr float ALPHA = 0.01f;	   // Smoothing factor
+	static constexpr float NOISE_ALPHA = 0.1f; // Variance attack on readings above the learnable range
 	static constexpr size_t NUM_SAMPLES = 100; // Buffer size for init mean/std calculation
+	static constexpr float HYSTERESIS = 0.5f;  // a touch ends above this fraction of the margin below the baseline
+	static constexpr uint8_t CONFIRM = 5;	   // consecutive readings below thr_on before a touch starts, poll mode
+
+	// FSM calibration: all pads are sampled every FSM cycle, stop once the baseline is known well enough
+	static constexpr uint16_t CAL_INTERVAL = 0x80;	   // FSM sleep cycles (150 kHz) while calibrating, ~0.85 ms
+	static constexpr uint16_t CAL_CLOCK_CYCLES = 0x2000; // measurement per pad (8 MHz) while calibrating, ~1 ms
+	static constexpr size_t CAL_MIN_SAMPLES = 8;	   // before the convergence check
+	static constexpr size_t CAL_VERIFY_SAMPLES = 4;	   // to accept a baseline seeded from NVS
+	static constexpr float CAL_TOLERANCE = 0.001f;	   // standard error of the mean, relative to the mean
+	static constexpr uint32_t CAL_SEED_COUNT = 1 / ALPHA; // seeded baseline is treated as fully learned
+
+	static constexpr const char *const NVS_NAMESPACE = "touch";
+	static constexpr const char *const NVS_KEY = "baseline";
 
-	// TOUCH_PAD_MAX
+	// Per channel state, structure of arrays over TOUCH_PAD_MAX, indexed by pad number
 	std::array<float, TOUCH_PAD_MAX> mean = {0};
-	// std::array<float, N> variance = {0};
+	std::array<float, TOUCH_PAD_MAX> variance = {0};
+	std::array<uint32_t, TOUCH_PAD_MAX> count = {0};
+
+	std::array<float, TOUCH_PAD_MAX> sample = {0};
+	std::array<float, TOUCH_PAD_MAX> thr_on = {0};	// below: touch starts
+	std::array<float, TOUCH_PAD_MAX> thr_off = {0}; // above: touch ends, between thr_on and the baseline
+	std::array<float, TOUCH_PAD_MAX> thr_max = {0}; // at or below: full touch, touch_analog only
+	std::array<float, TOUCH_PAD_MAX> thr_neg = {0}; // above: outlier, not learned
+	std::array<uint8_t, TOUCH_PAD_MAX> below = {0}; // consecutive readings below thr_on
+
+	// Poll mode reads raw samples, single-sample spikes are removed before detection and learning.
+	// FSM mode reads the output of the hardware IIR filter instead.
+	std::array<Median<float, 3>, TOUCH_PAD_MAX> despike;
 
 	const std::vector<touch_pad_t> touch_pins;
+	uint16_t pin_mask = 0;
 
 	float min_thresh;
 	float max_thresh;
 	float neg_thresh;
+	float k_sigma;
+
+	// Hardware FSM mode, pads are measured in the background and filtered by the IIR
+	bool fsm = false;
+	TaskHandle_t notify_task = nullptr;
+	std::atomic<uint32_t> isr_status = 0;
+	std::atomic<int64_t> isr_time = 0; // first interrupt since the last take, us since boot
 
 public:
 	std::array<float, TOUCH_PAD_MAX> touch_analog;
@@ -45,8 +84,12 @@ public:
 	uint16_t touch_ne = 0;
 
 public:
-	SmartTouch(const std::vector<touch_pad_t> &pins, float mt = 3, float Mt = 10, float nt = 0.5) : touch_pins(pins), min_thresh(mt / 100), max_thresh(Mt / 100), neg_thresh(nt / 100)
+	// mt, Mt, nt in % of the baseline, mt and nt are floors for the noise-following k * sigma margins,
+	// Mt is the reading that gives touch_analog = 1
+	SmartTouch(const std::vector<touch_pad_t> &pins, float mt = 3, float Mt = 10, float nt = 0.5, float k = 5) : touch_pins(pins), min_thresh(mt / 100), max_thresh(Mt / 100), neg_thresh(nt / 100), k_sigma(k)
 	{
+		for (touch_pad_t pin : touch_pins)
+			pin_mask |= BIT(pin);
 	}
 
 	~SmartTouch()
@@ -70,62 +113,154 @@ public:
 
 		vTaskDelay(pdMS_TO_TICKS(500)); // Allow stabilization
 
-		// Initial sampling
 		for (touch_pad_t pin : touch_pins)
 		{
-			for (size_t j = 0; j < NUM_SAMPLES; j++)
-			{
-				uint16_t sample = 0;
-				ESP_RETURN_ON_ERROR(
-					touch_pad_read(pin, &sample),
-					TAG, "Failed to touch_pad_read!");
+			uint16_t raw = 0;
+			ESP_RETURN_ON_ERROR(
+				touch_pad_read(pin, &raw),
+				TAG, "Failed to touch_pad_read!");
 
-				update_stats(pin, sample);
-			}
+			despike[pin].reset(raw);
+		}
+
+		// Initial sampling
+		for (size_t j = 0; j < NUM_SAMPLES; j++)
+		{
+			ESP_RETURN_ON_ERROR(
+				read_samples(),
+				TAG, "Failed to read_samples!");
+
+			update_stats(pin_mask);
 		}
 
 		return ESP_OK;
 	}
 
+	// FSM timer mode: no blocking reads, threshold interrupts notify `task` (eSetBits with the pad mask) on touch.
+	// test_pins() then only picks up the latest filtered values, update_baseline() should run at a low rate.
+	esp_err_t init_fsm(TaskHandle_t task, uint32_t filter_period_ms = 10)
+	{
+		notify_task = task;
+
+		for (touch_pad_t pin : touch_pins)
+			ESP_RETURN_ON_ERROR(
+				touch_pad_config(pin, 0),
+				TAG, "Failed to touch_pad_config!");
+
+		ESP_RETURN_ON_ERROR(
+			touch_pad_set_fsm_mode(TOUCH_FSM_MODE_TIMER),
+			TAG, "Failed to touch_pad_set_fsm_mode!");
+
+		ESP_RETURN_ON_ERROR(
+			touch_pad_filter_start(filter_period_ms),
+			TAG, "Failed to touch_pad_filter_start!");
+
+		fsm = true;
+
+		ESP_RETURN_ON_ERROR(
+			calibrate(),
+			TAG, "Failed to calibrate!");
+
+		ESP_RETURN_ON_ERROR(
+			update_thresholds(),
+			TAG, "Failed to update_thresholds!");
+
+		ESP_RETURN_ON_ERROR(
+			touch_pad_set_trigger_mode(TOUCH_TRIGGER_BELOW),
+			TAG, "Failed to touch_pad_set_trigger_mode!");
+
+		ESP_RETURN_ON_ERROR(
+			touch_pad_isr_register(touch_isr, this),
+			TAG, "Failed to touch_pad_isr_register!");
+
+		ESP_RETURN_ON_ERROR(
+			touch_pad_intr_enable(),
+			TAG, "Failed to touch_pad_intr_enable!");
+
+		return ESP_OK;
+	}
+
 	esp_err_t deinit()
 	{
 		// ESP_RETURN_ON_ERROR(
 		// 	Deinit(),
 		// 	TAG, "Failed to Deinit!");
 
+		if (fsm)
+		{
+			touch_pad_intr_disable();
+			touch_pad_isr_deregister(touch_isr, this);
+			touch_pad_filter_stop();
+			fsm = false;
+		}
+
 		return ESP_OK;
 	}
 
-	esp_err_t test_pins()
+	// Persist the baseline so the next boot can start from it, call rarely (flash wear)
+	esp_err_t save_baseline()
 	{
-		uint16_t touch_new = 0;
+		nvs_handle_t nvs_hdl;
+		Baseline bl;
 
-		for (touch_pad_t pin : touch_pins)
-		{
-			const float mt = mean[pin] * (1 - min_thresh);
-			const float Mt = mean[pin] * (0 + max_thresh);
-			const float nt = mean[pin] * (1 + neg_thresh);
-			const float range = mt - Mt;
+		bl.mean = mean;
+		bl.variance = variance;
 
-			uint16_t sample = 0;
+		ESP_RETURN_ON_ERROR(
+			nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_hdl),
+			TAG, "Failed to nvs_open!");
 
-			ESP_RETURN_ON_ERROR(
-				touch_pad_read(pin, &sample),
-				TAG, "Failed to touch_pad_read!");
+		esp_err_t ret = nvs_set_blob(nvs_hdl, NVS_KEY, &bl, sizeof(bl));
+		if (ret == ESP_OK)
+			ret = nvs_commit(nvs_hdl);
+		nvs_close(nvs_hdl);
+
+		return ret;
+	}
+
+	// Pads that crossed their interrupt threshold since the last call (FSM mode), optionally when the first one did
+	uint16_t take_isr_status(int64_t *time = nullptr)
+	{
+		if (time)
+			*time = isr_time.load();
+		return isr_status.exchange(0);
+	}
+
+	// EWMA baseline update off the filtered values, for pads that are not touched (FSM mode)
+	esp_err_t update_baseline()
+	{
+		ESP_RETURN_ON_ERROR(
+			read_samples(),
+			TAG, "Failed to read_samples!");
 
-			float meas = sample;
-			meas = std::clamp(meas, Mt, mt);
-			float analog = 1 - (meas - Mt) / range;
+		update_stats(learnable() & ~touch_on, noisy());
 
-			ESP_LOGI(TAG, "Mean: %f, New: %hu, clamp: %f, anal: %f", mean[pin], sample, meas, analog);
+		return update_thresholds();
+	}
 
-			touch_analog[pin] = analog;
-			if (analog >= 0.5) // Check if touch detected //
-				touch_new |= BIT(pin);
+	esp_err_t test_pins()
+	{
+		ESP_RETURN_ON_ERROR(
+			read_samples(),
+			TAG, "Failed to read_samples!");
 
-			if (sample > mt && sample < nt) // Check if in permissible range //
-				update_stats(pin, sample);
+		uint16_t touch_new = 0;
+
+		for (size_t i = 0; i < TOUCH_PAD_MAX; ++i)
+		{
+			const float range = thr_on[i] - thr_max[i];
+			const float meas = std::clamp(sample[i], thr_max[i], thr_on[i]);
+
+			touch_analog[i] = range > 0 ? 1 - (meas - thr_max[i]) / range : 0;
+
+			// FSM readings are IIR filtered already and a press is read once, when its interrupt arrives
+			below[i] = sample[i] < thr_on[i] ? std::min<uint8_t>(below[i] + 1, CONFIRM) : 0;
+			touch_new |= (touch_on & BIT(i) ? sample[i] < thr_off[i] : below[i] >= (fsm ? 1 : CONFIRM)) << i;
 		}
+		touch_new &= pin_mask;
+
+		if (!fsm) // FSM mode learns in update_baseline //
+			update_stats(learnable() & ~touch_new, noisy());
 
 		touch_pe = touch_new & ~touch_on;
 		touch_ne = ~touch_new & touch_on;
@@ -134,14 +269,315 @@ public:
 		return ESP_OK;
 	}
 
+	float get_mean(touch_pad_t pin) const
+	{
+		return mean[pin];
+	}
+	float get_sigma(touch_pad_t pin) const
+	{
+		return std::sqrt(variance[pin]);
+	}
+	// Touch starts below this, also the interrupt threshold in FSM mode
+	float get_threshold(touch_pad_t pin) const
+	{
+		return thr_on[pin];
+	}
+
 private:
-	void update_stats(touch_pad_t pin, uint16_t sample)
+	struct Baseline
+	{
+		std::array<float, TOUCH_PAD_MAX> mean;
+		std::array<float, TOUCH_PAD_MAX> variance;
+	};
+
+	esp_err_t load_baseline()
+	{
+		nvs_handle_t nvs_hdl;
+		Baseline bl;
+		size_t len = sizeof(bl);
+
+		esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_hdl);
+		if (ret == ESP_ERR_NVS_NOT_FOUND) // nothing saved yet, save_baseline() creates the namespace
+			return ret;
+		ESP_RETURN_ON_ERROR(ret, TAG, "Failed to nvs_open!");
+
+		ret = nvs_get_blob(nvs_hdl, NVS_KEY, &bl, &len);
+		nvs_close(nvs_hdl);
+
+		if (ret != ESP_OK)
+			return ret;
+		if (len != sizeof(bl))
+			return ESP_ERR_INVALID_SIZE;
+
+		for (touch_pad_t pin : touch_pins)
+			if (bl.mean[pin] <= 0) // pad was not in use when saved
+				return ESP_ERR_NOT_FOUND;
+
+		mean = bl.mean;
+		variance = bl.variance;
+		for (touch_pad_t pin : touch_pins)
+			count[pin] = CAL_SEED_COUNT;
+
+		update_stats(0); // thresholds only
+		return ESP_OK;
+	}
+
+	bool converged() const
+	{
+		for (touch_pad_t pin : touch_pins)
+			if (variance[pin] > count[pin] * (CAL_TOLERANCE * mean[pin]) * (CAL_TOLERANCE * mean[pin]))
+				return false;
+		return true;
+	}
+
+	void reset_stats()
+	{
+		mean = {};
+		variance = {};
+		count = {};
+	}
+
+	// Sample all pads together on every FSM cycle, with the FSM sped up for the duration: a short sleep and a
+	// CAL_CLOCK_CYCLES measurement, whose readings are scaled up to the normal measurement time.
+	// A seeded baseline is accepted once a few samples agree with it, otherwise learn from scratch
+	// until the standard error of every mean is below CAL_TOLERANCE.
+	// A cycle takes ~0.85 ms + ~1 ms per pad and every sample waits for a fresh one, so the time is linear in the
+	// number of pads: from scratch (CAL_MIN_SAMPLES) ~15 ms for 1 pad and ~90 ms for all 10, seeded half that.
+	// The shorter measurement counts less, so quantisation adds to sigma until the EWMA has relearned it.
+	esp_err_t calibrate()
+	{
+		uint16_t interval = 0;
+		uint16_t clock_cycles = 0;
+
+		ESP_RETURN_ON_ERROR(
+			touch_pad_get_measurement_interval(&interval),
+			TAG, "Failed to touch_pad_get_measurement_interval!");
+
+		ESP_RETURN_ON_ERROR(
+			touch_pad_get_measurement_clock_cycles(&clock_cycles),
+			TAG, "Failed to touch_pad_get_measurement_clock_cycles!");
+
+		const uint16_t cal_cycles = std::min(clock_cycles, CAL_CLOCK_CYCLES);
+
+		ESP_RETURN_ON_ERROR(
+			touch_pad_set_measurement_interval(CAL_INTERVAL),
+			TAG, "Failed to touch_pad_set_measurement_interval!");
+
+		esp_err_t ret = touch_pad_set_measurement_clock_cycles(cal_cycles);
+
+		// sleep at 150 kHz + measurement at 8 MHz per pad, pads are measured one after another
+		const uint32_t cycle_us = CAL_INTERVAL * 1000 / 150 + cal_cycles * touch_pins.size() / 8 + 1;
+
+		bool seeded = false;
+		if (ret == ESP_OK)
+			ret = calibrate_samples(cycle_us, float(clock_cycles) / cal_cycles, seeded);
+
+		// the normal timing is restored on failure too
+		ESP_RETURN_ON_ERROR(
+			touch_pad_set_measurement_clock_cycles(clock_cycles),
+			TAG, "Failed to touch_pad_set_measurement_clock_cycles!");
+
+		ESP_RETURN_ON_ERROR(
+			touch_pad_set_measurement_interval(interval),
+			TAG, "Failed to touch_pad_set_measurement_interval!");
+
+		ESP_RETURN_ON_ERROR(
+			ret,
+			TAG, "Failed to calibrate_samples!");
+
+		if (!seeded && save_baseline() != ESP_OK) // not fatal, next boot calibrates from scratch again
+			ESP_LOGW(TAG, "Failed to save_baseline!");
+
+		return ESP_OK;
+	}
+
+	esp_err_t calibrate_samples(uint32_t cycle_us, float scale, bool &seeded)
+	{
+		seeded = load_baseline() == ESP_OK;
+		bool done = false;
+		size_t agreed = 0;
+		size_t n = 0; // samples taken in
+
+		for (size_t attempt = 0; attempt < NUM_SAMPLES && !done; ++attempt)
+		{
+			ESP_RETURN_ON_ERROR(
+				wait_measurement(2 * cycle_us),
+				TAG, "Failed to wait_measurement!");
+
+			ESP_RETURN_ON_ERROR(
+				read_samples(true),
+				TAG, "Failed to read_samples!");
+
+			bool valid = true;
+			for (touch_pad_t pin : touch_pins)
+			{
+				valid &= sample[pin] > 0; // register not latched yet
+				sample[pin] = (sample[pin] + 0.5f) * scale - 0.5f; // readings count whole cycles, both scales truncate
+			}
+			if (!valid)
+				continue;
+
+			++n;
+			if (seeded)
+			{
+				if (learnable() != pin_mask) // pad held or environment changed, start over
+				{
+					seeded = false;
+					reset_stats();
+					update_stats(pin_mask);
+					n = 1;
+					continue;
+				}
+
+				update_stats(pin_mask);
+				done = ++agreed >= CAL_VERIFY_SAMPLES;
+			}
+			else
+			{
+				update_stats(pin_mask);
+				done = n >= CAL_MIN_SAMPLES && converged();
+			}
+		}
+
+		if (done)
+			ESP_LOGI(TAG, "Calibrated from %s in %u samples", seeded ? "NVS" : "scratch", unsigned(n));
+		else
+			ESP_LOGW(TAG, "Calibration did not converge in %u samples, continuing with the estimate", unsigned(n));
+
+		ESP_RETURN_ON_FALSE(
+			n > 0,
+			ESP_ERR_INVALID_RESPONSE, TAG, "No valid touch samples!");
+
+		return ESP_OK;
+	}
+
+	// Waits for the FSM to finish the next measurement cycle, so every read is a fresh sample
+	esp_err_t wait_measurement(uint32_t timeout_us)
+	{
+		static constexpr uint32_t POLL_US = 20;
+
+		bool started = !touch_pad_meas_is_done();
+		for (uint32_t t = 0; t < timeout_us; t += POLL_US)
+		{
+			const bool meas_done = touch_pad_meas_is_done();
+			if (started && meas_done)
+				return ESP_OK;
+
+			started |= !meas_done;
+			ets_delay_us(POLL_US);
+		}
+
+		return ESP_ERR_TIMEOUT;
+	}
+
+	esp_err_t read_samples(bool raw_data = false)
 	{
-		if (mean[pin] == 0) [[unlikely]]
-			mean[pin] = sample;
+		for (touch_pad_t pin : touch_pins)
+		{
+			uint16_t raw = 0;
+
+			if (fsm && raw_data)
+				ESP_RETURN_ON_ERROR(
+					touch_pad_read_raw_data(pin, &raw),
+					TAG, "Failed to touch_pad_read_raw_data!");
+			else if (fsm)
+				ESP_RETURN_ON_ERROR(
+					touch_pad_read_filtered(pin, &raw),
+					TAG, "Failed to touch_pad_read_filtered!");
+			else
+				ESP_RETURN_ON_ERROR(
+					touch_pad_read(pin, &raw),
+					TAG, "Failed to touch_pad_read!");
+
+			sample[pin] = fsm ? raw : despike[pin].evaluate(raw);
+		}
+
+		return ESP_OK;
+	}
+
+	// Pads whose sample is in the permissible range to be learned into the baseline
+	uint16_t learnable() const
+	{
+		uint16_t mask = 0;
+		for (size_t i = 0; i < TOUCH_PAD_MAX; ++i)
+			mask |= (sample[i] > thr_on[i] && sample[i] < thr_neg[i]) << i;
+		return mask & pin_mask;
+	}
+
+	// Pads reading above the learnable range. A touch only pulls the reading down, so this is noise (EMI) and
+	// its size goes into the variance, not the mean: sigma follows bursts instead of being capped by thr_neg.
+	uint16_t noisy() const
+	{
+		uint16_t mask = 0;
+		for (size_t i = 0; i < TOUCH_PAD_MAX; ++i)
+			mask |= (sample[i] >= thr_neg[i]) << i;
+		return mask & pin_mask;
+	}
+
+	esp_err_t update_thresholds()
+	{
+		for (touch_pad_t pin : touch_pins)
+			ESP_RETURN_ON_ERROR(
+				touch_pad_set_thresh(pin, thr_on[pin]),
+				TAG, "Failed to touch_pad_set_thresh!");
 
-		float delta = sample - mean[pin];
-		mean[pin] += ALPHA * delta; // Smoothed mean update
+		return ESP_OK;
+	}
+
+	static void IRAM_ATTR touch_isr(void *arg)
+	{
+		SmartTouch *self = static_cast<SmartTouch *>(arg);
+		const uint32_t status = touch_pad_get_status() & self->pin_mask;
+		touch_pad_clear_status();
+
+		if (!status)
+			return;
+
+		if (!self->isr_status.fetch_or(status))
+			self->isr_time = esp_timer_get_time();
+
+		BaseType_t high_task_awoken = pdFALSE;
+		if (self->notify_task)
+			xTaskNotifyFromISR(self->notify_task, status, eSetBits, &high_task_awoken);
+
+		if (high_task_awoken == pdTRUE)
+			portYIELD_FROM_ISR();
+	}
+
+	// Welford mean/variance for the first 1/ALPHA samples, exponentially weighted afterwards so it follows drift.
+	// One pass over all channels, then the thresholds follow: margin = max(k * sigma, percentage floor),
+	// a touch starts at mean - margin and ends at mean - HYSTERESIS * margin.
+	void update_stats(uint16_t mask, uint16_t noise = 0)
+	{
+		for (size_t i = 0; i < TOUCH_PAD_MAX; ++i)
+		{
+			if (noise & BIT(i) && count[i])
+			{
+				const float delta = sample[i] - mean[i];
+				variance[i] += NOISE_ALPHA * (delta * delta - variance[i]);
+			}
+
+			if (!(mask & BIT(i)))
+				continue;
+
+			count[i] = std::min<uint32_t>(count[i] + 1, 1 / ALPHA);
+			const float alpha = 1.0f / count[i];
+			const float delta = sample[i] - mean[i];
+
+			mean[i] += alpha * delta;
+			variance[i] = (1 - alpha) * (variance[i] + alpha * delta * delta);
+		}
+
+		for (size_t i = 0; i < TOUCH_PAD_MAX; ++i)
+		{
+			const float ks = k_sigma * std::sqrt(variance[i]);
+			const float margin = std::max(ks, mean[i] * min_thresh);
+
+			thr_max[i] = mean[i] * max_thresh;
+			thr_on[i] = std::max(mean[i] - margin, thr_max[i]);
+			thr_off[i] = std::max(mean[i] - HYSTERESIS * margin, thr_on[i]);
+			thr_neg[i] = mean[i] + std::max(ks, mean[i] * neg_thresh);
+		}
 	}
 
 	// static
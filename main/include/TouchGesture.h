@@ -0,0 +1,243 @@
+#ifndef TouchGesture_H
+#define TouchGesture_H
+
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include <array>
+
+#include <driver/touch_pad.h>
+
+// Per-pad gesture state machine fed with the SmartTouch edge masks (touch_pe/touch_ne) and timestamps.
+// Nothing is sampled here: update() only has to run on an edge or once next_deadline() has passed,
+// so the caller can sleep on the touch interrupt with next_deadline() as the timeout.
+//
+//   press + release < long_ms, no second press within double_ms   -> TAP (after double_ms)
+//   press + release < long_ms, second press + release < long_ms   -> DOUBLE_TAP (on the second release)
+//   press held for long_ms                                         -> LONG_PRESS, then REPEAT every repeat_ms (if not 0)
+//   release after LONG_PRESS                                       -> RELEASE
+//
+// With double_ms == 0 a TAP is emitted on release, without waiting for a possible second tap.
+class TouchGesture
+{
+public:
+	enum class Type : uint8_t
+	{
+		TAP,
+		DOUBLE_TAP,
+		LONG_PRESS,
+		REPEAT,
+		RELEASE,
+	};
+
+	struct Event
+	{
+		Type type;
+		touch_pad_t pad;
+		int64_t timestamp; // us, when the gesture became decidable (edge or timeout)
+		uint32_t latency;  // us, from timestamp until update() emitted it
+	};
+
+	static constexpr size_t QUEUE_LEN = 8;
+	static constexpr int64_t NEVER = INT64_MAX;
+
+private:
+	enum class State : uint8_t
+	{
+		IDLE,
+		PRESSED, // down, before long_ms
+		RELEASED, // up after one tap, waiting for a second press
+		SECOND, // down for the second time
+		HELD,	// down after LONG_PRESS
+	};
+
+	uint32_t double_ms; // max gap between the taps of a double tap
+	uint32_t long_ms;	// min hold time of a long press, taps are shorter
+	uint32_t repeat_ms; // auto-repeat period while held
+
+	std::array<State, TOUCH_PAD_MAX> state = {};
+	std::array<int64_t, TOUCH_PAD_MAX> deadline = {}; // us, next timeout of the state
+
+	std::array<Event, QUEUE_LEN> queue;
+	size_t q_head = 0;
+	size_t q_size = 0;
+
+	uint32_t latency_max = 0;
+	uint64_t latency_sum = 0;
+	uint32_t latency_cnt = 0;
+
+public:
+	TouchGesture(uint32_t dms = 250, uint32_t lms = 600, uint32_t rms = 150) : double_ms(dms), long_ms(lms), repeat_ms(rms)
+	{
+	}
+	~TouchGesture() = default;
+
+	// pe/ne as produced by SmartTouch::test_pins(), edge_us is when the edges happened (e.g. the ISR time), now_us is the current time
+	void update(uint16_t pe, uint16_t ne, int64_t edge_us, int64_t now_us)
+	{
+		edge_us = std::min(edge_us, now_us);
+
+		for (size_t i = 0; i < TOUCH_PAD_MAX; ++i)
+		{
+			const touch_pad_t pad = static_cast<touch_pad_t>(i);
+			const uint16_t bit = 1 << i;
+
+			// in time order: timeouts due before the edges, the edges, then the timeouts due since
+			while (state[i] != State::IDLE && deadline[i] <= edge_us)
+				timeout(pad, now_us);
+
+			if (pe & bit)
+				press(pad, edge_us);
+			if (ne & bit)
+				release(pad, edge_us, now_us);
+
+			while (state[i] != State::IDLE && deadline[i] <= now_us)
+				timeout(pad, now_us);
+		}
+	}
+
+	// Earliest time update() has to run even without edges, NEVER if nothing is pending
+	int64_t next_deadline() const
+	{
+		int64_t ret = NEVER;
+		for (size_t i = 0; i < TOUCH_PAD_MAX; ++i)
+			if (state[i] != State::IDLE)
+				ret = std::min(ret, deadline[i]);
+		return ret;
+	}
+
+	bool poll(Event &out)
+	{
+		if (!q_size)
+			return false;
+
+		out = queue[q_head];
+		q_head = (q_head + 1) % QUEUE_LEN;
+		--q_size;
+		return true;
+	}
+
+	uint32_t get_latency_max() const
+	{
+		return latency_max;
+	}
+
+	uint32_t get_latency_mean() const
+	{
+		return latency_cnt ? latency_sum / latency_cnt : 0;
+	}
+
+	void reset_latency()
+	{
+		latency_max = 0;
+		latency_sum = 0;
+		latency_cnt = 0;
+	}
+
+private:
+	static constexpr int64_t ms(uint32_t v)
+	{
+		return int64_t(v) * 1000;
+	}
+
+	void press(touch_pad_t pad, int64_t edge_us)
+	{
+		switch (state[pad])
+		{
+		case State::IDLE:
+			state[pad] = State::PRESSED;
+			deadline[pad] = edge_us + ms(long_ms);
+			break;
+
+		case State::RELEASED:
+			state[pad] = State::SECOND;
+			deadline[pad] = edge_us + ms(long_ms);
+			break;
+
+		default: // already down, missed a release
+			break;
+		}
+	}
+
+	void release(touch_pad_t pad, int64_t edge_us, int64_t now_us)
+	{
+		switch (state[pad])
+		{
+		case State::PRESSED:
+			if (double_ms)
+			{
+				state[pad] = State::RELEASED;
+				deadline[pad] = edge_us + ms(double_ms);
+			}
+			else
+			{
+				state[pad] = State::IDLE;
+				emit(Type::TAP, pad, edge_us, now_us);
+			}
+			break;
+
+		case State::SECOND:
+			state[pad] = State::IDLE;
+			emit(Type::DOUBLE_TAP, pad, edge_us, now_us);
+			break;
+
+		case State::HELD:
+			state[pad] = State::IDLE;
+			emit(Type::RELEASE, pad, edge_us, now_us);
+			break;
+
+		default: // not down, missed a press
+			break;
+		}
+	}
+
+	void timeout(touch_pad_t pad, int64_t now_us)
+	{
+		const int64_t t = deadline[pad];
+
+		switch (state[pad])
+		{
+		case State::RELEASED:
+			state[pad] = State::IDLE;
+			emit(Type::TAP, pad, t, now_us);
+			break;
+
+		case State::SECOND: // tap, then a long press
+			emit(Type::TAP, pad, t, now_us);
+			[[fallthrough]];
+		case State::PRESSED:
+			state[pad] = State::HELD;
+			deadline[pad] = repeat_ms ? t + ms(repeat_ms) : NEVER;
+			emit(Type::LONG_PRESS, pad, t, now_us);
+			break;
+
+		case State::HELD:
+			deadline[pad] = t + ms(repeat_ms);
+			emit(Type::REPEAT, pad, t, now_us);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void emit(Type type, touch_pad_t pad, int64_t timestamp, int64_t now_us)
+	{
+		const uint32_t latency = now_us - timestamp;
+
+		latency_max = std::max(latency_max, latency);
+		latency_sum += latency;
+		++latency_cnt;
+
+		if (q_size == QUEUE_LEN) // drop the oldest
+		{
+			q_head = (q_head + 1) % QUEUE_LEN;
+			--q_size;
+		}
+
+		queue[(q_head + q_size) % QUEUE_LEN] = {type, pad, timestamp, latency};
+		++q_size;
+	}
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef TouchSlider_H
+#define TouchSlider_H
+
+#include <cstdint>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "SmartTouch.h"
+
+// Ordered group of pads read as one continuous control.
+// Position is the centroid of SmartTouch::touch_analog over the strongest pad and its two neighbours,
+// so a finger between two pads lands between them and noise on far pads does not pull it.
+// Slider: position in [0, 1] from the first to the last pad. Wheel: position in [0, 1), wrapping.
+class TouchSlider
+{
+	static constexpr const char *const TAG = "TouchSlider";
+
+private:
+	const std::vector<touch_pad_t> pads;
+	const bool wheel;
+
+	float min_weight; // sum of analog values needed to count as touched
+	float vel_alpha;  // velocity smoothing
+
+	int64_t last_us = 0;
+
+public:
+	bool active = false;
+	bool pressed = false;  // became active in the last update
+	bool released = false; // became inactive in the last update
+
+	float position = 0; // [0, 1]
+	float velocity = 0; // positions per second, signed
+
+public:
+	TouchSlider(const std::vector<touch_pad_t> &p, bool w = false, float mw = 0.5f, float va = 0.3f) : pads(p), wheel(w), min_weight(mw), vel_alpha(va)
+	{
+		assert(pads.size() >= 2);
+	}
+	~TouchSlider() = default;
+
+	void update(const SmartTouch &st, int64_t now_us)
+	{
+		const size_t n = pads.size();
+
+		size_t peak = 0;
+		for (size_t i = 1; i < n; ++i)
+			if (st.touch_analog[pads[i]] > st.touch_analog[pads[peak]])
+				peak = i;
+
+		// neighbours of the peak, wrapping on a wheel, missing on the ends of a slider
+		const float a_prev = (peak > 0 || wheel) ? st.touch_analog[pads[(peak + n - 1) % n]] : 0;
+		const float a_peak = st.touch_analog[pads[peak]];
+		const float a_next = (peak < n - 1 || wheel) ? st.touch_analog[pads[(peak + 1) % n]] : 0;
+
+		const float weight = a_prev + a_peak + a_next;
+		const bool was_active = active;
+
+		active = weight >= min_weight;
+		pressed = active && !was_active;
+		released = !active && was_active;
+
+		if (!active)
+		{
+			velocity = 0;
+			last_us = now_us;
+			return;
+		}
+
+		const float offset = (a_next - a_prev) / weight; // [-1, 1] pads from the peak
+		float pos;
+		if (wheel)
+		{
+			pos = (peak + offset) / n;
+			pos -= std::floor(pos);
+		}
+		else
+			pos = std::clamp((peak + offset) / (n - 1), 0.0f, 1.0f);
+
+		if (pressed)
+		{
+			position = pos;
+			velocity = 0;
+			last_us = now_us;
+			return;
+		}
+
+		float delta = pos - position;
+		if (wheel) // shortest way around
+			delta -= std::round(delta);
+
+		const float dt = (now_us - last_us) * 1e-6f;
+		if (dt > 0)
+			velocity += vel_alpha * (delta / dt - velocity);
+
+		position = pos;
+		last_us = now_us;
+	}
+};
+
+#endif
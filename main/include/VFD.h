@@ -55,6 +55,9 @@ public:
 		BAR4_16_20_A,
 	};
 
+	// Anode of the point on DIGIT8_14_D, shared with SegmentDisplay::Default16Segment::DiagUpperLeft which no digit uses
+	static constexpr uint16_t DECIMAL_POINT = 1 << 15;
+
 	void set_grid(Grids g, uint16_t pattern)
 	{
 		matrix[static_cast<size_t>(g)] = pattern;
@@ -0,0 +1,156 @@
+#include "AssetBundle.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include <esp_log.h>
+#include <esp_check.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_partition.h> // REQUIRES esp_partition
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+//================================//
+//         IMPLEMENTATION         //
+//================================//
+
+esp_err_t AssetBundle::init(const char *name)
+{
+	ESP_RETURN_ON_FALSE(!is_open(), ESP_ERR_INVALID_STATE, TAG, "Already open!");
+	ESP_RETURN_ON_ERROR(map(name), TAG, "Failed to map %s!", name);
+
+	const esp_err_t ret = validate();
+	if (ret != ESP_OK)
+	{
+		ESP_LOGE(TAG, "Invalid bundle in %s: %s", name, esp_err_to_name(ret));
+		unmap();
+		return ret;
+	}
+
+	const auto *h = reinterpret_cast<const AssetFormat::Header *>(base);
+	index = reinterpret_cast<const AssetFormat::Entry *>(base + sizeof(AssetFormat::Header));
+	n = h->count;
+
+	ESP_LOGI(TAG, "%s: version %u, %u ids, %lu bytes", name, h->version, n, (unsigned long)h->size);
+	return ESP_OK;
+}
+
+esp_err_t AssetBundle::deinit()
+{
+	if (is_open())
+		unmap();
+	index = nullptr;
+	n = 0;
+	return ESP_OK;
+}
+
+//----------------//
+//    HELPERS     //
+//----------------//
+
+// Header and every index entry must lie inside the mapping, so get() needs no further checks
+esp_err_t AssetBundle::validate() const
+{
+	using namespace AssetFormat;
+
+	if (mapped < sizeof(Header))
+		return ESP_ERR_INVALID_SIZE;
+
+	const auto *h = reinterpret_cast<const Header *>(base);
+	if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)))
+		return ESP_ERR_NOT_FOUND;
+	if (h->version != VERSION)
+		return ESP_ERR_INVALID_VERSION;
+	if (h->size > mapped || sizeof(Header) + size_t(h->count) * sizeof(Entry) > h->size)
+		return ESP_ERR_INVALID_SIZE;
+
+	const auto *e = reinterpret_cast<const Entry *>(base + sizeof(Header));
+	for (size_t i = 0; i < h->count; ++i)
+	{
+		if (!e[i].size)
+			continue;
+		if (e[i].offset % ALIGN || e[i].offset > h->size || e[i].size > h->size - e[i].offset)
+			return ESP_ERR_INVALID_SIZE;
+	}
+
+	return ESP_OK;
+}
+
+#ifdef ESP_PLATFORM
+
+esp_err_t AssetBundle::map(const char *name)
+{
+	const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, name);
+	ESP_RETURN_ON_FALSE(part, ESP_ERR_NOT_FOUND, TAG, "No partition %s!", name);
+
+	// The header first, it says how much of the partition the bundle uses and only that much is mapped
+	const void *ptr = nullptr;
+	esp_partition_mmap_handle_t hdl;
+	ESP_RETURN_ON_ERROR(
+		esp_partition_mmap(part, 0, sizeof(AssetFormat::Header), ESP_PARTITION_MMAP_DATA, &ptr, &hdl),
+		TAG, "Failed to esp_partition_mmap!");
+
+	AssetFormat::Header h;
+	std::memcpy(&h, ptr, sizeof(h));
+	esp_partition_munmap(hdl);
+	ESP_RETURN_ON_FALSE(!std::memcmp(h.magic, AssetFormat::MAGIC, sizeof(h.magic)), ESP_ERR_NOT_FOUND, TAG, "No bundle in %s!", name);
+
+	const size_t size = std::clamp<size_t>(h.size, sizeof(h), part->size); // validate() rejects a bundle larger than this
+
+	ESP_RETURN_ON_ERROR(
+		esp_partition_mmap(part, 0, size, ESP_PARTITION_MMAP_DATA, &ptr, &hdl),
+		TAG, "Failed to esp_partition_mmap!");
+
+	base = static_cast<const uint8_t *>(ptr);
+	mapped = size;
+	handle = hdl;
+	return ESP_OK;
+}
+
+void AssetBundle::unmap()
+{
+	esp_partition_munmap(handle);
+	base = nullptr;
+	mapped = 0;
+	handle = 0;
+}
+
+#else // host, the bundle is a file
+
+esp_err_t AssetBundle::map(const char *name)
+{
+	const int fd = ::open(name, O_RDONLY);
+	ESP_RETURN_ON_FALSE(fd >= 0, ESP_ERR_NOT_FOUND, TAG, "No file %s!", name);
+
+	// As on the device, the header decides how much is mapped, up to the end of the file
+	struct stat st;
+	AssetFormat::Header h;
+	void *ptr = MAP_FAILED;
+	size_t size = 0;
+	if (fstat(fd, &st) == 0 && pread(fd, &h, sizeof(h), 0) == ssize_t(sizeof(h)) && !std::memcmp(h.magic, AssetFormat::MAGIC, sizeof(h.magic)))
+	{
+		size = std::clamp<size_t>(h.size, sizeof(h), st.st_size);
+		ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	::close(fd); // the mapping keeps the file
+
+	ESP_RETURN_ON_FALSE(ptr != MAP_FAILED, ESP_ERR_NOT_FOUND, TAG, "No bundle in %s!", name);
+
+	base = static_cast<const uint8_t *>(ptr);
+	mapped = size;
+	return ESP_OK;
+}
+
+void AssetBundle::unmap()
+{
+	munmap(const_cast<uint8_t *>(base), mapped);
+	base = nullptr;
+	mapped = 0;
+}
+
+#endif
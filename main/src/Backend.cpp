@@ -112,6 +112,30 @@ namespace Backend
 		return ESP_OK;
 	}
 
+	// One grid per call with the anodes of its pattern in the shared VFD matrix
+	static esp_err_t vfd_scan()
+	{
+		static size_t grid = 0;
+		const VFD &vfd = Communicator::get_vfd();
+
+		ESP_RETURN_ON_ERROR(
+			expander_grids.set_pins(0),
+			TAG, "Failed to expander_grids.set_pins!");
+
+		ESP_RETURN_ON_ERROR(
+			expander_anodes.set_pins(vfd.matrix[grid]),
+			TAG, "Failed to expander_anodes.set_pins!");
+
+		ESP_RETURN_ON_ERROR(
+			expander_grids.set_pins(BIT(grid)),
+			TAG, "Failed to expander_grids.set_pins!");
+
+		++grid;
+		grid &= 0b1111;
+
+		return ESP_OK;
+	}
+
 	static esp_err_t vfd_all_all()
 	{
 		ESP_RETURN_ON_ERROR(
@@ -185,7 +209,7 @@ namespace Backend
 			// float DT = cycles * SAMPLING_S;
 
 			// if (DT < 1.0f)
-			vfd_for_all();
+			vfd_scan();
 			// else
 			// vfd_none();
 
@@ -13,10 +13,21 @@
 
 #include <driver/spi_master.h>
 #include <driver/gpio.h>
+#include <esp_timer.h>
 
 #include "BME280.h"
+#include "SensorHistory.h"
+#include "SensorHub.h"
+#include "Atmospherics.h"
+#include "DataFlow.h"
 #include "SmartTouch.h"
+#include "TouchGesture.h"
 #include "SignalProcessing.h"
+#include "Filters.h"
+#include "SegmentDisplay.h"
+#include "Animation.h"
+#include "AssetBundle.h"
+#include "BootAnimation.h" // generated from tools/clips/boot.txt
 
 #include "Settings.h"
 #include "Communicator.h"
@@ -32,21 +43,69 @@ namespace Frontend
 
 		BME280_SPI bme280(spi_host, GPIO_NUM_2);
 
+		SensorHub<> sensor_hub(1000); // 1 round per second
+
 		SmartTouch st({TOUCH_PAD_NUM8});
 		Hysteresis hys(0.4, 0.6);
 		BoolLowpass bllp(5);
+		TouchGesture gestures;
+
+		constexpr uint32_t TOUCH_BASELINE_MS = 1000; // EWMA baseline job period
+		constexpr uint32_t TOUCH_RELEASE_MS = 30;	 // poll period while something is touched, interrupts only report touches
+		constexpr uint32_t TOUCH_SAVE_MS = 60 * 60 * 1000; // baseline persisted for the next boot
+
+		TaskHandle_t touchloop_task_hdl = nullptr;
+		TaskHandle_t controlloop_task_hdl = nullptr;
+		volatile bool controlloop_exit = false;
 
 		// DATA STORES
-		std::array<char, 6> buf_temperature;
-		std::array<char, 6> buf_pressure;
-		std::array<char, 6> buf_humidity;
+		SensorHistory<24 * 60> history; // 24h at 1 sample per minute
+		std::array<MovingAverage<float, 60>, 3> minute_mean; // T, P, H, the history gets the mean of the last minute, not one sample of it
+		DataFlow<> dataflow; // one sample fans out to every display value, recomputed only on change
+
+		struct
+		{
+			// sources
+			DataFlow<>::NodeId temperature;
+			DataFlow<>::NodeId humidity;
+			DataFlow<>::NodeId pressure;
+			DataFlow<>::NodeId trend; // Pa/h, from history
+			// derived
+			DataFlow<>::NodeId dew_point;
+			DataFlow<>::NodeId heat_index;
+			DataFlow<>::NodeId absolute_humidity;
+			DataFlow<>::NodeId sea_level_pressure;
+			// shown, in display units (0.01 DegC, 0.01 hPa, 0.01 %, bar segments)
+			DataFlow<>::NodeId disp_temperature;
+			DataFlow<>::NodeId disp_pressure;
+			DataFlow<>::NodeId disp_humidity;
+			DataFlow<>::NodeId disp_dew_point;
+			DataFlow<>::NodeId disp_heat_index;
+			DataFlow<>::NodeId disp_absolute_humidity;
+			DataFlow<>::NodeId disp_trend;
+		} node;
+
+		constexpr float STATION_ALTITUDE = 0; // m
+		constexpr float TREND_BAR_STEP = 50;  // Pa/h per bar segment
+		constexpr int32_t TREND_BAR_MAX = 4;  // segments each way
+
+		// Rotating pages on the six 14-segment digits: 4 integer and 2 decimal digits, the point on DIGIT8_14_D,
+		// the label in front when the integer part leaves room for it
+		constexpr uint32_t PAGE_S = 4; // s per page
+
+		struct Page
+		{
+			char label;
+			DataFlow<>::NodeId node;
+			std::array<char, 7> text; // 6 digits + NUL
+		};
+		std::array<Page, 6> pages;
 
-		std::array<char, 4> buf_year;
-		std::array<char, 2> buf_month;
-		std::array<char, 2> buf_day;
-		std::array<char, 2> buf_hour;
-		std::array<char, 2> buf_minute;
-		std::array<char, 2> buf_second;
+		// ASSETS, optional, the built-in glyphs and boot clip stand in for missing ones
+		AssetBundle assets;
+		const uint16_t *font_7seg = nullptr;
+		const uint16_t *font_16seg = nullptr;
+		static_assert(SegmentDisplay::FONT_GLYPHS == AssetFormat::GLYPHS);
 
 	}
 
@@ -93,6 +152,8 @@ namespace Frontend
 
 	static esp_err_t init_bme280()
 	{
+		const int64_t t_start = esp_timer_get_time();
+
 		ESP_RETURN_ON_ERROR(
 			bme280.init(false),
 			TAG, "Failed to bme280.init!");
@@ -111,6 +172,14 @@ namespace Frontend
 			bme280.continuous_mode(true),
 			TAG, "Failed to bme280.continuous_mode!");
 
+		BME280::Meas meas;
+		ESP_RETURN_ON_ERROR(
+			bme280.measure(meas, true),
+			TAG, "Failed to bme280.measure!");
+
+		ESP_LOGI(TAG, "BME280 %s boot, time to first measurement: %lld us",
+				 bme280.warm_boot() ? "warm" : "cold", esp_timer_get_time() - t_start);
+
 		return ESP_OK;
 	}
 	static esp_err_t deinit_bme280()
@@ -123,61 +192,315 @@ namespace Frontend
 		return ESP_OK;
 	}
 
+	static esp_err_t init_assets()
+	{
+		if (assets.init() != ESP_OK)
+		{
+			ESP_LOGW(TAG, "No asset bundle, using the built-in glyphs and boot clip");
+			return ESP_OK;
+		}
+
+		font_7seg = assets.font(AssetFormat::Id::FONT_7SEG);
+		font_16seg = assets.font(AssetFormat::Id::FONT_16SEG);
+
+		return ESP_OK;
+	}
+	static esp_err_t deinit_assets()
+	{
+		font_7seg = nullptr;
+		font_16seg = nullptr;
+
+		ESP_RETURN_ON_ERROR(
+			assets.deinit(),
+			TAG, "Failed to assets.deinit!");
+
+		return ESP_OK;
+	}
+
+	static void on_gesture(const TouchGesture::Event &ev)
+	{
+		static constexpr const char *const names[] = {"tap", "double tap", "long press", "repeat", "release"};
+		ESP_LOGI(TAG, "Touch %s on pad %d, latency %u us", names[static_cast<size_t>(ev.type)], ev.pad, unsigned(ev.latency));
+	}
+
+	static void touchloop_task(void *arg)
+	{
+		ESP_LOGI(TAG, "Starting the Touch loop...");
+
+		if (st.init_fsm(xTaskGetCurrentTaskHandle()) != ESP_OK)
+		{
+			ESP_LOGE(TAG, "Failed to st.init_fsm!");
+			touchloop_task_hdl = nullptr;
+			vTaskDelete(nullptr);
+		}
+
+		TickType_t last_baseline = xTaskGetTickCount();
+		TickType_t last_save = last_baseline;
+
+		while (1)
+		{
+			// Sleep until a pad crosses its threshold or a gesture times out, only poll while something is held
+			TickType_t wait = pdMS_TO_TICKS(st.touch_on ? TOUCH_RELEASE_MS : TOUCH_BASELINE_MS);
+			const int64_t deadline = gestures.next_deadline();
+			if (deadline != TouchGesture::NEVER)
+				wait = std::min(wait, pdMS_TO_TICKS(std::max<int64_t>(deadline - esp_timer_get_time() + 999, 0) / 1000));
+			ulTaskNotifyTake(pdTRUE, wait);
+
+			int64_t isr_time = 0;
+			const bool isr = st.take_isr_status(&isr_time);
+			const int64_t now = esp_timer_get_time();
+
+			st.test_pins();
+
+			// presses come from the interrupt, releases from polling
+			gestures.update(st.touch_pe, st.touch_ne, (isr && st.touch_pe) ? isr_time : now, now);
+
+			TouchGesture::Event ev;
+			while (gestures.poll(ev))
+				on_gesture(ev);
+
+			if (xTaskGetTickCount() - last_baseline >= pdMS_TO_TICKS(TOUCH_BASELINE_MS))
+			{
+				st.update_baseline();
+				last_baseline = xTaskGetTickCount();
+			}
+
+			if (xTaskGetTickCount() - last_save >= pdMS_TO_TICKS(TOUCH_SAVE_MS))
+			{
+				if (st.save_baseline() != ESP_OK)
+					ESP_LOGW(TAG, "Failed to st.save_baseline!");
+
+				ESP_LOGI(TAG, "Gesture latency mean %u us, max %u us", unsigned(gestures.get_latency_mean()), unsigned(gestures.get_latency_max()));
+				gestures.reset_latency();
+				last_save = xTaskGetTickCount();
+			}
+		}
+	}
+
+	static esp_err_t init_touch()
+	{
+		ESP_RETURN_ON_ERROR(
+			SmartTouch::Init(),
+			TAG, "Failed to SmartTouch::Init!");
+
+		ESP_RETURN_ON_FALSE(
+			xTaskCreatePinnedToCore(touchloop_task, "TouchLoop", FRONTEND_MEM, nullptr, FRONTEND_PRT, &touchloop_task_hdl, CPU0),
+			ESP_ERR_NO_MEM, TAG, "Failed to xTaskCreatePinnedToCore!");
+
+		return ESP_OK;
+	}
+
+	static esp_err_t init_dataflow()
+	{
+		node.temperature = dataflow.add_source(0.0f);
+		node.humidity = dataflow.add_source(0.0f);
+		node.pressure = dataflow.add_source(0.0f);
+		node.trend = dataflow.add_source(0.0f);
+
+		node.dew_point = dataflow.add_node({node.temperature, node.humidity}, Atmospherics::dew_point);
+		node.heat_index = dataflow.add_node({node.temperature, node.humidity}, Atmospherics::heat_index);
+		node.absolute_humidity = dataflow.add_node({node.temperature, node.humidity}, Atmospherics::absolute_humidity);
+		const auto sea_level = [](float p)
+		{
+			BME280::Meas m = {};
+			m.pressure = p;
+			return BME280::get_sea_level_pressure(m, STATION_ALTITUDE);
+		};
+		node.sea_level_pressure = dataflow.add_node({node.pressure}, sea_level);
+
+		// rounded to what the display shows, so the formatting only runs when a digit changes
+		const auto centi = [](float v)
+		{
+			return int32_t(std::lround(v * 100));
+		};
+		const auto unit = [](float v)
+		{
+			return int32_t(std::lround(v));
+		};
+		const auto bar = [](float t)
+		{
+			return std::clamp(int32_t(std::lround(t / TREND_BAR_STEP)), -TREND_BAR_MAX, TREND_BAR_MAX);
+		};
+
+		node.disp_temperature = dataflow.add_node({node.temperature}, centi);
+		node.disp_pressure = dataflow.add_node({node.sea_level_pressure}, unit); // Pa = 0.01 hPa
+		node.disp_humidity = dataflow.add_node({node.humidity}, centi);
+		node.disp_dew_point = dataflow.add_node({node.dew_point}, centi);
+		node.disp_heat_index = dataflow.add_node({node.heat_index}, centi);
+		node.disp_absolute_humidity = dataflow.add_node({node.absolute_humidity}, centi);
+		node.disp_trend = dataflow.add_node({node.trend}, bar);
+
+		for (DataFlow<>::NodeId id : {node.disp_temperature, node.disp_pressure, node.disp_humidity, node.disp_dew_point, node.disp_heat_index, node.disp_absolute_humidity, node.disp_trend})
+			ESP_RETURN_ON_FALSE(
+				id != DataFlow<>::INVALID,
+				ESP_ERR_NO_MEM, TAG, "Failed to build the dataflow graph!");
+
+		pages = {{
+			{'T', node.disp_temperature, {}},		// DegC
+			{'H', node.disp_humidity, {}},			// %RH
+			{' ', node.disp_pressure, {}},			// hPa, sea level
+			{'D', node.disp_dew_point, {}},			// DegC
+			{'F', node.disp_heat_index, {}},		// DegC, feels like
+			{'A', node.disp_absolute_humidity, {}}, // g/m3
+		}};
+
+		return ESP_OK;
+	}
+
+	// 4 integer + 2 decimal digits without the point, space padded, e.g. "  2145" for 21.45 and "  -050" for -0.5
 	void format_float_for_4_2(float value, char *buffer, size_t buflen)
 	{
-		// Convert to an integer representation (4 integer + 2 decimal places)
-		int scaledValue = std::round(value * 100);
+		const int32_t scaled = std::clamp<int32_t>(std::lround(value * 100), -99999, 999999);
 
-		// Ensure at least one leading zero and a total width of 6 characters
-		if (scaledValue < 100)							   // If the number is less than 1
-			snprintf(buffer, buflen, "% 6d", scaledValue); // Space padding for alignment
+		if (scaled < 0 && scaled > -100) // no integer digit to carry the sign
+			snprintf(buffer, buflen, "  -0%02d", int(-scaled));
 		else
-			snprintf(buffer, buflen, "   0%02d", scaledValue); // Zero padding for small numbers
+			snprintf(buffer, buflen, "%4d%02d", int(scaled / 100), int(std::abs(scaled % 100)));
+	}
+
+	static void format_page(Page &page)
+	{
+		format_float_for_4_2(dataflow.get<int32_t>(page.node) * 0.01f, page.text.data(), page.text.size());
+
+		if (page.text[0] == ' ')
+			page.text[0] = page.label;
+	}
+
+	// Time on the 7-segment digits, the page on the 14-segment digits and the pressure trend on the bar
+	static void render(const std::tm &tm, const Page &page, int32_t trend)
+	{
+		using namespace SegmentDisplay;
+
+		VFD &vfd = Communicator::get_vfd();
+
+		vfd.set_grid(VFD::DIGIT1_7, char_to_7seg(font_7seg, '0' + tm.tm_hour / 10));
+		vfd.set_grid(VFD::DIGIT2_7, char_to_7seg(font_7seg, '0' + tm.tm_hour % 10));
+		vfd.set_grid(VFD::DIGIT3_9, char_to_7seg(font_7seg, '0' + tm.tm_min / 10));
+		vfd.set_grid(VFD::DIGIT4_7_S, char_to_7seg(font_7seg, '0' + tm.tm_min % 10));
+
+		for (size_t i = 0; i < 6; ++i)
+			vfd.set_grid(static_cast<VFD::Grids>(VFD::DIGIT5_14 + i), char_to_16seg(font_16seg, page.text[i]));
+		vfd.set_grid(VFD::DIGIT8_14_D, char_to_16seg(font_16seg, page.text[3]) | VFD::DECIMAL_POINT);
+
+		// 20 bar segments, from the middle to the right when rising, to the left when falling, two per step
+		const uint32_t len = 2 * std::abs(trend);
+		const uint32_t bar = trend >= 0 ? ((1u << len) - 1) << 10 : ((1u << len) - 1) << (10 - len);
+		for (size_t i = 0; i < 4; ++i)
+			vfd.set_grid(static_cast<VFD::Grids>(VFD::BAR1_1_5 + i), (bar >> (5 * i)) & 0b11111);
+	}
+
+	// Plays a clip into the VFD matrix at its own frame rate, the Backend scan shows every frame as it is written
+	static void play(AnimationDecoder clip)
+	{
+		VFD &vfd = Communicator::get_vfd();
+		const TickType_t period = std::max<TickType_t>(pdMS_TO_TICKS(clip.period_ms()), 1);
+
+		TickType_t last = xTaskGetTickCount();
+		while (!controlloop_exit && clip.next(vfd.matrix))
+			xTaskDelayUntil(&last, period);
 	}
 
 	static void controlloop_task(void *arg)
 	{
 		__attribute__((unused)) esp_err_t ret; // used in on_false macros
 
-		time_t now;
-		struct tm timeinfo;
 		char dt_buffer[64];
 
 		ESP_LOGI(TAG, "Starting the Frontend loop...");
 
-		// while (1)
-		// {
-		// 	time(&now);
-		// 	localtime_r(&now, &timeinfo);
+		int last_minute = -1;
+		uint32_t last_dropped = 0;
+		bool first_sample = true;
+		BME280::Meas mean_meas = {};
 
-		// 	strftime(dt_buffer, sizeof(dt_buffer), "%c", &timeinfo); // Format the time string
-		// 	ESP_LOGI(TAG, "Local date and time: %s", dt_buffer);
-		// 	vTaskDelay(pdMS_TO_TICKS(10000)); // Wait 10 second
-		// }
+		// the first sample arrives meanwhile
+		const AnimationDecoder boot = assets.animation(AssetFormat::Id::BOOT_ANIMATION);
+		play(boot.valid() ? boot : AnimationDecoder(boot_animation, sizeof(boot_animation)));
 
-		while (1)
+		while (!controlloop_exit)
 		{
+			// Paced by the hub, one round per second, the timeout keeps the clock going without samples
+			SensorHub<>::Sample sample;
+			bool have_sample = sensor_hub.receive(sample, pdMS_TO_TICKS(1500));
+			while (sensor_hub.receive(sample)) // keep only the newest
+				have_sample = true;
+
 			const auto now = std::chrono::system_clock::now();
 			std::time_t now_tt = std::chrono::system_clock::to_time_t(now);
 			std::tm tm = *std::localtime(&now_tt);
 
-			std::strftime(buf_year.data(), 6, "%Y", &tm);
-			std::strftime(buf_month.data(), 6, "%m", &tm);
-			std::strftime(buf_day.data(), 6, "%d", &tm);
-			std::strftime(buf_hour.data(), 6, "%H", &tm);
-			std::strftime(buf_minute.data(), 6, "%M", &tm);
-			std::strftime(buf_second.data(), 6, "%S", &tm);
-
-			ESP_LOGI(TAG, "Local date and time: %s", dt_buffer);
-			vTaskDelay(pdMS_TO_TICKS(10000)); // Wait 10 second
+			if (have_sample)
+			{
+				dataflow.set(node.temperature, float(sample.meas.temperature));
+				dataflow.set(node.humidity, float(sample.meas.humidity));
+				dataflow.set(node.pressure, float(sample.meas.pressure));
+
+				const float values[3] = {float(sample.meas.temperature), float(sample.meas.pressure), float(sample.meas.humidity)};
+				if (first_sample) // no zeros in the first minute
+					for (size_t i = 0; i < 3; ++i)
+						minute_mean[i].reset(values[i]);
+				first_sample = false;
+
+				mean_meas = sample.meas;
+				mean_meas.temperature = minute_mean[0].evaluate(values[0]);
+				mean_meas.pressure = minute_mean[1].evaluate(values[1]);
+				mean_meas.humidity = minute_mean[2].evaluate(values[2]);
+			}
+
+			if (have_sample && tm.tm_min != last_minute)
+			{
+				history.push(mean_meas);
+				dataflow.set(node.trend, history.slope(SensorHistory<>::Channel::PRESSURE) * 60); // per minute -> per hour
+				last_minute = tm.tm_min;
+
+				std::strftime(dt_buffer, sizeof(dt_buffer), "%c", &tm);
+				ESP_LOGI(TAG, "Local date and time: %s", dt_buffer);
+
+				if (const uint32_t dropped = sensor_hub.get_dropped(); dropped != last_dropped)
+				{
+					ESP_LOGW(TAG, "Frontend loop fell behind, %u samples dropped so far", unsigned(dropped));
+					last_dropped = dropped;
+				}
+			}
+
+			dataflow.evaluate();
+
+			for (Page &page : pages)
+				if (dataflow.changed(page.node) || !page.text[0])
+					format_page(page);
+
+			ESP_LOGD(TAG, "Dataflow: %u of %u nodes evaluated in %u cycles", unsigned(dataflow.last_evals()), unsigned(dataflow.size()), unsigned(dataflow.last_cost()));
+
+			render(tm, pages[(now_tt / PAGE_S) % pages.size()], dataflow.get<int32_t>(node.disp_trend));
 		}
 
 		ESP_LOGI(TAG, "Exiting Frontend loop...");
 
+		controlloop_task_hdl = nullptr;
 		vTaskDelete(nullptr);
 		// *dies*
 	}
 
+	static esp_err_t init_controlloop()
+	{
+		controlloop_exit = false;
+
+		ESP_RETURN_ON_FALSE(
+			xTaskCreatePinnedToCore(controlloop_task, "FrontendLoop", FRONTEND_MEM, nullptr, FRONTEND_PRT, &controlloop_task_hdl, CPU0),
+			ESP_ERR_NO_MEM, TAG, "Failed to xTaskCreatePinnedToCore!");
+
+		return ESP_OK;
+	}
+	static esp_err_t deinit_controlloop()
+	{
+		controlloop_exit = true;
+
+		while (controlloop_task_hdl)
+			vTaskDelay(10); // 10 RTOS ticks
+
+		return ESP_OK;
+	}
+
 	//----------------//
 	//    FRONTEND    //
 	//----------------//
@@ -189,6 +512,10 @@ namespace Frontend
 
 	esp_err_t init()
 	{
+		ESP_RETURN_ON_ERROR(
+			init_assets(),
+			TAG, "Failed to init_assets!");
+
 		ESP_RETURN_ON_ERROR(
 			init_spi(),
 			TAG, "Failed to init_spi!");
@@ -197,11 +524,39 @@ namespace Frontend
 			init_bme280(),
 			TAG, "Failed to init_bme280!");
 
+		ESP_RETURN_ON_ERROR(
+			init_dataflow(),
+			TAG, "Failed to init_dataflow!");
+
+		ESP_RETURN_ON_ERROR(
+			sensor_hub.add(bme280),
+			TAG, "Failed to sensor_hub.add!");
+
+		ESP_RETURN_ON_ERROR(
+			sensor_hub.init(FRONTEND_PRT, CPU0),
+			TAG, "Failed to sensor_hub.init!");
+
+		ESP_RETURN_ON_ERROR(
+			init_controlloop(),
+			TAG, "Failed to init_controlloop!");
+
+		ESP_RETURN_ON_ERROR(
+			init_touch(),
+			TAG, "Failed to init_touch!");
+
 		return ESP_OK;
 	}
 
 	esp_err_t deinit()
 	{
+		ESP_RETURN_ON_ERROR(
+			deinit_controlloop(),
+			TAG, "Failed to deinit_controlloop!");
+
+		ESP_RETURN_ON_ERROR(
+			sensor_hub.deinit(),
+			TAG, "Failed to sensor_hub.deinit!");
+
 		ESP_RETURN_ON_ERROR(
 			deinit_bme280(),
 			TAG, "Failed to deinit_bme280!");
@@ -210,6 +565,10 @@ namespace Frontend
 			deinit_spi(),
 			TAG, "Failed to init_spi!");
 
+		ESP_RETURN_ON_ERROR(
+			deinit_assets(),
+			TAG, "Failed to deinit_assets!");
+
 		return ESP_OK;
 	}
 
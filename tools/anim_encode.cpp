@@ -0,0 +1,149 @@
+// Host encoder for VFD animation clips (format in main/include/Animation.h).
+//
+//   g++ -std=gnu++2a -O2 -I main/include tools/anim_encode.cpp -o anim_encode
+//   ./anim_encode [-p period_ms] [-c name] input.txt output
+//
+// Input is text, one frame per line as 16 hex grid words (VFD::matrix order), '#' starts a comment.
+// Identical consecutive lines become holds. Output is the raw clip, or with -c a header with
+// "static const uint8_t name[]" for embedding in the firmware.
+// The clip is decoded again with AnimationDecoder and compared before it is written.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "Animation.h"
+#include "anim_encoder.h"
+
+using namespace AnimationFormat;
+using AnimationEncoder::encode;
+
+volatile uint32_t decode_sink; // keeps the timed decode loop alive
+
+static bool parse(const char *path, std::vector<Frame> &frames)
+{
+	FILE *f = std::fopen(path, "r");
+	if (!f)
+		return false;
+
+	char line[512];
+	for (size_t no = 1; std::fgets(line, sizeof(line), f); ++no)
+	{
+		if (char *c = std::strchr(line, '#'))
+			*c = 0;
+
+		Frame fr;
+		size_t g = 0;
+		char *p = line;
+		for (char *end; g < GRIDS; ++g, p = end)
+		{
+			const unsigned long v = std::strtoul(p, &end, 16);
+			if (end == p || v > 0xFFFF)
+				break;
+			fr[g] = uint16_t(v);
+		}
+
+		if (g == 0 && std::strspn(line, " \t\r\n") == std::strlen(line))
+			continue;
+		if (g != GRIDS)
+		{
+			std::fprintf(stderr, "%s:%zu: expected %zu hex words\n", path, no, GRIDS);
+			std::fclose(f);
+			return false;
+		}
+		frames.push_back(fr);
+	}
+
+	std::fclose(f);
+	return true;
+}
+
+static bool write(const char *path, const std::vector<uint8_t> &clip, const char *name)
+{
+	FILE *f = std::fopen(path, name ? "w" : "wb");
+	if (!f)
+		return false;
+
+	if (!name)
+		std::fwrite(clip.data(), 1, clip.size(), f);
+	else
+	{
+		std::fprintf(f, "// Generated by tools/anim_encode.cpp, do not edit\n\n");
+		std::fprintf(f, "static const uint8_t %s[%zu] = {", name, clip.size());
+		for (size_t i = 0; i < clip.size(); ++i)
+			std::fprintf(f, "%s0x%02X,", i % 16 ? " " : "\n\t", clip[i]);
+		std::fprintf(f, "\n};\n");
+	}
+
+	return std::fclose(f) == 0;
+}
+
+int main(int argc, char **argv)
+{
+	uint16_t period_ms = 100;
+	const char *name = nullptr;
+
+	int a = 1;
+	for (; a + 1 < argc && argv[a][0] == '-'; a += 2)
+	{
+		if (!std::strcmp(argv[a], "-p"))
+			period_ms = uint16_t(std::atoi(argv[a + 1]));
+		else if (!std::strcmp(argv[a], "-c"))
+			name = argv[a + 1];
+		else
+			break;
+	}
+
+	if (argc - a != 2)
+	{
+		std::fprintf(stderr, "usage: %s [-p period_ms] [-c name] input.txt output\n", argv[0]);
+		return 2;
+	}
+
+	std::vector<Frame> frames;
+	if (!parse(argv[a], frames))
+		return 1;
+	if (frames.empty() || frames.size() > 0xFFFF)
+	{
+		std::fprintf(stderr, "need 1 to 65535 frames, got %zu\n", frames.size());
+		return 1;
+	}
+
+	const std::vector<uint8_t> clip = encode(frames, period_ms);
+
+	// Round trip, timed over enough passes to get a stable per-frame figure
+	AnimationDecoder dec(clip.data(), clip.size());
+	Frame fr;
+	for (size_t i = 0; i < frames.size(); ++i)
+		if (!dec.next(fr) || fr != frames[i])
+		{
+			std::fprintf(stderr, "round trip failed at frame %zu\n", i);
+			return 1;
+		}
+
+	const size_t passes = 1 + 2000000 / frames.size();
+	uint32_t check = 0;
+	const auto t0 = std::chrono::steady_clock::now();
+	for (size_t k = 0; k < passes; ++k)
+	{
+		dec.rewind();
+		while (dec.next(fr))
+			check += fr[k % GRIDS];
+	}
+	decode_sink = check;
+	const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / double(passes * frames.size());
+
+	if (!write(argv[a + 1], clip, name))
+	{
+		std::fprintf(stderr, "cannot write %s\n", argv[a + 1]);
+		return 1;
+	}
+
+	const size_t raw = frames.size() * sizeof(Frame);
+	std::printf("%zu frames, %zu -> %zu bytes (%.1fx, %.2f bytes/frame), decode %.1f ns/frame\n",
+				frames.size(), raw, clip.size(), double(raw) / clip.size(), double(clip.size()) / frames.size(), ns);
+	return 0;
+}
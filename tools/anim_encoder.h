@@ -0,0 +1,103 @@
+#ifndef anim_encoder_H
+#define anim_encoder_H
+
+// Clip encoder shared by tools/anim_encode.cpp and the host tests (format in main/include/Animation.h).
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+#include "Animation.h"
+
+namespace AnimationEncoder
+{
+	using namespace AnimationFormat;
+
+	inline void put16(std::vector<uint8_t> &out, uint16_t v)
+	{
+		out.push_back(v & 0xFF);
+		out.push_back(v >> 8);
+	}
+
+	inline void put32(std::vector<uint8_t> &out, uint32_t v)
+	{
+		put16(out, v & 0xFFFF);
+		put16(out, v >> 16);
+	}
+
+	// Smallest record turning prev into cur, n = extra repeats
+	inline std::vector<uint8_t> record(const Frame &prev, const Frame &cur, uint8_t n)
+	{
+		uint16_t word_mask = 0;
+		uint32_t byte_mask = 0;
+		for (size_t g = 0; g < GRIDS; ++g)
+		{
+			const uint16_t x = prev[g] ^ cur[g];
+			word_mask |= uint16_t(x != 0) << g;
+			byte_mask |= uint32_t((x & 0xFF) != 0) << (2 * g) | uint32_t((x >> 8) != 0) << (2 * g + 1);
+		}
+
+		const size_t words_len = 2 + 2 * std::popcount(word_mask);
+		const size_t bytes_len = 4 + std::popcount(byte_mask);
+		const size_t key_len = 2 * GRIDS;
+
+		std::vector<uint8_t> r;
+		if (key_len < words_len && key_len <= bytes_len)
+		{
+			r.push_back(KEY | n);
+			for (uint16_t w : cur)
+				put16(r, w);
+		}
+		else if (bytes_len < words_len)
+		{
+			r.push_back(BYTES | n);
+			put32(r, byte_mask);
+			for (size_t b = 0; b < 2 * GRIDS; ++b)
+				if (byte_mask >> b & 1)
+					r.push_back(uint8_t((prev[b >> 1] ^ cur[b >> 1]) >> ((b & 1) * 8)));
+		}
+		else
+		{
+			r.push_back(WORDS | n);
+			put16(r, word_mask);
+			for (size_t g = 0; g < GRIDS; ++g)
+				if (word_mask >> g & 1)
+					put16(r, prev[g] ^ cur[g]);
+		}
+		return r;
+	}
+
+	inline std::vector<uint8_t> encode(const std::vector<Frame> &frames, uint16_t period_ms)
+	{
+		std::vector<uint8_t> out = {MAGIC0, MAGIC1, VERSION, uint8_t(GRIDS)};
+		put16(out, uint16_t(frames.size()));
+		put16(out, period_ms);
+
+		Frame prev = {};
+		for (size_t i = 0; i < frames.size();)
+		{
+			size_t run = 1;
+			while (i + run < frames.size() && frames[i + run] == frames[i])
+				++run;
+
+			const size_t first = std::min<size_t>(run, COUNT_MASK + 1);
+			const std::vector<uint8_t> r = record(prev, frames[i], uint8_t(first - 1));
+			out.insert(out.end(), r.begin(), r.end());
+
+			for (size_t left = run - first; left;)
+			{
+				const size_t n = std::min<size_t>(left, COUNT_MASK + 1);
+				out.push_back(HOLD | uint8_t(n - 1));
+				left -= n;
+			}
+
+			prev = frames[i];
+			i += run;
+		}
+		return out;
+	}
+};
+
+#endif
@@ -0,0 +1,173 @@
+// Host packer for the asset bundle flashed to the "assets" partition (format in main/include/AssetFormat.h).
+//
+//   g++ -std=gnu++2a -O2 -I main/include tools/asset_pack.cpp -o asset_pack
+//   ./asset_pack manifest.txt assets/assets.bin
+//   parttool.py write_partition --partition-name assets --input assets/assets.bin
+//
+// Manifest lines are "id type path", '#' starts a comment, paths are relative to the manifest:
+//   raw    file copied as is
+//   font   text, one "char pattern" per line, char is a single character or a hex code (0x20), pattern hex
+//   anim   clip written by anim_encode, checked by decoding it once
+// The firmware looks up the ids in AssetFormat::Id (fonts for the 7 and 14/16-segment digits, the boot clip).
+// The bundle is also flashed with "idf.py flash" when main/CMakeLists.txt finds assets/assets.bin.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "AssetFormat.h"
+#include "Animation.h"
+
+using namespace AssetFormat;
+
+static bool read_file(const std::string &path, std::vector<uint8_t> &out)
+{
+	FILE *f = std::fopen(path.c_str(), "rb");
+	if (!f)
+		return false;
+
+	uint8_t buf[4096];
+	for (size_t n; (n = std::fread(buf, 1, sizeof(buf), f));)
+		out.insert(out.end(), buf, buf + n);
+
+	std::fclose(f);
+	return true;
+}
+
+static bool read_font(const std::string &path, std::vector<uint8_t> &out)
+{
+	FILE *f = std::fopen(path.c_str(), "r");
+	if (!f)
+		return false;
+
+	uint16_t lut[GLYPHS] = {};
+	char line[256];
+	bool ok = true;
+	for (size_t no = 1; ok && std::fgets(line, sizeof(line), f); ++no)
+	{
+		char code[16];
+		unsigned pattern;
+		if (line[0] == '#' || std::sscanf(line, "%15s", code) != 1)
+			continue;
+
+		const unsigned long c = std::strlen(code) == 1 ? (unsigned char)code[0] : std::strtoul(code, nullptr, 16);
+		ok = std::sscanf(line, "%*s %x", &pattern) == 1 && c < GLYPHS && pattern <= 0xFFFF;
+		if (ok)
+			lut[c] = uint16_t(pattern);
+		else
+			std::fprintf(stderr, "%s:%zu: expected \"char pattern\"\n", path.c_str(), no);
+	}
+	std::fclose(f);
+
+	const auto *p = reinterpret_cast<const uint8_t *>(lut);
+	out.assign(p, p + sizeof(lut));
+	return ok;
+}
+
+static bool check_anim(const std::vector<uint8_t> &clip)
+{
+	AnimationDecoder dec(clip.data(), clip.size());
+	AnimationFormat::Frame fr;
+	while (dec.next(fr))
+		;
+	return dec.valid() && dec.position() == dec.frames();
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 3)
+	{
+		std::fprintf(stderr, "usage: %s manifest.txt output.bin\n", argv[0]);
+		return 2;
+	}
+
+	const std::string manifest = argv[1];
+	const size_t slash = manifest.find_last_of('/');
+	const std::string dir = slash == std::string::npos ? "" : manifest.substr(0, slash + 1);
+
+	FILE *f = std::fopen(manifest.c_str(), "r");
+	if (!f)
+	{
+		std::fprintf(stderr, "cannot read %s\n", manifest.c_str());
+		return 1;
+	}
+
+	struct Item
+	{
+		Type type = Type::NONE;
+		std::vector<uint8_t> data;
+	};
+	std::vector<Item> items; // by id
+
+	char line[512];
+	for (size_t no = 1; std::fgets(line, sizeof(line), f); ++no)
+	{
+		if (char *c = std::strchr(line, '#'))
+			*c = 0;
+
+		unsigned id;
+		char type[16], path[400];
+		const int got = std::sscanf(line, "%u %15s %399s", &id, type, path);
+		if (got <= 0)
+			continue;
+
+		Item it;
+		bool ok = got == 3 && id <= 0xFFFF;
+		if (ok && !std::strcmp(type, "raw"))
+			it.type = Type::RAW, ok = read_file(dir + path, it.data);
+		else if (ok && !std::strcmp(type, "font"))
+			it.type = Type::FONT, ok = read_font(dir + path, it.data);
+		else if (ok && !std::strcmp(type, "anim"))
+			it.type = Type::ANIMATION, ok = read_file(dir + path, it.data) && check_anim(it.data);
+		else
+			ok = false;
+
+		if (ok && (it.data.empty() || (id < items.size() && items[id].type != Type::NONE)))
+			ok = false;
+		if (!ok)
+		{
+			std::fprintf(stderr, "%s:%zu: bad, empty or duplicate asset\n", manifest.c_str(), no);
+			std::fclose(f);
+			return 1;
+		}
+
+		if (id >= items.size())
+			items.resize(id + 1);
+		items[id] = std::move(it);
+	}
+	std::fclose(f);
+
+	// Header, index, then the assets in id order, each aligned
+	std::vector<uint8_t> out(sizeof(Header) + items.size() * sizeof(Entry));
+	std::vector<Entry> index(items.size());
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		if (items[i].type == Type::NONE)
+			continue;
+
+		out.resize((out.size() + ALIGN - 1) / ALIGN * ALIGN);
+		index[i] = {uint32_t(out.size()), uint32_t(items[i].data.size()), items[i].type, {}};
+		out.insert(out.end(), items[i].data.begin(), items[i].data.end());
+	}
+
+	Header h;
+	std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+	h.version = VERSION;
+	h.count = uint16_t(items.size());
+	h.size = uint32_t(out.size());
+	std::memcpy(out.data(), &h, sizeof(h));
+	if (!index.empty())
+		std::memcpy(out.data() + sizeof(h), index.data(), index.size() * sizeof(Entry));
+
+	FILE *o = std::fopen(argv[2], "wb");
+	if (!o || std::fwrite(out.data(), 1, out.size(), o) != out.size() || std::fclose(o))
+	{
+		std::fprintf(stderr, "cannot write %s\n", argv[2]);
+		return 1;
+	}
+
+	std::printf("%zu ids, %zu bytes\n", items.size(), out.size());
+	return 0;
+}
@@ -0,0 +1,69 @@
+// Host stand-in, there is no bus: devices cannot be added and every transfer fails
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+typedef enum
+{
+	SPI1_HOST,
+	SPI2_HOST,
+	SPI3_HOST,
+} spi_host_device_t;
+
+typedef struct spi_device_t *spi_device_handle_t;
+typedef struct spi_transaction_t spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t *);
+
+#define SPI_CLK_SRC_DEFAULT 0
+#define SPI_DEVICE_3WIRE (1u << 2)
+#define SPI_DEVICE_HALFDUPLEX (1u << 4)
+
+typedef struct
+{
+	uint8_t command_bits;
+	uint8_t address_bits;
+	uint8_t dummy_bits;
+	uint8_t mode;
+	int clock_source;
+	uint16_t duty_cycle_pos;
+	uint16_t cs_ena_pretrans;
+	uint8_t cs_ena_posttrans;
+	int clock_speed_hz;
+	int input_delay_ns;
+	int spics_io_num;
+	uint32_t flags;
+	int queue_size;
+	transaction_cb_t pre_cb;
+	transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+struct spi_transaction_t
+{
+	uint32_t flags;
+	uint16_t cmd;
+	uint64_t addr;
+	size_t length;
+	size_t rxlength;
+	void *user;
+	const void *tx_buffer;
+	void *rx_buffer;
+};
+
+inline esp_err_t spi_bus_add_device(spi_host_device_t, const spi_device_interface_config_t *, spi_device_handle_t *)
+{
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+inline esp_err_t spi_bus_remove_device(spi_device_handle_t)
+{
+	return ESP_OK;
+}
+
+inline esp_err_t spi_device_polling_transmit(spi_device_handle_t, spi_transaction_t *)
+{
+	return ESP_ERR_NOT_SUPPORTED;
+}
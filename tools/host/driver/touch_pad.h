@@ -0,0 +1,229 @@
+// Host stand-in for the legacy ESP32 touch driver.
+// Readings come from host::touch_source, which the test sets. In timer mode the FSM is modelled on the host clock:
+// every cycle sleeps touch_interval ticks at 150 kHz, then measures the configured pads one after another
+// (touch_clock_cycles at 8 MHz each) and latches the readings, the raw registers read 0 until the first cycle is done.
+// touch_source gives the reading at the default 0x7FFF clock cycles, a shorter measurement counts proportionally less.
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+
+typedef enum
+{
+	TOUCH_PAD_NUM0,
+	TOUCH_PAD_NUM1,
+	TOUCH_PAD_NUM2,
+	TOUCH_PAD_NUM3,
+	TOUCH_PAD_NUM4,
+	TOUCH_PAD_NUM5,
+	TOUCH_PAD_NUM6,
+	TOUCH_PAD_NUM7,
+	TOUCH_PAD_NUM8,
+	TOUCH_PAD_NUM9,
+	TOUCH_PAD_MAX,
+} touch_pad_t;
+
+typedef enum
+{
+	TOUCH_FSM_MODE_TIMER,
+	TOUCH_FSM_MODE_SW,
+} touch_fsm_mode_t;
+
+typedef enum
+{
+	TOUCH_TRIGGER_BELOW,
+	TOUCH_TRIGGER_ABOVE,
+} touch_trigger_mode_t;
+
+typedef enum
+{
+	TOUCH_HVOLT_2V7 = 3,
+} touch_high_volt_t;
+typedef enum
+{
+	TOUCH_LVOLT_0V5 = 0,
+} touch_low_volt_t;
+typedef enum
+{
+	TOUCH_HVOLT_ATTEN_1V = 0,
+} touch_volt_atten_t;
+
+namespace host
+{
+	inline std::function<uint16_t(touch_pad_t)> touch_source = [](touch_pad_t)
+	{
+		return uint16_t(1000);
+	};
+
+	inline bool touch_stalled = false; // the FSM stops measuring, for failure tests
+
+	inline uint16_t touch_configured = 0;
+	inline bool touch_timer = false;
+	inline int64_t touch_start = 0;
+	inline uint16_t touch_interval = 0x1000;
+	inline constexpr uint16_t TOUCH_CLOCK_CYCLES_DEFAULT = 0x7FFF;
+	inline uint16_t touch_clock_cycles = TOUCH_CLOCK_CYCLES_DEFAULT;
+	inline int64_t touch_cycles_done = 0;
+	inline std::array<uint16_t, TOUCH_PAD_MAX> touch_latched = {};
+	inline uint16_t touch_thresh[TOUCH_PAD_MAX] = {};
+
+	inline int64_t touch_sleep_us()
+	{
+		return int64_t(touch_interval) * 1000 / 150;
+	}
+	inline int64_t touch_cycle_us()
+	{
+		return touch_sleep_us() + int64_t(touch_clock_cycles) * __builtin_popcount(touch_configured) / 8;
+	}
+
+	// Latches the cycles the FSM finished since the last call
+	inline void touch_fsm_run()
+	{
+		if (!touch_timer || touch_stalled)
+			return;
+
+		const int64_t t = time_us - touch_start;
+		const int64_t done = t / touch_cycle_us();
+		if (done == touch_cycles_done)
+			return;
+
+		touch_cycles_done = done;
+		for (int pad = 0; pad < TOUCH_PAD_MAX; ++pad)
+			if (touch_configured & (1 << pad))
+				touch_latched[pad] = uint16_t(uint32_t(touch_source(touch_pad_t(pad))) * touch_clock_cycles / TOUCH_CLOCK_CYCLES_DEFAULT);
+	}
+
+	// Restarts the cycle, as the driver does when the timing changes
+	inline void touch_fsm_restart()
+	{
+		touch_fsm_run();
+		touch_start = time_us;
+		touch_cycles_done = 0;
+	}
+}
+
+inline esp_err_t touch_pad_init()
+{
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_deinit()
+{
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_set_voltage(touch_high_volt_t, touch_low_volt_t, touch_volt_atten_t)
+{
+	return ESP_OK;
+}
+
+inline esp_err_t touch_pad_config(touch_pad_t pad, uint16_t thresh)
+{
+	host::touch_configured |= 1 << pad;
+	host::touch_thresh[pad] = thresh;
+	return ESP_OK;
+}
+
+inline esp_err_t touch_pad_set_fsm_mode(touch_fsm_mode_t mode)
+{
+	host::touch_timer = mode == TOUCH_FSM_MODE_TIMER;
+	host::touch_latched = {};
+	host::touch_fsm_restart();
+	return ESP_OK;
+}
+
+inline esp_err_t touch_pad_get_measurement_interval(uint16_t *interval)
+{
+	*interval = host::touch_interval;
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_set_measurement_interval(uint16_t interval)
+{
+	host::touch_fsm_restart();
+	host::touch_interval = interval;
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_get_measurement_clock_cycles(uint16_t *cycles)
+{
+	*cycles = host::touch_clock_cycles;
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_set_measurement_clock_cycles(uint16_t cycles)
+{
+	host::touch_fsm_restart();
+	host::touch_clock_cycles = cycles;
+	return ESP_OK;
+}
+
+// Done while the FSM sleeps after a finished cycle, not done while it measures
+inline bool touch_pad_meas_is_done()
+{
+	host::touch_fsm_run();
+	if (host::touch_stalled)
+		return false;
+	const int64_t t = host::time_us - host::touch_start;
+	return host::touch_cycles_done > 0 && t % host::touch_cycle_us() < host::touch_sleep_us();
+}
+
+// Software triggered measurement, blocking
+inline esp_err_t touch_pad_read(touch_pad_t pad, uint16_t *value)
+{
+	*value = host::touch_source(pad);
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_read_raw_data(touch_pad_t pad, uint16_t *value)
+{
+	host::touch_fsm_run();
+	*value = host::touch_latched[pad];
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_read_filtered(touch_pad_t pad, uint16_t *value)
+{
+	return touch_pad_read_raw_data(pad, value);
+}
+
+inline esp_err_t touch_pad_filter_start(uint32_t)
+{
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_filter_stop()
+{
+	return ESP_OK;
+}
+
+inline esp_err_t touch_pad_set_thresh(touch_pad_t pad, uint16_t thresh)
+{
+	host::touch_thresh[pad] = thresh;
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_set_trigger_mode(touch_trigger_mode_t)
+{
+	return ESP_OK;
+}
+
+inline esp_err_t touch_pad_isr_register(void (*)(void *), void *)
+{
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_isr_deregister(void (*)(void *), void *)
+{
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_intr_enable()
+{
+	return ESP_OK;
+}
+inline esp_err_t touch_pad_intr_disable()
+{
+	return ESP_OK;
+}
+inline uint32_t touch_pad_get_status()
+{
+	return 0;
+}
+inline esp_err_t touch_pad_clear_status()
+{
+	return ESP_OK;
+}
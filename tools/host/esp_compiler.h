@@ -0,0 +1,5 @@
+// Host stand-in, branch hints as on target
+#pragma once
+
+#define likely(x) __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
@@ -0,0 +1,16 @@
+// Host stand-in, the test owns the counter
+#pragma once
+
+#include <cstdint>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+namespace host
+{
+	inline esp_cpu_cycle_count_t cycle_count = 0;
+}
+
+inline esp_cpu_cycle_count_t esp_cpu_get_cycle_count()
+{
+	return host::cycle_count;
+}
@@ -0,0 +1,19 @@
+// Host stand-in, logs go to stderr so the numbers a test prints stay on stdout
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+
+#include "esp_err.h"
+
+#define ESP_LOG_HOST(level, tag, format, ...) std::fprintf(stderr, level " (%s) " format "\n", tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_HOST("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_HOST("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_HOST("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) (void)0
+#define ESP_LOGV(tag, format, ...) (void)0
+
+// pulled in through esp_log.h on target
+#define BIT(nr) (1UL << (nr))
+#define IRAM_ATTR
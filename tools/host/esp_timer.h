@@ -0,0 +1,14 @@
+// Host stand-in, the test owns the clock
+#pragma once
+
+#include <cstdint>
+
+namespace host
+{
+	inline int64_t time_us = 0;
+}
+
+inline int64_t esp_timer_get_time()
+{
+	return host::time_us;
+}
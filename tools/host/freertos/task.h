@@ -0,0 +1,57 @@
+// Host stand-in, no scheduler: delays advance the host clock, tasks are not started
+#pragma once
+
+#include "FreeRTOS.h"
+#include "esp_timer.h"
+
+typedef enum
+{
+	eNoAction,
+	eSetBits,
+	eIncrement,
+	eSetValueWithOverwrite,
+} eNotifyAction;
+
+inline void vTaskDelay(TickType_t ticks)
+{
+	host::time_us += int64_t(ticks) * 1000;
+}
+
+inline TickType_t xTaskGetTickCount()
+{
+	return TickType_t(host::time_us / 1000);
+}
+
+inline BaseType_t xTaskDelayUntil(TickType_t *prev, TickType_t inc)
+{
+	*prev += inc;
+	if (host::time_us < int64_t(*prev) * 1000)
+		host::time_us = int64_t(*prev) * 1000;
+	return pdTRUE;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void *), const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *out, BaseType_t)
+{
+	*out = nullptr;
+	return pdFALSE;
+}
+
+inline void vTaskDelete(TaskHandle_t)
+{
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+	return nullptr;
+}
+
+inline BaseType_t xTaskNotifyFromISR(TaskHandle_t, uint32_t, eNotifyAction, BaseType_t *)
+{
+	return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t ticks)
+{
+	vTaskDelay(ticks);
+	return 0;
+}
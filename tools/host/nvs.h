@@ -0,0 +1,71 @@
+// Host stand-in, an in-memory store that starts empty like a freshly erased partition
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "esp_err.h"
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum
+{
+	NVS_READONLY,
+	NVS_READWRITE,
+} nvs_open_mode_t;
+
+#define NVS_KEY_NAME_MAX_SIZE 16
+
+namespace host
+{
+	inline std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvs;
+	inline std::vector<std::string> nvs_handles;
+}
+
+inline esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out)
+{
+	if (mode == NVS_READONLY && !host::nvs.count(name))
+		return ESP_ERR_NVS_NOT_FOUND;
+
+	host::nvs[name];
+	host::nvs_handles.push_back(name);
+	*out = host::nvs_handles.size() - 1;
+	return ESP_OK;
+}
+
+inline void nvs_close(nvs_handle_t)
+{
+}
+
+inline esp_err_t nvs_get_blob(nvs_handle_t h, const char *key, void *out, size_t *len)
+{
+	const auto &ns = host::nvs[host::nvs_handles[h]];
+	const auto it = ns.find(key);
+	if (it == ns.end())
+		return ESP_ERR_NVS_NOT_FOUND;
+
+	if (out)
+	{
+		if (*len < it->second.size())
+			return ESP_ERR_INVALID_SIZE;
+		std::memcpy(out, it->second.data(), it->second.size());
+	}
+	*len = it->second.size();
+	return ESP_OK;
+}
+
+inline esp_err_t nvs_set_blob(nvs_handle_t h, const char *key, const void *data, size_t len)
+{
+	const auto *p = static_cast<const uint8_t *>(data);
+	host::nvs[host::nvs_handles[h]][key].assign(p, p + len);
+	return ESP_OK;
+}
+
+inline esp_err_t nvs_commit(nvs_handle_t)
+{
+	return ESP_OK;
+}
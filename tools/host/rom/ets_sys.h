@@ -0,0 +1,11 @@
+// Host stand-in, busy waits advance the host clock
+#pragma once
+
+#include <cstdint>
+
+#include "esp_timer.h"
+
+inline void ets_delay_us(uint32_t us)
+{
+	host::time_us += us;
+}
@@ -0,0 +1,205 @@
+// AnimationDecoder against the frames its clips were encoded from, on truncated and corrupt clips, and its time per frame.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/animation [frames to time per clip]
+//
+// Clips are generated here and encoded with tools/anim_encoder.h: a clock, scrolling text, a bar graph sweep, noise
+// (the worst case) and the boot animation embedded in the firmware. Every prefix of every clip is decoded from a buffer
+// of exactly its length, so the animation_sanitized build (ASan/UBSan, run without timing) catches any read past the end.
+// A truncated clip has to stop with false before its last frame, and every frame it does give has to be right.
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Animation.h"
+#include "BootAnimation.h"
+#include "SegmentDisplay.h"
+#include "VFD.h"
+
+#include "../anim_encoder.h"
+
+using Frame = AnimationFormat::Frame;
+
+static bool ok = true;
+
+// HH MM on the 7-segment digits, the seconds on the 14-segment digits and on the bar, 10 frames per second
+static std::vector<Frame> clock_frames()
+{
+	using namespace SegmentDisplay;
+	std::vector<Frame> frames;
+	for (unsigned i = 0; i < 600; ++i)
+	{
+		const unsigned t = 23 * 3600 + 59 * 60 + 30 + i / 10;
+		const unsigned h = t / 3600 % 24, m = t / 60 % 60, s = t % 60;
+		Frame f = {};
+		f[VFD::DIGIT1_7] = char_to_7seg('0' + h / 10);
+		f[VFD::DIGIT2_7] = char_to_7seg('0' + h % 10);
+		f[VFD::DIGIT3_9] = char_to_7seg('0' + m / 10);
+		f[VFD::DIGIT4_7_S] = char_to_7seg('0' + m % 10);
+		f[VFD::DIGIT9_14] = char_to_16seg('0' + s / 10);
+		f[VFD::DIGIT10_14] = char_to_16seg('0' + s % 10);
+		const uint32_t bar = (1u << (s % 21)) - 1;
+		for (size_t b = 0; b < 4; ++b)
+			f[VFD::BAR1_1_5 + b] = bar >> (5 * b) & 0b11111;
+		frames.push_back(f);
+	}
+	return frames;
+}
+
+// Text scrolling through the six 14-segment digits, 3 frames per step
+static std::vector<Frame> marquee_frames()
+{
+	const std::string text = "      VFD CLOCK 21.45 HPA 1013 HUMIDITY 40      ";
+	std::vector<Frame> frames;
+	for (size_t i = 0; i < 180; ++i)
+	{
+		Frame f = {};
+		for (size_t d = 0; d < 6; ++d)
+			f[VFD::DIGIT5_14 + d] = SegmentDisplay::char_to_16seg(text[(i / 3 + d) % text.size()]);
+		frames.push_back(f);
+	}
+	return frames;
+}
+
+// The 20 segment bar filling and emptying, 5 frames per segment
+static std::vector<Frame> bar_frames()
+{
+	std::vector<Frame> frames;
+	for (size_t i = 0; i < 200; ++i)
+	{
+		const size_t len = i / 5 <= 20 ? i / 5 : 40 - i / 5;
+		const uint32_t bar = (1u << len) - 1;
+		Frame f = {};
+		for (size_t b = 0; b < 4; ++b)
+			f[VFD::BAR1_1_5 + b] = bar >> (5 * b) & 0b11111;
+		frames.push_back(f);
+	}
+	return frames;
+}
+
+static std::vector<Frame> noise_frames()
+{
+	std::mt19937 rng(47);
+	std::vector<Frame> frames(100);
+	for (Frame &f : frames)
+		for (uint16_t &w : f)
+			w = uint16_t(rng());
+	return frames;
+}
+
+static std::vector<Frame> decode_all(const uint8_t *clip, size_t size)
+{
+	AnimationDecoder dec(clip, size);
+	std::vector<Frame> frames;
+	Frame f;
+	while (dec.next(f))
+		frames.push_back(f);
+	return frames;
+}
+
+static size_t check_round_trip(const std::vector<uint8_t> &clip, const std::vector<Frame> &frames)
+{
+	size_t bad = decode_all(clip.data(), clip.size()) != frames;
+
+	AnimationDecoder dec(clip.data(), clip.size());
+	Frame f = {};
+	bad += !dec.valid() + (dec.frames() != frames.size());
+	while (dec.next(f))
+		;
+	bad += !dec.done() + dec.next(f) + (dec.position() != frames.size()) + (f != frames.back());
+
+	dec.rewind();
+	bad += !dec.next(f) + (f != frames.front()) + (dec.position() != 1);
+	return bad;
+}
+
+// Every prefix, from a heap buffer of exactly that size
+static size_t check_truncated(const std::vector<uint8_t> &clip, const std::vector<Frame> &frames)
+{
+	size_t bad = 0;
+	for (size_t len = 0; len < clip.size(); ++len)
+	{
+		const std::vector<uint8_t> cut(clip.begin(), clip.begin() + len);
+		AnimationDecoder dec(cut.data(), cut.size());
+		Frame f;
+		size_t n = 0;
+		for (; dec.next(f); ++n)
+			bad += n >= frames.size() || f != frames[n];
+		bad += (n >= frames.size()) + !dec.done() + dec.next(f);
+	}
+	return bad;
+}
+
+// A clip with a damaged header must not give a single frame
+static size_t check_corrupt(const std::vector<uint8_t> &clip)
+{
+	size_t bad = 0;
+	for (size_t i = 0; i < 4; ++i)
+	{
+		std::vector<uint8_t> c = clip;
+		c[i] ^= 0x20;
+		AnimationDecoder dec(c.data(), c.size());
+		Frame f;
+		bad += dec.valid() + dec.next(f) + (dec.frames() != 0);
+	}
+	AnimationDecoder none;
+	Frame f;
+	bad += none.valid() + none.next(f);
+	return bad;
+}
+
+volatile uint32_t sink; // keeps the timed loops alive
+
+static double ns_per_frame(const std::vector<uint8_t> &clip, size_t frames, size_t passes)
+{
+	AnimationDecoder dec(clip.data(), clip.size());
+	Frame f;
+	uint32_t check = 0;
+	const auto t0 = std::chrono::steady_clock::now();
+	for (size_t k = 0; k < passes; ++k)
+	{
+		dec.rewind();
+		while (dec.next(f))
+			check += f[k % f.size()];
+	}
+	sink = check;
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / double(passes * frames);
+}
+
+static void check(const char *name, const std::vector<Frame> &frames, size_t frames_per_pass)
+{
+	const std::vector<uint8_t> clip = AnimationEncoder::encode(frames, 100);
+	const size_t bad = check_round_trip(clip, frames) + check_truncated(clip, frames) + check_corrupt(clip);
+
+	const size_t raw = frames.size() * sizeof(Frame);
+	std::printf("  %-8s %4zu frames %6zu -> %5zu B (%4.1fx)", name, frames.size(), raw, clip.size(), double(raw) / clip.size());
+	if (frames_per_pass)
+		std::printf("  %5.1f ns/frame", ns_per_frame(clip, frames.size(), 1 + frames_per_pass / frames.size()));
+	std::printf("  %zu mismatches\n", bad);
+	ok &= bad == 0;
+}
+
+int main(int argc, char **argv)
+{
+	// 0 skips the timing, for the sanitized build
+	const size_t frames_per_pass = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+
+	std::printf("encode, decode every prefix and damaged headers%s\n", frames_per_pass ? ", decode time" : "");
+	check("clock", clock_frames(), frames_per_pass);
+	check("marquee", marquee_frames(), frames_per_pass);
+	check("bar", bar_frames(), frames_per_pass);
+	check("noise", noise_frames(), frames_per_pass);
+
+	// The array in the firmware has to be a clip the decoder plays to the end
+	const std::vector<Frame> boot = decode_all(boot_animation, sizeof(boot_animation));
+	AnimationDecoder dec(boot_animation, sizeof(boot_animation));
+	const bool boot_ok = !boot.empty() && boot.size() == dec.frames() && AnimationEncoder::encode(boot, dec.period_ms()) == std::vector<uint8_t>(boot_animation, boot_animation + sizeof(boot_animation));
+	std::printf("  boot     %4zu frames, %u ms each, %s\n", boot.size(), unsigned(dec.period_ms()), boot_ok ? "matches its source" : "FAIL");
+	ok &= boot_ok;
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
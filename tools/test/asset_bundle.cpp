@@ -0,0 +1,150 @@
+// AssetBundle on a bundle file, the font lookups SegmentDisplay falls back from, and every rejected bundle.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/asset_bundle
+//
+// Built with ASan/UBSan. The bundle is followed by padding, as in the partition, and only the size its header gives
+// may be mapped. Damaged bundles have to fail init() with the matching error and leave nothing mapped.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "AssetBundle.h"
+#include "BootAnimation.h"
+#include "SegmentDisplay.h"
+
+using namespace AssetFormat;
+
+static const char *const PATH = "asset_bundle_test.bin";
+static size_t bad = 0;
+
+static void expect(bool ok, const char *what)
+{
+	if (!ok)
+		std::printf("  FAIL %s\n", what);
+	bad += !ok;
+}
+
+struct Item
+{
+	uint16_t id;
+	Type type;
+	std::vector<uint8_t> data;
+};
+
+// Same layout as tools/asset_pack.cpp writes
+static std::vector<uint8_t> pack(const std::vector<Item> &items, uint16_t count)
+{
+	std::vector<uint8_t> out(sizeof(Header) + count * sizeof(Entry));
+	std::vector<Entry> index(count, Entry{});
+	for (const Item &it : items)
+	{
+		out.resize((out.size() + ALIGN - 1) / ALIGN * ALIGN);
+		index[it.id] = {uint32_t(out.size()), uint32_t(it.data.size()), it.type, {}};
+		out.insert(out.end(), it.data.begin(), it.data.end());
+	}
+
+	Header h = {};
+	std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+	h.version = VERSION;
+	h.count = count;
+	h.size = uint32_t(out.size());
+	std::memcpy(out.data(), &h, sizeof(h));
+	std::memcpy(out.data() + sizeof(h), index.data(), count * sizeof(Entry));
+	return out;
+}
+
+static void write(const std::vector<uint8_t> &bytes)
+{
+	FILE *f = std::fopen(PATH, "wb");
+	if (!bytes.empty())
+		std::fwrite(bytes.data(), 1, bytes.size(), f);
+	std::fclose(f);
+}
+
+int main()
+{
+	// 7-segment font with its own digits, no 16-segment font, the boot clip and a raw blob behind an unused id
+	std::vector<uint8_t> font(GLYPHS * sizeof(uint16_t));
+	for (size_t c = 0; c < GLYPHS; ++c)
+	{
+		const uint16_t pattern = uint16_t(0x80 | c);
+		std::memcpy(font.data() + 2 * c, &pattern, sizeof(pattern));
+	}
+	const std::vector<Item> items = {
+		{Id::FONT_7SEG, Type::FONT, font},
+		{Id::BOOT_ANIMATION, Type::ANIMATION, {boot_animation, boot_animation + sizeof(boot_animation)}},
+		{4, Type::RAW, {1, 2, 3, 4, 5}},
+	};
+	const std::vector<uint8_t> bundle = pack(items, 5);
+
+	std::vector<uint8_t> partition = bundle;
+	partition.resize(bundle.size() + 64 * 1024, 0xFF); // erased flash after the bundle
+	write(partition);
+
+	AssetBundle assets;
+	expect(assets.init(PATH) == ESP_OK, "init");
+	expect(assets.size() == bundle.size(), "maps only the size in the header");
+	expect(assets.version() == VERSION && assets.count() == 5, "version and count");
+
+	const AssetBundle::Asset raw = assets.get(4);
+	expect(raw && raw.type == Type::RAW && raw.size == 5 && raw.data[4] == 5, "raw asset");
+	expect(reinterpret_cast<uintptr_t>(raw.data) % ALIGN == 0, "alignment");
+	expect(!assets.get(3) && !assets.get(5) && !assets.get(0xFFFF), "unused and out of range ids");
+
+	// SegmentDisplay takes the font when there is one, its own table otherwise
+	const uint16_t *f7 = assets.font(Id::FONT_7SEG);
+	const uint16_t *f16 = assets.font(Id::FONT_16SEG);
+	expect(f7 && !f16 && !assets.font(Id::BOOT_ANIMATION), "fonts");
+	expect(assets.glyph(Id::FONT_7SEG, '3') == (0x80 | '3') && assets.glyph(Id::FONT_16SEG, '3') == 0, "glyph");
+	expect(SegmentDisplay::char_to_7seg(f7, '3') == uint8_t(0x80 | '3'), "7-segment from the font");
+	expect(SegmentDisplay::char_to_7seg(f7, char(200)) == SegmentDisplay::char_to_7seg(char(200)), "7-segment beyond the font");
+	for (char c : {'0', '7', 'A', 'z', '-', ' '})
+		expect(SegmentDisplay::char_to_16seg(f16, c) == SegmentDisplay::char_to_16seg(c), "16-segment fallback");
+
+	// The clip plays from the mapping as it does from rodata
+	AnimationDecoder mapped = assets.animation(Id::BOOT_ANIMATION), embedded(boot_animation, sizeof(boot_animation));
+	expect(mapped.valid() && !assets.animation(4).valid(), "animation");
+	AnimationFormat::Frame a, b;
+	size_t frames = 0;
+	for (bool more = true; more; ++frames)
+	{
+		more = mapped.next(a);
+		expect(more == embedded.next(b) && (!more || a == b), "animation frames");
+	}
+	expect(frames == embedded.frames() + 1u, "animation length");
+
+	expect(assets.init(PATH) == ESP_ERR_INVALID_STATE, "second init");
+	assets.deinit();
+	expect(!assets.is_open() && assets.size() == 0 && assets.count() == 0, "deinit");
+
+	// Damaged bundles
+	const auto rejected = [&](const std::vector<uint8_t> &bytes, esp_err_t err, const char *what)
+	{
+		write(bytes);
+		expect(assets.init(PATH) == err && !assets.is_open() && !assets.get(4), what);
+		assets.deinit();
+	};
+	const auto patched = [&](size_t at, uint8_t v)
+	{
+		std::vector<uint8_t> b = bundle;
+		b[at] = v;
+		return b;
+	};
+	const size_t entry4 = sizeof(Header) + 4 * sizeof(Entry);
+
+	rejected({bundle.begin(), bundle.end() - 1}, ESP_ERR_INVALID_SIZE, "truncated");
+	rejected({bundle.begin(), bundle.begin() + sizeof(Header) - 1}, ESP_ERR_NOT_FOUND, "shorter than the header");
+	rejected({}, ESP_ERR_NOT_FOUND, "empty");
+	rejected(patched(0, 'X'), ESP_ERR_NOT_FOUND, "magic");
+	rejected(patched(4, VERSION + 1), ESP_ERR_INVALID_VERSION, "version");
+	rejected(patched(entry4 + 3, 0x7F), ESP_ERR_INVALID_SIZE, "offset beyond the bundle");
+	rejected(patched(entry4 + 7, 0x7F), ESP_ERR_INVALID_SIZE, "size beyond the bundle");
+	rejected(patched(entry4, uint8_t(bundle[entry4] + 1)), ESP_ERR_INVALID_SIZE, "misaligned offset");
+	rejected(patched(8, 20), ESP_ERR_INVALID_SIZE, "index beyond the size in the header");
+	std::remove(PATH);
+	expect(assets.init(PATH) == ESP_ERR_NOT_FOUND, "missing file");
+
+	std::printf("%s\n", bad == 0 ? "OK" : "FAIL");
+	return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+// FastMath and the Atmospherics / BME280 derived values against libm in double, over the range they document.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/atmospherics [steps per axis]
+//
+// Each function is swept on a regular grid (FastMath additionally on every 64th float of its interval) and the largest
+// error is printed next to the bound its header comment gives. The reference for the derived values is the same formula
+// in double with std::log / std::exp / std::pow, so only the approximations and float rounding are measured, not the
+// Magnus or barometric models themselves.
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cfloat>
+#include <bit>
+
+#include "Atmospherics.h"
+
+static bool ok = true;
+
+struct Max
+{
+	double err = 0;
+	double at = 0, at2 = 0;
+
+	void update(double e, double x, double y = 0)
+	{
+		if (e > err)
+			err = e, at = x, at2 = y;
+	}
+};
+
+static void report(const char *name, const Max &m, double bound, const char *unit)
+{
+	const bool pass = m.err <= bound;
+	std::printf("  %-20s max %.3e %-9s bound %.1e  (at %g, %g)  %s\n", name, m.err, unit, bound, m.at, m.at2, pass ? "" : "FAIL");
+	ok &= pass;
+}
+
+static double rel(double got, double ref)
+{
+	return std::fabs(got - ref) / std::fabs(ref);
+}
+
+// Every 64th float in [lo, hi), both positive
+template <typename F>
+static void floats(float lo, float hi, F f)
+{
+	for (uint32_t b = std::bit_cast<uint32_t>(lo), end = std::bit_cast<uint32_t>(hi); b < end; b += 64)
+		f(std::bit_cast<float>(b));
+}
+
+static void check_fast_math(size_t steps)
+{
+	Max log2_err, exp2_err, log_err, exp_err, pow_err;
+
+	floats(FLT_MIN, FLT_MAX, [&](float x)
+	{
+		log2_err.update(std::fabs(FastMath::log2(x) - std::log2(double(x))), x);
+		log_err.update(std::fabs(FastMath::log(x) - std::log(double(x))), x);
+	});
+	report("log2", log2_err, 2.1e-5, "abs");
+	report("log", log_err, 2e-5, "abs");
+
+	for (size_t i = 0; i <= 64 * steps; ++i)
+	{
+		const float x = -126.0f + 253.0f * i / (64 * steps);
+		exp2_err.update(rel(FastMath::exp2(x), std::exp2(double(x))), x);
+	}
+	report("exp2", exp2_err, 1.8e-7, "rel");
+
+	// exp against its bound scaled by |x|, x in [-87, 88] where the result stays normal
+	for (size_t i = 0; i <= 64 * steps; ++i)
+	{
+		const float x = -87.0f + 175.0f * i / (64 * steps);
+		exp_err.update(rel(FastMath::exp(x), std::exp(double(x))) / (1.8e-7 + 1.2e-7 * std::fabs(x)), x);
+	}
+	report("exp / (1.8e-7+1.2e-7|x|)", exp_err, 1, "");
+
+	// pow on the bases and exponents BME280 uses and well beyond
+	for (size_t i = 0; i <= steps; ++i)
+		for (size_t j = 0; j <= steps / 4; ++j)
+		{
+			const float x = std::ldexp(1.0f, -4) + (16.0f - std::ldexp(1.0f, -4)) * i / steps;
+			const float y = -8.0f + 16.0f * j / (steps / 4);
+			pow_err.update(rel(FastMath::pow(x, y), std::pow(double(x), double(y))) / (1.8e-7 + 1.5e-5 * std::fabs(y)), x, y);
+		}
+	report("pow / (1.8e-7+1.5e-5|y|)", pow_err, 1, "");
+}
+
+// Atmospherics.h in double
+static double ref_dew_point(double t, double rh)
+{
+	const double gamma = std::log(std::max(rh, 0.1) * 0.01) + 17.62 * t / (243.12 + t);
+	return 243.12 * gamma / (17.62 - gamma);
+}
+
+static double ref_absolute_humidity(double t, double rh)
+{
+	return 216.7 * 6.112 * 0.01 * rh * std::exp(17.62 * t / (243.12 + t)) / (273.15 + t);
+}
+
+// The switch to the regression is a step of up to ~1.2 DegC, *near is set where float rounding can take the other side
+static double ref_heat_index(double t, double rh, bool *near)
+{
+	const double f = t * 1.8 + 32;
+	double hi = 0.5 * (f + 61 + (f - 68) * 1.2 + rh * 0.094);
+	*near = std::fabs((hi + f) * 0.5 - 80) < 1e-4;
+	if ((hi + f) * 0.5 >= 80)
+	{
+		hi = -42.379 + 2.04901523 * f + 10.14333127 * rh - 0.22475541 * f * rh - 0.00683783 * f * f - 0.05481717 * rh * rh + 0.00122874 * f * f * rh + 0.00085282 * f * rh * rh - 0.00000199 * f * f * rh * rh;
+		if (rh < 13 && f > 80 && f < 112)
+			hi -= (13 - rh) * 0.25 * std::sqrt((17 - std::fabs(f - 95)) / 17);
+		else if (rh > 85 && f > 80 && f < 87)
+			hi += (rh - 85) * 0.1 * (87 - f) * 0.2;
+	}
+	return (hi - 32) / 1.8;
+}
+
+// BME280.h in double, with its (private) constants as the float members hold them
+static constexpr double g = 9.80665f, cp = 1004.68506f, T0 = 288.15f, M = 0.02896968f, R0 = 8.314462618f;
+
+static double ref_sea_level_pressure(double p, double h)
+{
+	return p * std::pow(1 - h * (g / cp / T0), -cp * M / R0);
+}
+
+static double ref_altitude(double p, double p0)
+{
+	return cp * T0 / g * (1 - std::pow(p / p0, R0 / cp / M));
+}
+
+static void check_derived(size_t steps)
+{
+	Max dew, abs_hum, heat, slp, alt;
+	size_t switches = 0;
+
+	// T in [-40, 85] DegC, RH in [1, 100] %
+	for (size_t i = 0; i <= steps; ++i)
+		for (size_t j = 0; j <= steps; ++j)
+		{
+			const float t = -40.0f + 125.0f * i / steps, rh = 1.0f + 99.0f * j / steps;
+			dew.update(std::fabs(Atmospherics::dew_point(t, rh) - ref_dew_point(t, rh)), t, rh);
+			abs_hum.update(rel(Atmospherics::absolute_humidity(t, rh), ref_absolute_humidity(t, rh)), t, rh);
+
+			bool near;
+			const double hi = ref_heat_index(t, rh, &near);
+			if (near)
+				++switches;
+			else
+				heat.update(std::fabs(Atmospherics::heat_index(t, rh) - hi), t, rh);
+		}
+	report("dew_point", dew, 3e-4, "DegC");
+	report("absolute_humidity", abs_hum, 1.5e-6, "rel");
+	report("heat_index", heat, 1e-3, "DegC");
+	std::printf("  %zu heat_index samples skipped within rounding of the 80 F switch\n", switches);
+
+	// p in [30, 110] kPa, station altitude in [0, 3000] m, p0 in [95, 105] kPa
+	for (size_t i = 0; i <= steps; ++i)
+		for (size_t j = 0; j <= steps / 4; ++j)
+		{
+			BME280::Meas meas = {};
+			meas.pressure = 30000.0f + 80000.0f * i / steps;
+			const float h = 3000.0f * j / (steps / 4), p0 = 95000.0f + 10000.0f * j / (steps / 4);
+			slp.update(rel(BME280::get_sea_level_pressure(meas, h), ref_sea_level_pressure(meas.pressure, h)), meas.pressure, h);
+			alt.update(std::fabs(BME280::get_sea_level_altitude(meas, p0) - ref_altitude(meas.pressure, p0)), meas.pressure, p0);
+		}
+	report("sea_level_pressure", slp, 3.5e-5, "rel");
+	report("sea_level_altitude", alt, 0.12, "m");
+}
+
+int main(int argc, char **argv)
+{
+	const size_t steps = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+
+	std::printf("FastMath against libm, over the documented intervals\n");
+	check_fast_math(steps);
+	std::printf("derived values against the same formulas in double, %zu steps per axis\n", steps);
+	check_derived(steps);
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+// Lazy BitMatrix operator expressions against the same operations done eagerly, and the time per expression.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/bit_expr [rounds]
+//
+// The eager side uses the member ops (Apq, Kpq, ...) with one matrix per operator, as the operators worked before
+// BitExpr. Covers every operator, nested mixes, assignments that read their own target, the compound operators with
+// expressions, the queries an expression answers directly and a shape with two words per row.
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+
+#include "BitMatrix.h"
+
+static std::mt19937_64 rng(45);
+static size_t bad = 0;
+
+template <size_t H, size_t W>
+static BitMatrix<H, W> random_matrix()
+{
+	BitMatrix<H, W> m;
+	for (size_t y = 0; y < H; ++y)
+		for (size_t x = 0; x < W; ++x)
+			m.set(y, x, rng() & 1);
+	return m;
+}
+
+template <size_t H, size_t W>
+static void same(const BitMatrix<H, W> &lazy, const BitMatrix<H, W> &eager)
+{
+	for (size_t y = 0; y < H; ++y)
+		for (size_t x = 0; x < W; ++x)
+			bad += lazy.test(y, x) != eager.test(y, x);
+}
+
+// One materialised matrix per operator
+template <size_t H, size_t W>
+struct Eager
+{
+	using M = BitMatrix<H, W>;
+	static M op_or(M a, const M &b) { return a.Apq(b); }
+	static M op_and(M a, const M &b) { return a.Kpq(b); }
+	static M op_xor(M a, const M &b) { return a.Jpq(b); }
+	static M op_minus(M a, const M &b) { return a.Lpq(b); }
+	static M op_or_not(M a, const M &b) { return a.Bpq(b); }
+	static M op_nor(M a, const M &b) { return a.Xpq(b); }
+	static M op_nand(M a, const M &b) { return a.Dpq(b); }
+	static M op_xnor(M a, const M &b) { return a.Epq(b); }
+	static M op_not(M a) { return a.Fpq(); }
+};
+
+static BitMatrix<16, 16> returned(const BitMatrix<16, 16> &a, const BitMatrix<16, 16> &b)
+{
+	return a ^ b; // a function returning BitMatrix from an expression
+}
+
+template <size_t H, size_t W>
+static void check()
+{
+	using M = BitMatrix<H, W>;
+	using E = Eager<H, W>;
+	const M a = random_matrix<H, W>(), b = random_matrix<H, W>(), c = random_matrix<H, W>(), d = random_matrix<H, W>();
+
+	same<H, W>(a | b, E::op_or(a, b));
+	same<H, W>(a & b, E::op_and(a, b));
+	same<H, W>(a ^ b, E::op_xor(a, b));
+	same<H, W>(a - b, E::op_minus(a, b));
+	same<H, W>(a / b, E::op_or_not(a, b));
+	same<H, W>(a || b, E::op_nor(a, b));
+	same<H, W>(a && b, E::op_nand(a, b));
+	same<H, W>(a == b, E::op_xnor(a, b));
+	same<H, W>(a != b, E::op_xor(a, b));
+	same<H, W>(!a, E::op_not(a));
+
+	// nested
+	same<H, W>(((a | b) - c) ^ d, E::op_xor(E::op_minus(E::op_or(a, b), c), d));
+	same<H, W>((a || b) && (c == d), E::op_nand(E::op_nor(a, b), E::op_xnor(c, d)));
+	same<H, W>((a != b) / c & !d, E::op_and(E::op_or_not(E::op_xor(a, b), c), E::op_not(d)));
+	same<H, W>(!(a ^ b), E::op_not(E::op_xor(a, b)));
+	same<H, W>(a.dilation('8') - a, E::op_minus(a.dilation('8'), a));
+
+	// the target is an operand
+	M y = a;
+	y = (y | b) ^ y;
+	same(y, E::op_xor(E::op_or(a, b), a));
+	y = a;
+	y = (!y) & (b | y);
+	same(y, E::op_and(E::op_not(a), E::op_or(b, a)));
+
+	// compound operators with expressions
+	y = a;
+	y |= b & c;
+	same(y, E::op_or(a, E::op_and(b, c)));
+	y = a;
+	y &= b ^ c;
+	same(y, E::op_and(a, E::op_xor(b, c)));
+	y = a;
+	y ^= !b;
+	same(y, E::op_xor(a, E::op_not(b)));
+	y = a;
+	y -= b | c;
+	same(y, E::op_minus(a, E::op_or(b, c)));
+	y = a;
+	y /= b ^ c;
+	same(y, E::op_or_not(a, E::op_xor(b, c)));
+
+	// queries without materialising, and eval()
+	const M x = E::op_and(a, b);
+	bad += (a & b).any() != x.any() || (a & b).none() != x.none() || (a & b).all() != x.all();
+	bad += !(a | !a).all() || !(a - a).none();
+	for (size_t i = 0; i < H * W; ++i)
+		bad += (a & b).test(i / W, i % W) != x.test(i / W, i % W) || (a & b)(i / W, i % W) != x(i / W, i % W);
+	same((a & b).eval(), x);
+}
+
+template <typename F>
+static double ns_per_op(size_t n, F &&f)
+{
+	const auto t0 = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < n; ++i)
+		f(i);
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+
+	for (size_t i = 0; i < rounds; ++i)
+	{
+		check<16, 16>();
+		check<5, 70>();
+		check<1, 1>();
+
+		const BitMatrix<16, 16> p = random_matrix<16, 16>(), q = random_matrix<16, 16>();
+		same(returned(p, q), Eager<16, 16>::op_xor(p, q));
+	}
+	std::printf("%zu random rounds on 16x16, 5x70 and 1x1: %zu mismatches\n", rounds, bad);
+
+	using M16 = BitMatrix<16, 16>;
+	using E16 = Eager<16, 16>;
+	M16 clock = random_matrix<16, 16>(), symbols = random_matrix<16, 16>(), mask = random_matrix<16, 16>(), blink = random_matrix<16, 16>(), out;
+
+	using M64 = BitMatrix<64, 64>;
+	using E64 = Eager<64, 64>;
+	M64 a = random_matrix<64, 64>(), b = random_matrix<64, 64>(), c = random_matrix<64, 64>(), d = random_matrix<64, 64>(), e = random_matrix<64, 64>(), o;
+
+	// each round changes one bit, so no round can be hoisted, and the barrier makes it store the whole result
+	constexpr size_t N = 2000000;
+	const double eager16 = ns_per_op(N, [&](size_t i)
+									 {
+		clock.set(i % 16, i * 3 % 16, i & 1);
+		out = E16::op_xor(E16::op_minus(E16::op_or(clock, symbols), mask), blink);
+		asm volatile("" : : "g"(&out) : "memory"); });
+	const double lazy16 = ns_per_op(N, [&](size_t i)
+									{
+		clock.set(i % 16, i * 3 % 16, i & 1);
+		out = ((clock | symbols) - mask) ^ blink;
+		asm volatile("" : : "g"(&out) : "memory"); });
+	const double eager64 = ns_per_op(N / 10, [&](size_t i)
+									 {
+		a.set(i % 64, i * 3 % 64, i & 1);
+		o = E64::op_and(E64::op_xor(E64::op_minus(E64::op_or(a, b), c), d), e);
+		asm volatile("" : : "g"(&o) : "memory"); });
+	const double lazy64 = ns_per_op(N / 10, [&](size_t i)
+									{
+		a.set(i % 64, i * 3 % 64, i & 1);
+		o = (((a | b) - c) ^ d) & e;
+		asm volatile("" : : "g"(&o) : "memory"); });
+
+	std::printf("one matrix per operator / lazy expression\n");
+	std::printf("  16x16 ((clock | symbols) - mask) ^ blink  %5.1f / %5.1f ns\n", eager16, lazy16);
+	std::printf("  64x64 (((A | B) - C) ^ D) & E             %5.1f / %5.1f ns\n", eager64, lazy64);
+
+	std::printf("%s\n", bad == 0 ? "OK" : "FAIL");
+	return bad == 0 ? 0 : 1;
+}
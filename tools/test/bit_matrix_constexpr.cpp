@@ -0,0 +1,70 @@
+// Compile-time checks of the constexpr BitMatrix, Matrix and PackedBitMatrix API.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/bit_matrix_constexpr
+//
+// Everything here is a static_assert, so a change that breaks constant evaluation fails the build of this test,
+// without costing compile time in the firmware files that include the headers.
+
+#include <cstdio>
+
+#include "PackedBitMatrix.h"
+
+namespace BitMatrixChecks
+{
+	constexpr auto A = BitMatrix<3, 4>::parse("#..#\n"
+											  ".##.\n"
+											  "#...");
+
+	static_assert(A.test(0, 0) && !A.test(0, 1) && A.test(1, 2) && A.test(2, 0) && A.count() == 5);
+	static_assert(A.find_first() == 0 && A.find_last() == 8);
+	static_assert(A.bounding_box().height() == 3 && A.bounding_box().width() == 4);
+	static_assert(A.components('4') == 4 && A.components('8') == 1);
+	static_assert((A ^ A).none() && (A | !A).all() && (A.transposed().transposed() != A).none());
+	static_assert((A - A.dilation('4')).none() && (A.erosion('8') - A).none() && (A.opening('8') - A).none());
+
+	constexpr auto WIDE = [] // rows of two words
+	{
+		BitMatrix<2, 70> b;
+		b.set({0, 0});
+		b.set({1, 69});
+		return b;
+	}();
+
+	static_assert(WIDE.dilation('8').count() == 8 && WIDE.find_last() == 139 && WIDE.transposed().test(69, 1));
+
+	// dilate/erode step by doubling, num 5 is steps of 1, 2 and 2
+	constexpr auto DOT = BitMatrix<11, 11>().set({5, 5});
+	static_assert(DOT.dilation('8', 5).all() && DOT.dilation('8', 5).erosion('8', 5).count() == 1);
+	static_assert(DOT.dilation('4', 5).count() == 61 && DOT.dilation('4', 5).erosion('4', 5).test(5, 5));
+
+	constexpr auto M = []
+	{
+		Matrix<uint8_t, 2, 3> m;
+		m(0, 1) = 5;
+		m(1, 2) = 200;
+		return m;
+	}();
+
+	static_assert(M.max() == 200 && M.min() == 0 && M.sum() == 205 && (M > 4).count() == 2);
+	static_assert(M.bitplanes()[0].count() == 1 && M.bitplanes()[7].test(1, 2));
+	static_assert(Matrix<uint8_t, 2, 3>().from_bitplanes(M.bitplanes())(1, 2) == 200);
+
+	constexpr auto LABELS = []
+	{
+		Matrix<uint8_t, 3, 4> l;
+		A.label(l, '4');
+		return l;
+	}();
+
+	static_assert(LABELS(0, 0) == 1 && LABELS(0, 3) == 2 && LABELS(1, 1) == 3 && LABELS(1, 2) == 3 && LABELS(2, 0) == 4);
+
+	// the packed layout agrees at compile time as well
+	constexpr PackedBitMatrix<3, 4> P(A);
+	static_assert(P.count() == 5 && P.transposed().transposed() == P && P.dilation('8') == PackedBitMatrix<3, 4>(A.dilation('8')));
+};
+
+int main()
+{
+	std::printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,192 @@
+// BitMatrix and PackedBitMatrix dilate/erode against the one-cross-per-iteration implementation they replaced.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/bit_morphology [rounds]
+//
+// Every matrix of up to 16 pixels (1x9 ... 4x4) and random ones up to 64x64, both connectivities, num 0 up to past the
+// matrix size. Then ns per dilation and erosion for the old loop, BitMatrix and PackedBitMatrix at display sizes and 64x64.
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+
+#include "PackedBitMatrix.h"
+
+// The previous BitMatrix::dilate/erode: num passes of the 3x3 square or the cross, outside counts as 0
+template <size_t H, size_t W>
+static BitMatrix<H, W> &old_dilate(BitMatrix<H, W> &m, char conn, size_t num)
+{
+	using row_t = typename BitMatrix<H, W>::row_t;
+	for (; num > 0; --num)
+	{
+		if (conn == '8')
+			for (size_t y = 0; y < H; ++y)
+				m[y] |= m[y] << 1 | m[y] >> 1;
+
+		row_t prev;
+		for (size_t y = 0; y < H; ++y)
+		{
+			const row_t cur = m[y];
+			const row_t next = y + 1 < H ? m[y + 1] : row_t();
+			m[y] |= (conn == '8' ? row_t() : cur << 1 | cur >> 1) | next | prev;
+			prev = cur;
+		}
+	}
+	return m;
+}
+
+template <size_t H, size_t W>
+static BitMatrix<H, W> &old_erode(BitMatrix<H, W> &m, char conn, size_t num)
+{
+	using row_t = typename BitMatrix<H, W>::row_t;
+	for (; num > 0; --num)
+	{
+		if (conn == '8')
+			for (size_t y = 0; y < H; ++y)
+				m[y] &= m[y] << 1 & m[y] >> 1;
+
+		row_t prev;
+		for (size_t y = 0; y < H; ++y)
+		{
+			const row_t cur = m[y];
+			const row_t next = y + 1 < H ? m[y + 1] : row_t();
+			m[y] &= (conn == '8' ? ~row_t() : cur << 1 & cur >> 1) & next & prev;
+			prev = cur;
+		}
+	}
+	return m;
+}
+
+// Mismatches of dilate, erode, opening and gradient in both classes on matrix a
+template <size_t H, size_t W>
+static size_t compare(const BitMatrix<H, W> &a, size_t max_num)
+{
+	size_t bad = 0;
+	const PackedBitMatrix<H, W> pa(a);
+	for (char conn : {'4', '8'})
+		for (size_t num = 0; num <= max_num; ++num)
+		{
+			BitMatrix<H, W> d = a, e = a, o = a;
+			old_dilate(d, conn, num);
+			old_erode(e, conn, num);
+			old_dilate(old_erode(o, conn, num), conn, num);
+			const BitMatrix<H, W> g = d - e;
+
+			bad += (a.dilation(conn, num) != d).any() + (a.erosion(conn, num) != e).any();
+			bad += (a.opening(conn, num) != o).any() + (a.gradient(conn, num) != g).any();
+			bad += !(pa.dilation(conn, num) == PackedBitMatrix<H, W>(d)) + !(pa.erosion(conn, num) == PackedBitMatrix<H, W>(e));
+		}
+	return bad;
+}
+
+static bool ok = true;
+
+template <size_t H, size_t W>
+static void exhaustive()
+{
+	static_assert(H * W <= 16);
+	size_t bad = 0;
+	for (uint32_t bits = 0; bits < 1u << (H * W); ++bits)
+	{
+		BitMatrix<H, W> a;
+		for (size_t i = 0; i < H * W; ++i)
+			a.set(i / W, i % W, bits >> i & 1);
+		bad += compare(a, std::max(H, W) + 1);
+	}
+	std::printf("  %zux%-2zu all %6u matrices  %zu mismatches\n", H, W, 1u << (H * W), bad);
+	ok &= bad == 0;
+}
+
+static std::mt19937_64 rng(42);
+
+template <size_t H, size_t W>
+static BitMatrix<H, W> random_matrix(unsigned density)
+{
+	BitMatrix<H, W> m;
+	for (size_t y = 0; y < H; ++y)
+		for (size_t x = 0; x < W; ++x)
+			m.set(y, x, rng() % 100 < density);
+	return m;
+}
+
+template <size_t H, size_t W>
+static void random(size_t rounds)
+{
+	const unsigned density[] = {5, 30, 70, 95};
+	size_t bad = 0;
+	for (size_t i = 0; i < rounds; ++i)
+		bad += compare(random_matrix<H, W>(density[i % 4]), 9);
+	std::printf("  %zux%-2zu %4zu random matrices  %zu mismatches\n", H, W, rounds, bad);
+	ok &= bad == 0;
+}
+
+volatile bool sink; // keeps the timed loops alive
+
+template <typename M, typename F>
+static double ns_per_op(const M &a, F &&f)
+{
+	using clock = std::chrono::steady_clock;
+	constexpr size_t N = 200000;
+	M m = a;
+	const auto t0 = clock::now();
+	for (size_t i = 0; i < N; ++i)
+	{
+		m = a;
+		f(m);
+		asm volatile("" : : "g"(&m) : "memory");
+	}
+	const auto t1 = clock::now();
+	sink = m.any();
+	return std::chrono::duration<double, std::nano>(t1 - t0).count() / N;
+}
+
+template <size_t H, size_t W>
+static void bench()
+{
+	const BitMatrix<H, W> a = random_matrix<H, W>(20);
+	const PackedBitMatrix<H, W> pa(a);
+	for (char conn : {'4', '8'})
+		for (size_t num : {1, 2, 3, 8})
+		{
+			std::printf("  %2zux%-2zu conn %c num %zu  dilate %6.1f / %6.1f / %6.1f   erode %6.1f / %6.1f / %6.1f\n", H, W, conn, num,
+						ns_per_op(a, [&](auto &m)
+								  { old_dilate(m, conn, num); }),
+						ns_per_op(a, [&](auto &m)
+								  { m.dilate(conn, num); }),
+						ns_per_op(pa, [&](auto &m)
+								  { m.dilate(conn, num); }),
+						ns_per_op(a, [&](auto &m)
+								  { old_erode(m, conn, num); }),
+						ns_per_op(a, [&](auto &m)
+								  { m.erode(conn, num); }),
+						ns_per_op(pa, [&](auto &m)
+								  { m.erode(conn, num); }));
+		}
+}
+
+int main(int argc, char **argv)
+{
+	const size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+
+	std::printf("against the previous dilate/erode, conn 4 and 8, num 0 to past the size\n");
+	exhaustive<1, 9>();
+	exhaustive<9, 1>();
+	exhaustive<2, 7>();
+	exhaustive<3, 3>();
+	exhaustive<3, 5>();
+	exhaustive<5, 3>();
+	exhaustive<4, 4>();
+	random<5, 7>(rounds);
+	random<16, 16>(rounds);
+	random<3, 70>(rounds);
+	random<2, 128>(rounds);
+	random<64, 64>(rounds / 4);
+
+	std::printf("ns per op, previous / BitMatrix / PackedBitMatrix, 20 %% set\n");
+	bench<16, 16>();
+	bench<7, 10>();
+	bench<64, 64>();
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
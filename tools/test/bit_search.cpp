@@ -0,0 +1,243 @@
+// BitMatrix and PackedBitMatrix counts, search, bounding box and labelling against per-pixel loops, and their timings.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/bit_search [rounds]
+//
+// Random matrices at 0, 15 and 50% density, 4 and 8 connectivity, shapes from a single pixel to several words per row.
+// Components and labels are checked against a flood-fill labeller that numbers components in raster order, and
+// component() has to return exactly the pixels flood-fill gives the same label.
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "PackedBitMatrix.h"
+
+static std::mt19937_64 rng(46);
+static bool ok = true;
+
+template <size_t H, size_t W>
+static BitMatrix<H, W> random_matrix(unsigned density)
+{
+	BitMatrix<H, W> m;
+	for (size_t y = 0; y < H; ++y)
+		for (size_t x = 0; x < W; ++x)
+			m.set(y, x, rng() % 100 < density);
+	return m;
+}
+
+// Depth first flood fill from every unlabelled set pixel in raster order
+template <size_t H, size_t W>
+static size_t naive_label(const BitMatrix<H, W> &m, char conn, Matrix<uint16_t, H, W> &labels)
+{
+	labels = Matrix<uint16_t, H, W>();
+	std::vector<std::pair<int, int>> stack;
+	size_t n = 0;
+	for (size_t y = 0; y < H; ++y)
+		for (size_t x = 0; x < W; ++x)
+		{
+			if (!m.test(y, x) || labels(y, x))
+				continue;
+			labels(y, x) = ++n;
+			stack.push_back({int(y), int(x)});
+			while (!stack.empty())
+			{
+				const auto [cy, cx] = stack.back();
+				stack.pop_back();
+				for (int dy = -1; dy <= 1; ++dy)
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						const int ny = cy + dy, nx = cx + dx;
+						if ((dy == 0 && dx == 0) || (conn == '4' && dy != 0 && dx != 0))
+							continue;
+						if (ny < 0 || nx < 0 || ny >= int(H) || nx >= int(W))
+							continue;
+						if (m.test(ny, nx) && !labels(ny, nx))
+						{
+							labels(ny, nx) = n;
+							stack.push_back({ny, nx});
+						}
+					}
+			}
+		}
+	return n;
+}
+
+template <size_t H, size_t W>
+static void check(size_t rounds)
+{
+	constexpr size_t npos = H * W;
+	size_t bad = 0;
+	for (size_t i = 0; i < rounds; ++i)
+	{
+		const BitMatrix<H, W> a = random_matrix<H, W>(i % 3 == 0 ? 0 : i % 3 == 1 ? 15 : 50);
+		const PackedBitMatrix<H, W> p(a);
+
+		size_t n = 0, first = npos, last = npos;
+		std::array<size_t, H> rows{};
+		std::array<size_t, W> cols{};
+		BitBox box{H, W, 0, 0};
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				if (a.test(y, x))
+				{
+					++n, ++rows[y], ++cols[x];
+					if (first == npos)
+						first = y * W + x;
+					last = y * W + x;
+					box = {std::min(box.y0, y), std::min(box.x0, x), std::max(box.y1, y + 1), std::max(box.x1, x + 1)};
+				}
+		if (n == 0)
+			box = BitBox();
+		const auto same_box = [&](const BitBox &b)
+		{ return b.y0 == box.y0 && b.x0 == box.x0 && b.y1 == box.y1 && b.x1 == box.x1; };
+
+		bad += (a.count() != n) + (p.count() != n);
+		bad += (a.row_counts() != rows) + (p.row_counts() != rows);
+		bad += (a.col_counts() != cols) + (p.col_counts() != cols);
+		bad += (a.find_first() != first) + (p.find_first() != first) + (a.find_last() != last) + (p.find_last() != last);
+		bad += !same_box(a.bounding_box()) + !same_box(p.bounding_box());
+
+		for (const char conn : {'4', '8'})
+		{
+			Matrix<uint16_t, H, W> expected, la, lp;
+			const size_t k = naive_label(a, conn, expected);
+			bad += (a.label(la, conn) != k) + (p.label(lp, conn) != k);
+			bad += (a.components(conn) != k) + (p.components(conn) != k);
+			for (size_t y = 0; y < H; ++y)
+				for (size_t x = 0; x < W; ++x)
+					bad += (la(y, x) != expected(y, x)) + (lp(y, x) != expected(y, x));
+
+			// the component of one pixel, set or not
+			const size_t cy = rng() % H, cx = rng() % W;
+			const BitMatrix<H, W> ca = a.component(cy, cx, conn);
+			const PackedBitMatrix<H, W> cp = p.component(cy, cx, conn);
+			for (size_t y = 0; y < H; ++y)
+				for (size_t x = 0; x < W; ++x)
+				{
+					const bool in = expected(cy, cx) != 0 && expected(y, x) == expected(cy, cx);
+					bad += (ca.test(y, x) != in) + (cp.test(y, x) != in);
+				}
+		}
+	}
+	std::printf("  %2zux%-3zu %zu mismatches\n", H, W, bad);
+	ok &= bad == 0;
+}
+
+volatile size_t sink; // keeps the timed loops alive
+
+template <size_t H, size_t W>
+static void bench()
+{
+	using clock = std::chrono::steady_clock;
+	const size_t n = H > 32 ? 2000 : 20000;
+	BitMatrix<H, W> a = random_matrix<H, W>(20);
+	PackedBitMatrix<H, W> p(a);
+	Matrix<uint16_t, H, W> labels;
+
+	const auto per_op = [](clock::time_point t0, size_t rounds)
+	{
+		return std::chrono::duration<double, std::nano>(clock::now() - t0).count() / rounds;
+	};
+
+	// each round changes one bit, so no round can be hoisted
+	auto t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		a.set(i % H, i * 7 % W, i & 1);
+		size_t count = 0;
+		std::array<size_t, W> cols{};
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				if (a.test(y, x))
+					++count, ++cols[x];
+		sink = count + cols[i % W];
+	}
+	const double count_naive = per_op(t0, n);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		a.set(i % H, i * 7 % W, i & 1);
+		sink = a.count() + a.col_counts()[i % W];
+	}
+	const double count_bits = per_op(t0, n);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		p.set(i % H, i * 7 % W, i & 1);
+		sink = p.count() + p.col_counts()[i % W];
+	}
+	const double count_packed = per_op(t0, n);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		a.set(i % H, i * 7 % W, i & 1);
+		const BitBox box = a.bounding_box();
+		sink = box.y0 + box.x0 + box.y1 + box.x1;
+	}
+	const double box_bits = per_op(t0, n);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		p.set(i % H, i * 7 % W, i & 1);
+		const BitBox box = p.bounding_box();
+		sink = box.y0 + box.x0 + box.y1 + box.x1;
+	}
+	const double box_packed = per_op(t0, n);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n / 10; ++i)
+	{
+		a.set(i % H, i * 7 % W, i & 1);
+		sink = naive_label(a, '8', labels) + labels(i % H, i % W);
+	}
+	const double label_naive = per_op(t0, n / 10);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n / 10; ++i)
+	{
+		a.set(i % H, i * 7 % W, i & 1);
+		sink = a.label(labels, '8') + labels(i % H, i % W);
+	}
+	const double label_bits = per_op(t0, n / 10);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n / 10; ++i)
+	{
+		p.set(i % H, i * 7 % W, i & 1);
+		sink = p.label(labels, '8') + labels(i % H, i % W);
+	}
+	const double label_packed = per_op(t0, n / 10);
+
+	std::printf("  %2zux%-3zu count + col_counts %5.0f / %4.0f / %4.0f ns   bounding_box %3.0f / %3.0f ns   label 8 %6.0f / %5.0f / %5.0f ns\n",
+				H, W, count_naive, count_bits, count_packed, box_bits, box_packed, label_naive, label_bits, label_packed);
+}
+
+int main(int argc, char **argv)
+{
+	const size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 60;
+
+	std::printf("%zu random matrices per shape, against per-pixel loops and flood fill\n", rounds);
+	check<1, 1>(rounds);
+	check<1, 9>(rounds);
+	check<9, 1>(rounds);
+	check<4, 4>(rounds);
+	check<5, 7>(rounds);
+	check<16, 16>(rounds);
+	check<12, 40>(rounds);
+	check<8, 64>(rounds);
+	check<6, 100>(rounds);
+	check<33, 32>(rounds);
+
+	std::printf("per-pixel loop / BitMatrix / Packed (bounding_box: BitMatrix / Packed)\n");
+	bench<16, 16>();
+	bench<64, 64>();
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
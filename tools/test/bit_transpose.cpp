@@ -0,0 +1,153 @@
+// BitMatrix and PackedBitMatrix transposed()/transpose() against a per-bit loop, and the time per transpose.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/bit_transpose [rounds]
+//
+// Shapes below, at and above the 64x64 block, square and not: every bit of the result has to be A(y, x),
+// both classes have to agree, transposing twice has to give the original and transpose() has to match transposed().
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+
+#include "PackedBitMatrix.h"
+
+// A packed transpose is constexpr all the way down
+constexpr bool packed_constexpr()
+{
+	PackedBitMatrix<3, 5> a;
+	a.set(size_t(0), size_t(4));
+	a.set(size_t(2), size_t(1));
+	const auto t = a.transposed();
+	return t.test(4, 0) && t.test(1, 2) && !t.test(0, 4) && t.transposed() == a;
+}
+static_assert(packed_constexpr());
+
+static std::mt19937_64 rng(44);
+static bool ok = true;
+
+template <size_t H, size_t W>
+static BitMatrix<H, W> random_matrix()
+{
+	BitMatrix<H, W> m;
+	for (size_t y = 0; y < H; ++y)
+		for (size_t x = 0; x < W; ++x)
+			m.set(y, x, rng() & 1);
+	return m;
+}
+
+template <size_t H, size_t W>
+static void check(size_t rounds)
+{
+	size_t bad = 0;
+	for (size_t i = 0; i < rounds; ++i)
+	{
+		const BitMatrix<H, W> a = random_matrix<H, W>();
+		const PackedBitMatrix<H, W> p(a);
+		const BitMatrix<W, H> ta = a.transposed();
+		const PackedBitMatrix<W, H> tp = p.transposed();
+
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				bad += (ta.test(x, y) != a.test(y, x)) + (tp.test(x, y) != a.test(y, x));
+
+		bad += !(PackedBitMatrix<W, H>(ta) == tp);
+		bad += !(tp.transposed() == p) + (ta.transposed() != a).any();
+
+		if constexpr (H == W)
+		{
+			BitMatrix<H, W> b = a;
+			PackedBitMatrix<H, W> q = p;
+			bad += (b.transpose() != ta).any() + !(q.transpose() == tp);
+		}
+	}
+	std::printf("  %3zux%-3zu %zu mismatches\n", H, W, bad);
+	ok &= bad == 0;
+}
+
+volatile size_t sink; // keeps the timed loops alive, reads the whole result
+
+template <size_t H, size_t W>
+static void bench()
+{
+	using clock = std::chrono::steady_clock;
+	const size_t n = 4000000 / (H * W) + 1;
+	BitMatrix<H, W> a = random_matrix<H, W>();
+	PackedBitMatrix<H, W> p(a);
+
+	const auto per_op = [&](clock::time_point t0)
+	{
+		return std::chrono::duration<double, std::nano>(clock::now() - t0).count() / n;
+	};
+
+	// each round changes one bit, so no round can be hoisted
+	auto t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		a.set(i % H, i % W, i & 1);
+		BitMatrix<W, H> t;
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				t.set(x, y, a.test(y, x));
+		sink = t.count();
+	}
+	const double bit_loop = per_op(t0);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		a.set(i % H, i % W, i & 1);
+		sink = a.transposed().count();
+	}
+	const double blocks = per_op(t0);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		p.set(i % H, i % W, i & 1);
+		PackedBitMatrix<W, H> t;
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				t.set(x, y, p.test(y, x));
+		sink = t.count();
+	}
+	const double packed_bit_loop = per_op(t0);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		p.set(i % H, i % W, i & 1);
+		sink = p.transposed().count();
+	}
+	const double packed_blocks = per_op(t0);
+
+	std::printf("  %3zux%-3zu BitMatrix %7.0f / %5.0f ns   Packed %7.0f / %5.0f ns\n", H, W, bit_loop, blocks, packed_bit_loop, packed_blocks);
+}
+
+int main(int argc, char **argv)
+{
+	const size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+
+	std::printf("%zu random matrices per shape\n", rounds);
+	check<1, 1>(rounds);
+	check<1, 7>(rounds);
+	check<7, 1>(rounds);
+	check<3, 5>(rounds);
+	check<8, 8>(rounds);
+	check<16, 16>(rounds);
+	check<16, 12>(rounds);
+	check<12, 40>(rounds);
+	check<64, 64>(rounds);
+	check<70, 9>(rounds);
+	check<65, 130>(rounds / 10 + 1);
+	check<2, 200>(rounds);
+
+	std::printf("per-bit loop / block swap\n");
+	bench<16, 16>();
+	bench<8, 128>();
+	bench<64, 64>();
+	bench<128, 128>();
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+// Matrix<uint8_t>::bitplanes() and from_bitplanes() against per-pixel loops, and the time for all 8 planes.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/bitplanes [rounds]
+//
+// Widths around the 8 pixel groups and the 64 pixel words the transpose works in (1 ... 200), N from 1 to 8 planes.
+// Plane b has to hold bit b of every pixel, and from_bitplanes() has to give back the low N bits and clear the others.
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+
+#include "BitMatrix.h"
+
+static std::mt19937 rng(43);
+static bool ok = true;
+
+template <size_t H, size_t W>
+static Matrix<uint8_t, H, W> random_matrix()
+{
+	Matrix<uint8_t, H, W> m;
+	for (uint8_t &v : m)
+		v = uint8_t(rng());
+	return m;
+}
+
+// Bit by bit, as BCM code would do it without bitplanes()
+template <size_t N, size_t H, size_t W>
+static std::array<BitMatrix<H, W>, N> naive_planes(const Matrix<uint8_t, H, W> &m)
+{
+	std::array<BitMatrix<H, W>, N> planes;
+	for (size_t b = 0; b < N; ++b)
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				planes[b].set(y, x, m(y, x) >> b & 1);
+	return planes;
+}
+
+template <size_t N, size_t H, size_t W>
+static void naive_from_planes(Matrix<uint8_t, H, W> &m, const std::array<BitMatrix<H, W>, N> &planes)
+{
+	for (size_t y = 0; y < H; ++y)
+		for (size_t x = 0; x < W; ++x)
+		{
+			uint8_t v = 0;
+			for (size_t b = 0; b < N; ++b)
+				v |= planes[b].test(y, x) << b;
+			m(y, x) = v;
+		}
+}
+
+template <size_t H, size_t W, size_t N>
+static void check(size_t rounds)
+{
+	size_t bad = 0;
+	for (size_t i = 0; i < rounds; ++i)
+	{
+		const Matrix<uint8_t, H, W> m = random_matrix<H, W>();
+		const auto planes = m.template bitplanes<N>();
+		const auto expected = naive_planes<N>(m);
+		for (size_t b = 0; b < N; ++b)
+			bad += (planes[b] != expected[b]).any();
+
+		Matrix<uint8_t, H, W> back = random_matrix<H, W>(); // every bit has to be overwritten
+		back.from_bitplanes(planes);
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				bad += back(y, x) != (m(y, x) & ((1u << N) - 1));
+	}
+	std::printf("  %zux%-3zu N %zu  %zu mismatches\n", H, W, N, bad);
+	ok &= bad == 0;
+}
+
+volatile uint8_t sink; // keeps the timed loops alive
+
+template <size_t H, size_t W>
+static void bench()
+{
+	using clock = std::chrono::steady_clock;
+	const size_t n = 2000000 / (H * W) + 1;
+	Matrix<uint8_t, H, W> m = random_matrix<H, W>();
+	std::array<BitMatrix<H, W>, 8> planes;
+
+	const auto per_op = [&](clock::time_point t0)
+	{
+		return std::chrono::duration<double, std::nano>(clock::now() - t0).count() / n;
+	};
+
+	// each round changes one pixel or plane bit, so no round can be hoisted
+	auto t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		++m(i % H, i % W);
+		planes = naive_planes<8>(m);
+		sink = planes[i % 8].test(1 % H, 1 % W);
+	}
+	const double to_naive = per_op(t0);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		++m(i % H, i % W);
+		planes = m.template bitplanes<8>();
+		sink = planes[i % 8].test(1 % H, 1 % W);
+	}
+	const double to_planes = per_op(t0);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		planes[i % 8].flip();
+		naive_from_planes(m, planes);
+		sink = m(1 % H, 1 % W);
+	}
+	const double back_naive = per_op(t0);
+
+	t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		planes[i % 8].flip();
+		m.from_bitplanes(planes);
+		sink = m(1 % H, 1 % W);
+	}
+	const double back = per_op(t0);
+
+	std::printf("  %3zux%-3zu to planes %7.0f / %6.0f ns   back %7.0f / %6.0f ns\n", H, W, to_naive, to_planes, back_naive, back);
+}
+
+int main(int argc, char **argv)
+{
+	const size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50;
+
+	std::printf("%zu random matrices per shape, against per-pixel loops\n", rounds);
+	check<3, 1, 8>(rounds);
+	check<4, 3, 5>(rounds);
+	check<2, 8, 8>(rounds);
+	check<5, 13, 3>(rounds);
+	check<16, 16, 8>(rounds);
+	check<16, 16, 1>(rounds);
+	check<2, 64, 7>(rounds);
+	check<3, 70, 8>(rounds);
+	check<2, 130, 4>(rounds);
+	check<1, 200, 2>(rounds);
+	check<2, 200, 6>(rounds);
+
+	std::printf("all 8 planes, per-pixel loop / bitplanes()\n");
+	bench<16, 16>();
+	bench<8, 128>();
+	bench<64, 64>();
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+// BME280 compensation variants against the Bosch double reference (components/BME280_SensorAPI).
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/bme280_compensation [sets]
+//
+// Calibration words are drawn around the datasheet example part, raw readings over the full 20-bit (T, P)
+// and 16-bit (H) ADC range. Reports the worst error of each variant in DegC, Pa and %RH over the readings
+// inside the operating range, and the time per compensate call. Fails if the float variant is off by more
+// than half the sensor resolution.
+// Host timings only rank the variants, on the ESP32 double and int64 are emulated and fall much further behind.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+extern "C"
+{
+#include "BME280_SensorAPI_defs.h"
+
+	void bme280_double_compensate(const bme280_uncomp_data *raw, bme280_calib_data *calib, double out[3]);
+	void bme280_float_compensate(const bme280_uncomp_data *raw, bme280_calib_data *calib, double out[3]);
+	void bme280_int64_compensate(const bme280_uncomp_data *raw, bme280_calib_data *calib, double out[3]);
+	void bme280_int32_compensate(const bme280_uncomp_data *raw, bme280_calib_data *calib, double out[3]);
+}
+
+using compensate_fn = void (*)(const bme280_uncomp_data *, bme280_calib_data *, double[3]);
+
+struct Variant
+{
+	const char *name;
+	compensate_fn fn;
+	double err[3];
+};
+
+// Operating range of the sensor, readings outside are clamped and the integer kernels may overflow on the way
+constexpr double LO[3] = {-40, 30000, 0};
+constexpr double HI[3] = {85, 110000, 100};
+
+struct Set
+{
+	bme280_calib_data calib;
+	bme280_uncomp_data raw;
+};
+
+static std::vector<Set> make_sets(size_t n)
+{
+	std::mt19937 rng(280);
+	const auto in = [&](int lo, int hi)
+	{
+		return std::uniform_int_distribution<int>(lo, hi)(rng);
+	};
+
+	std::vector<Set> sets(n);
+	for (Set &s : sets)
+	{
+		bme280_calib_data &c = s.calib;
+		c = {};
+		c.dig_t1 = in(25000, 30000);
+		c.dig_t2 = in(24000, 28000);
+		c.dig_t3 = in(-1000, 1000);
+		c.dig_p1 = in(34000, 40000);
+		c.dig_p2 = in(-11500, -10000);
+		c.dig_p3 = in(2000, 4000);
+		c.dig_p4 = in(0, 10000);
+		c.dig_p5 = in(-200, 300);
+		c.dig_p6 = in(-20, 20);
+		c.dig_p7 = in(0, 16000);
+		c.dig_p8 = in(-16000, 0);
+		c.dig_p9 = in(0, 8000);
+		c.dig_h1 = in(0, 100);
+		c.dig_h2 = in(300, 420);
+		c.dig_h3 = in(0, 10);
+		c.dig_h4 = in(250, 450);
+		c.dig_h5 = in(0, 100);
+		c.dig_h6 = in(0, 40);
+
+		s.raw.temperature = in(0, 0xFFFFF);
+		s.raw.pressure = in(0, 0xFFFFF);
+		s.raw.humidity = in(0, 0xFFFF);
+	}
+	return sets;
+}
+
+volatile double sink; // keeps the timed loops alive
+
+static double time_ns(compensate_fn fn, std::vector<Set> sets, uint64_t *ticks)
+{
+	double out[3], acc = 0;
+	const auto t0 = std::chrono::steady_clock::now();
+#if defined(__x86_64__) || defined(__i386__)
+	const uint64_t c0 = __rdtsc();
+#endif
+	for (Set &s : sets)
+	{
+		fn(&s.raw, &s.calib, out);
+		acc += out[0] + out[1] + out[2];
+	}
+#if defined(__x86_64__) || defined(__i386__)
+	*ticks = (__rdtsc() - c0) / sets.size();
+#else
+	*ticks = 0;
+#endif
+	const auto t1 = std::chrono::steady_clock::now();
+	sink = acc;
+	return std::chrono::duration<double, std::nano>(t1 - t0).count() / sets.size();
+}
+
+int main(int argc, char **argv)
+{
+	const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+	const std::vector<Set> sets = make_sets(n);
+
+	Variant variants[] = {
+		{"float", bme280_float_compensate, {}},
+		{"int64", bme280_int64_compensate, {}},
+		{"int32", bme280_int32_compensate, {}},
+	};
+
+	size_t counted[3] = {};
+	for (const Set &s : sets)
+	{
+		double ref[3], out[3];
+		bme280_calib_data calib = s.calib;
+		bme280_double_compensate(&s.raw, &calib, ref);
+
+		bool in_range[3];
+		for (size_t i = 0; i < 3; ++i)
+			in_range[i] = ref[i] > LO[i] && ref[i] < HI[i] && (i == 0 || in_range[0]);
+		for (size_t i = 0; i < 3; ++i)
+			counted[i] += in_range[i];
+
+		for (Variant &v : variants)
+		{
+			calib = s.calib;
+			v.fn(&s.raw, &calib, out);
+			for (size_t i = 0; i < 3; ++i)
+				if (in_range[i])
+					v.err[i] = std::max(v.err[i], std::fabs(out[i] - ref[i]));
+		}
+	}
+
+	std::printf("%zu sets (%zu T, %zu P, %zu H inside the operating range), max |error| against double\n", n, counted[0], counted[1], counted[2]);
+	for (const Variant &v : variants)
+		std::printf("  %-6s %10.6f DegC %10.4f Pa %10.6f %%RH\n", v.name, v.err[0], v.err[1], v.err[2]);
+
+	std::printf("time per compensate (T, P, H)\n");
+	const Variant timed[] = {{"double", bme280_double_compensate, {}}, variants[0], variants[1], variants[2]};
+	for (const Variant &v : timed)
+	{
+		uint64_t ticks = UINT64_MAX;
+		double ns = INFINITY;
+		for (int round = 0; round < 5; ++round) // best of
+		{
+			uint64_t t;
+			ns = std::min(ns, time_ns(v.fn, sets, &t));
+			ticks = std::min(ticks, t);
+		}
+		std::printf("  %-6s %6.1f ns %6llu TSC ticks\n", v.name, ns, (unsigned long long)ticks);
+	}
+
+	// resolution 0.01 DegC, 0.18 Pa (16x oversampling) and 0.008 %RH
+	constexpr double HALF[3] = {0.005, 0.09, 0.004};
+	const double *e = variants[0].err;
+	const bool ok = e[0] <= HALF[0] && e[1] <= HALF[1] && e[2] <= HALF[2];
+	std::printf("%s\n", ok ? "OK" : "FAIL: float error above half the resolution");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+// One compensation variant of the BME280 SensorAPI, built once per BME280_*_ENABLE by tools/CMakeLists.txt.
+// The public API is renamed with BME280_VARIANT so the four copies link into one program,
+// and the result is handed out in common units (DegC, Pa, %RH).
+
+#include <stdint.h>
+
+#define BME280_NAME_(v, f) bme280_##v##_##f
+#define BME280_NAME(v, f) BME280_NAME_(v, f)
+
+#define bme280_init BME280_NAME(BME280_VARIANT, init)
+#define bme280_get_regs BME280_NAME(BME280_VARIANT, get_regs)
+#define bme280_set_regs BME280_NAME(BME280_VARIANT, set_regs)
+#define bme280_set_sensor_settings BME280_NAME(BME280_VARIANT, set_sensor_settings)
+#define bme280_get_sensor_settings BME280_NAME(BME280_VARIANT, get_sensor_settings)
+#define bme280_set_sensor_mode BME280_NAME(BME280_VARIANT, set_sensor_mode)
+#define bme280_get_sensor_mode BME280_NAME(BME280_VARIANT, get_sensor_mode)
+#define bme280_soft_reset BME280_NAME(BME280_VARIANT, soft_reset)
+#define bme280_get_sensor_data BME280_NAME(BME280_VARIANT, get_sensor_data)
+#define bme280_compensate_data BME280_NAME(BME280_VARIANT, compensate_data)
+#define bme280_cal_meas_delay BME280_NAME(BME280_VARIANT, cal_meas_delay)
+
+#include "BME280_SensorAPI.c"
+
+// calib is not const, temperature compensation writes t_fine into it
+void BME280_NAME(BME280_VARIANT, compensate)(const struct bme280_uncomp_data *raw, struct bme280_calib_data *calib, double out[3])
+{
+	struct bme280_data d;
+	bme280_compensate_data(BME280_ALL, raw, &d, calib);
+
+#if defined(BME280_DOUBLE_ENABLE) || defined(BME280_FLOAT_ENABLE)
+	out[0] = d.temperature;
+	out[1] = d.pressure;
+	out[2] = d.humidity;
+#elif defined(BME280_32BIT_ENABLE)
+	out[0] = d.temperature * 0.01; // 0.01 DegC
+	out[1] = d.pressure;		   // Pa
+	out[2] = d.humidity / 1024.0;  // 1/1024 %RH
+#else
+	out[0] = d.temperature * 0.01;
+	out[1] = d.pressure * 0.01; // 0.01 Pa
+	out[2] = d.humidity / 1024.0;
+#endif
+}
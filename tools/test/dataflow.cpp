@@ -0,0 +1,283 @@
+// DataFlow memoization rules on hand-built graphs, and on random DAGs against a from-scratch recomputation.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/dataflow [passes]
+//
+// A node may only run when one of its inputs changed in the same pass, a result equal to the previous one must stop the
+// propagation there, and an intermediate shared by several consumers has to run once per sample, not once per consumer.
+// Each node call advances the host cycle counter by a fixed amount, so cost() and last_cost() are checked exactly.
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "DataFlow.h"
+
+using Flow = DataFlow<>;
+
+static const esp_cpu_cycle_count_t CYCLES_PER_CALL = 100;
+
+static bool ok = true;
+
+static void expect(bool cond, const char *what)
+{
+	if (!cond)
+		std::printf("  FAIL %s\n", what);
+	ok &= cond;
+}
+
+static int32_t calls[Flow::INVALID]; // per node, counted by the callables themselves
+
+static void charge()
+{
+	host::cycle_count += CYCLES_PER_CALL;
+}
+
+// t -> sign(t) -> label(sign), t -> twice(t); the first pass runs everything
+static void check_cut_off()
+{
+	Flow flow;
+	const Flow::NodeId t = flow.add_source(int32_t(5));
+	const Flow::NodeId sign = flow.add_node({t}, [](int32_t v)
+	{
+		charge();
+		return int32_t(v > 0) - int32_t(v < 0);
+	});
+	const Flow::NodeId label = flow.add_node({sign}, [](int32_t s)
+	{
+		charge();
+		return s * 1000;
+	});
+	const Flow::NodeId twice = flow.add_node({t}, [](int32_t v)
+	{
+		charge();
+		return 2.0f * v;
+	});
+
+	flow.evaluate();
+	expect(flow.last_evals() == 3 && flow.get<int32_t>(label) == 1000 && flow.get<float>(twice) == 10, "first pass runs every node");
+
+	flow.evaluate();
+	expect(flow.last_evals() == 0 && !flow.changed(sign) && !flow.changed(twice), "no input changed, nothing runs");
+
+	flow.set(t, int32_t(5));
+	flow.evaluate();
+	expect(flow.last_evals() == 0, "setting the same value is not a change");
+
+	flow.set(t, int32_t(7));
+	flow.evaluate();
+	expect(flow.last_evals() == 2 && flow.evals(sign) == 2 && flow.evals(label) == 1, "equal sign stops the propagation");
+	expect(!flow.changed(sign) && !flow.changed(label) && flow.changed(twice) && flow.get<float>(twice) == 14, "changed flags");
+
+	flow.set(t, int32_t(-3));
+	flow.evaluate();
+	expect(flow.last_evals() == 3 && flow.get<int32_t>(label) == -1000 && flow.changed(label), "new sign reaches the label");
+
+	expect(flow.cost(sign) == 3 * CYCLES_PER_CALL && flow.cost(label) == 2 * CYCLES_PER_CALL, "cost in cycles");
+	expect(flow.last_cost() == 3 * CYCLES_PER_CALL, "last_cost in cycles");
+}
+
+// Diamond over two sources: (a, b) -> mid -> {left, right} -> out, and c -> other
+static void check_shared()
+{
+	Flow flow;
+	const Flow::NodeId a = flow.add_source(1.0f), b = flow.add_source(2.0f), c = flow.add_source(int32_t(0));
+	const Flow::NodeId mid = flow.add_node({a, b}, [](float x, float y)
+	{
+		++calls[3];
+		return x + y;
+	});
+	const Flow::NodeId left = flow.add_node({mid}, [](float m)
+	{
+		++calls[4];
+		return m * 2;
+	});
+	const Flow::NodeId right = flow.add_node({mid}, [](float m)
+	{
+		++calls[5];
+		return int32_t(m);
+	});
+	const Flow::NodeId out = flow.add_node({left, right, mid}, [](float l, int32_t r, float m)
+	{
+		++calls[6];
+		return l + r + m;
+	});
+	const Flow::NodeId other = flow.add_node({c}, [](int32_t v)
+	{
+		++calls[7];
+		return v + 1;
+	});
+	expect(out == 6 && other == 7, "node ids");
+
+	flow.evaluate();
+	expect(flow.get<float>(out) == 6 + 3 + 3, "diamond value");
+
+	// both sources of the shared node change in the same sample
+	flow.set(a, 1.5f);
+	flow.set(b, 2.5f);
+	flow.evaluate();
+	expect(calls[3] == 2 && calls[4] == 2 && calls[5] == 2 && calls[6] == 2, "shared intermediate runs once per sample");
+	expect(flow.get<float>(out) == 8 + 4 + 4 && calls[7] == 1, "diamond value, unrelated branch untouched");
+
+	// mid changes but right does not: out still runs once, for left
+	flow.set(a, 1.75f);
+	flow.evaluate();
+	expect(calls[3] == 3 && calls[5] == 3 && !flow.changed(right) && calls[6] == 3, "one changed input is enough");
+
+	flow.set(c, int32_t(4));
+	flow.evaluate();
+	expect(calls[3] == 3 && calls[7] == 2 && flow.last_evals() == 1 && flow.get<int32_t>(other) == 5, "only the changed branch runs");
+}
+
+static void check_add()
+{
+	Flow flow;
+	const Flow::NodeId i = flow.add_source(int32_t(0)), f = flow.add_source(0.0f);
+	expect(flow.add_node({f}, [](int32_t v) { return v; }) == Flow::INVALID, "input type mismatch");
+	expect(flow.add_node({i, f}, [](int32_t v) { return v; }) == Flow::INVALID, "input count mismatch");
+	expect(flow.add_node({5}, [](int32_t v) { return v; }) == Flow::INVALID, "input does not exist yet");
+
+	while (flow.size() < 16)
+		flow.add_source(true);
+	expect(flow.add_source(true) == Flow::INVALID && flow.add_node({i}, [](int32_t v) { return v; }) == Flow::INVALID, "full");
+}
+
+// Random DAG of int32 nodes with 1 to 4 earlier inputs. Each node clamps a mix of its inputs, so some results repeat.
+struct Spec
+{
+	uint8_t inputs[4];
+	uint8_t n;
+	int32_t mul, lo, hi;
+};
+
+static int32_t apply(const Spec &s, const int32_t *v) // v in the order of s.inputs
+{
+	int32_t x = 0;
+	for (size_t k = 0; k < s.n; ++k)
+		x = x * 3 + v[k];
+	return std::clamp(x * s.mul / 4, s.lo, s.hi);
+}
+
+static std::vector<Spec> specs;
+
+template <size_t ID>
+static int32_t node_fn(int32_t a, int32_t b, int32_t c, int32_t d)
+{
+	++calls[ID];
+	const int32_t v[4] = {a, b, c, d};
+	return apply(specs[ID], v);
+}
+
+static void check_random(size_t passes)
+{
+	std::mt19937 rng(39);
+	const size_t SOURCES = 4;
+	size_t mismatches = 0, evaluated = 0, total = 0;
+
+	for (size_t graph = 0; graph < 50; ++graph)
+	{
+		// 4 sources, 12 nodes; unused inputs repeat the first one
+		specs.assign(16, Spec{});
+		for (size_t id = SOURCES; id < 16; ++id)
+		{
+			Spec &s = specs[id];
+			s.n = 1 + rng() % 4;
+			for (size_t k = 0; k < 4; ++k)
+				s.inputs[k] = k < s.n ? rng() % id : s.inputs[0];
+			s.mul = 1 + rng() % 7;
+			s.lo = -int32_t(rng() % 50);
+			s.hi = int32_t(rng() % 50);
+		}
+
+		Flow flow;
+		std::vector<int32_t> src(SOURCES);
+		for (size_t i = 0; i < SOURCES; ++i)
+			flow.add_source(src[i] = 0);
+
+		// the callables take all four inputs, the nodes get the spec's inputs padded with the first
+		const auto node = [&]<size_t ID>(std::integral_constant<size_t, ID>)
+		{
+			const Spec &s = specs[ID];
+			return flow.add_node({s.inputs[0], s.inputs[1], s.inputs[2], s.inputs[3]}, node_fn<ID>);
+		};
+		[&]<size_t... I>(std::index_sequence<I...>)
+		{
+			(node(std::integral_constant<size_t, SOURCES + I>()), ...);
+		}(std::make_index_sequence<16 - SOURCES>());
+		std::fill(std::begin(calls), std::end(calls), 0);
+
+		// the rules, applied to the reference values
+		std::vector<int32_t> value(16, 0), expected_calls(16, 0);
+		std::vector<bool> changed(16, false);
+		for (size_t pass = 0; pass < passes; ++pass)
+		{
+			for (size_t i = 0; i < SOURCES; ++i)
+				if (rng() % 3 == 0)
+				{
+					const int32_t v = int32_t(rng() % 5) - 2;
+					flow.set(i, v);
+					changed[i] = v != src[i];
+					src[i] = v;
+				}
+				else
+					changed[i] = false;
+			flow.evaluate();
+
+			for (size_t i = 0; i < SOURCES; ++i)
+				value[i] = src[i];
+			for (size_t id = SOURCES; id < 16; ++id)
+			{
+				const Spec &s = specs[id];
+				bool stale = pass == 0;
+				for (size_t k = 0; k < 4; ++k)
+					stale = stale || changed[s.inputs[k]];
+				changed[id] = false;
+				if (!stale)
+					continue;
+				++expected_calls[id];
+				const int32_t in[4] = {value[s.inputs[0]], value[s.inputs[1]], value[s.inputs[2]], value[s.inputs[3]]};
+				const int32_t v = apply(s, in);
+				changed[id] = pass == 0 || v != value[id]; // nodes start without a value
+				value[id] = v;
+			}
+
+			// memoized values are the ones a full recomputation gives
+			std::vector<int32_t> full(src);
+			for (size_t id = SOURCES; id < 16; ++id)
+			{
+				const Spec &s = specs[id];
+				const int32_t in[4] = {full[s.inputs[0]], full[s.inputs[1]], full[s.inputs[2]], full[s.inputs[3]]};
+				full.push_back(apply(s, in));
+			}
+
+			for (size_t id = SOURCES; id < 16; ++id)
+			{
+				mismatches += flow.get<int32_t>(id) != value[id] || value[id] != full[id];
+				mismatches += flow.changed(id) != changed[id];
+				mismatches += calls[id] != expected_calls[id] || flow.evals(id) != uint32_t(expected_calls[id]);
+			}
+		}
+		for (size_t id = SOURCES; id < 16; ++id)
+			evaluated += calls[id];
+		total += passes * (16 - SOURCES);
+	}
+
+	std::printf("  50 random graphs x %zu passes: %zu of %zu node runs (%.0f%%), %zu mismatches\n",
+				passes, evaluated, total, 100.0 * evaluated / total, mismatches);
+	expect(mismatches == 0, "random graphs against the reference");
+}
+
+int main(int argc, char **argv)
+{
+	const size_t passes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+
+	std::printf("memoization rules\n");
+	check_cut_off();
+	check_shared();
+	check_add();
+	check_random(passes);
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+// Filters.h step and frequency responses for float, Q15 and Q31, and the time per sample.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/filters
+//
+//   EMA           step up and down: samples to 63 %, final error in LSB, against the difference taken at
+//                 sample precision (x - (state >> FRAC)) the EMA used before
+//   Biquad        lowpass magnitude against the analytic response of the double design, DC step error
+//   MovingAverage float sum after 10^7 samples, integer rounding
+//   Median        isolated spikes removed, steps kept
+// Fails on a fixed point EMA or biquad that does not settle to the input, or a response off by more than 0.1 dB.
+
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <complex>
+#include <tuple>
+#include <vector>
+
+#include "Filters.h"
+
+template <typename T>
+constexpr double FULL_SCALE = std::is_same_v<T, float> ? 1.0 : std::is_same_v<T, int16_t> ? 32767.0 : 2147483647.0;
+
+template <typename T>
+constexpr const char *NAME = std::is_same_v<T, float> ? "float" : std::is_same_v<T, int16_t> ? "Q15" : "Q31";
+
+static bool ok = true;
+
+static void expect(bool cond, const char *what)
+{
+	if (!cond)
+	{
+		std::printf("  FAIL: %s\n", what);
+		ok = false;
+	}
+}
+
+// The fixed point update the EMA had before, for comparison
+template <typename T>
+class SamplePrecisionEMA
+{
+	using Tr = FilterTraits<T>;
+
+	typename Tr::coef_t alpha;
+	typename Tr::acc_t state;
+
+public:
+	SamplePrecisionEMA(float a, T initial) : alpha(FilterMath::to_coef<typename Tr::coef_t>(a, Tr::EMA_FRAC)), state(typename Tr::acc_t(initial) << Tr::EMA_FRAC)
+	{
+	}
+
+	T evaluate(T x)
+	{
+		state += alpha * (static_cast<typename Tr::acc_t>(x) - (state >> Tr::EMA_FRAC));
+		return FilterMath::saturate<T>(FilterMath::round_shift(state, Tr::EMA_FRAC));
+	}
+};
+
+// Samples until the step from a to b is 63 % done, and the error after 4000 samples
+template <typename F, typename T>
+static void step(F &f, T a, T b, int &n63, double &err)
+{
+	n63 = -1;
+	T y = a;
+	for (int i = 0; i < 4000; ++i)
+	{
+		y = f.evaluate(b);
+		if (n63 < 0 && std::fabs(double(y) - double(a)) >= 0.632 * std::fabs(double(b) - double(a)))
+			n63 = i + 1;
+	}
+	err = double(y) - double(b);
+}
+
+template <typename T>
+static void ema()
+{
+	constexpr float ALPHA = 0.05f;
+	const int ideal = int(std::ceil(std::log(1 - 0.632) / std::log(1 - ALPHA)));
+
+	// odd step sizes, so the final approach ends on a fraction
+	const T lo = T(-0.2517 * FULL_SCALE<T>), hi = T(0.4991 * FULL_SCALE<T>);
+
+	for (const auto &[from, to, dir] : {std::tuple{lo, hi, "up"}, std::tuple{hi, lo, "down"}})
+	{
+		int n63, n63_old = 0;
+		double err, err_old = 0;
+
+		EMA<T> e(ALPHA, from);
+		step(e, from, to, n63, err);
+
+		if constexpr (!std::is_floating_point_v<T>)
+		{
+			SamplePrecisionEMA<T> old(ALPHA, from);
+			step(old, from, to, n63_old, err_old);
+		}
+
+		std::printf("  EMA %-5s step %-4s 63 %% after %2d (ideal %d), final error %+.3g LSB", NAME<T>, dir, n63, ideal, err);
+		if constexpr (!std::is_floating_point_v<T>)
+			std::printf(" (before %+.3g LSB)", err_old);
+		std::printf("\n");
+
+		expect(std::abs(n63 - ideal) <= 1, "EMA time constant");
+		expect(std::is_floating_point_v<T> ? std::fabs(err) < 1e-6 : err == 0, "EMA settles to the input");
+	}
+}
+
+// |H(e^jw)| of the double design
+template <typename C>
+static double design_gain_db(const C &c, double fs, double f)
+{
+	const std::complex<double> z1 = std::polar(1.0, -2 * M_PI * f / fs), z2 = z1 * z1;
+	return 20 * std::log10(std::abs((c.b0 + c.b1 * z1 + c.b2 * z2) / (1.0 + c.a1 * z1 + c.a2 * z2)));
+}
+
+template <typename T>
+static void biquad()
+{
+	constexpr double FS = 1000, F0 = 50;
+	const auto c = Biquad<T>::lowpass(FS, F0);
+
+	std::printf("  Biquad %-5s lowpass fs %g f0 %g, measured (design) dB:", NAME<T>, FS, F0);
+	for (double f : {5.0, 25.0, 50.0, 100.0, 200.0})
+	{
+		// amplitude of the output at f by correlation over whole periods, after the transient
+		Biquad<T> b(c);
+		const double amp = 0.5 * FULL_SCALE<T>;
+		std::complex<double> acc = 0;
+		for (int i = 0; i < 20000; ++i)
+		{
+			const double w = 2 * M_PI * f * i / FS;
+			const double y = double(b.evaluate(T(amp * std::sin(w))));
+			if (i >= 10000)
+				acc += y * std::polar(1.0, -w);
+		}
+
+		const double db = 20 * std::log10(2 * std::abs(acc) / 10000 / amp), design = design_gain_db(c, FS, f);
+		std::printf(" %g Hz %.2f (%.2f)", f, db, design);
+		expect(std::fabs(db - design) < 0.1, "biquad magnitude response");
+	}
+
+	Biquad<T> b(Biquad<T>::lowpass(FS, 5));
+	const T x = T(0.2503 * FULL_SCALE<T>);
+	T y = 0;
+	for (int i = 0; i < 5000; ++i)
+		y = b.evaluate(x);
+	std::printf(", DC step error %+.3g LSB\n", double(y) - double(x));
+	expect(std::is_floating_point_v<T> ? std::fabs(double(y) - double(x)) < 1e-4 : y == x, "biquad settles to the input");
+}
+
+static void moving_average_and_median()
+{
+	MovingAverage<float, 8> maf;
+	const float small = 0.1f, large = 0.1f + 1e6f;
+	float last = 0;
+	for (int i = 0; i < 10000000; ++i)
+		last = maf.evaluate(i % 8 ? small : large);
+	const double exact = (double(large) + 7 * double(small)) / 8;
+	std::printf("  MovingAverage<float, 8> after 10^7 samples %.4f (exact %.4f)\n", last, exact);
+	expect(std::fabs(last - exact) < 1e-6 * exact, "float moving average does not drift"); // a few float ulps
+
+	MovingAverage<int16_t, 4> mai;
+	int16_t seen[4];
+	for (int16_t &v : seen)
+		v = mai.evaluate(101);
+	std::printf("  MovingAverage<Q15, 4> step to 101: %d %d %d %d\n", seen[0], seen[1], seen[2], seen[3]);
+	expect(seen[0] == 25 && seen[1] == 51 && seen[2] == 76 && seen[3] == 101, "integer moving average rounds to nearest");
+
+	Median<int16_t, 5> m(10);
+	const int16_t in[] = {10, 10, 500, 10, 10, -300, 400, 10, 10, 20, 20, 20, 20};
+	const int16_t want[] = {10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 20, 20, 20};
+	bool same = true;
+	std::printf("  Median<Q15, 5>:");
+	for (size_t i = 0; i < std::size(in); ++i)
+	{
+		const int16_t y = m.evaluate(in[i]);
+		std::printf(" %d", y);
+		same &= y == want[i];
+	}
+	std::printf("\n");
+	expect(same, "median removes spikes up to 2 samples and keeps the step");
+}
+
+volatile double sink; // keeps the timed loops alive
+
+template <typename F, typename T>
+static double ns_per_sample(F &&f)
+{
+	constexpr size_t N = 1 << 20;
+	std::vector<T> in(N), out(N);
+	for (size_t i = 0; i < N; ++i)
+		in[i] = T((i * 2654435761u >> 20) & 1023);
+
+	const auto t0 = std::chrono::steady_clock::now();
+	f.process(in.data(), out.data(), N);
+	const auto t1 = std::chrono::steady_clock::now();
+	sink = double(out[N - 1]);
+	return std::chrono::duration<double, std::nano>(t1 - t0).count() / N;
+}
+
+template <typename T>
+static void bench()
+{
+	std::printf("  %-5s EMA %.2f  Biquad %.2f  MovingAverage16 %.2f  Median5 %.2f\n", NAME<T>,
+				ns_per_sample<EMA<T>, T>(EMA<T>(0.1f)),
+				ns_per_sample<Biquad<T>, T>(Biquad<T>(Biquad<T>::lowpass(1000, 50))),
+				ns_per_sample<MovingAverage<T, 16>, T>(MovingAverage<T, 16>()),
+				ns_per_sample<Median<T, 5>, T>(Median<T, 5>()));
+}
+
+int main()
+{
+	std::printf("step responses, alpha 0.05\n");
+	ema<float>();
+	ema<int16_t>();
+	ema<int32_t>();
+
+	std::printf("frequency responses\n");
+	biquad<float>();
+	biquad<int16_t>();
+	biquad<int32_t>();
+
+	std::printf("boxcar and median\n");
+	moving_average_and_median();
+
+	std::printf("ns/sample\n");
+	bench<float>();
+	bench<int16_t>();
+	bench<int32_t>();
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
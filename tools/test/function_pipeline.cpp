@@ -0,0 +1,74 @@
+// pipe() against FunctionManager::executeChain on the same chain of SignalProcessing stages.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/function_pipeline [samples]
+//
+// LowPassFilter -> Hysteresis -> BoolLowpass -> PosEdge over uniform random samples. Both chains have to
+// produce the same edge on every sample, the test reports the time per sample for both.
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "FunctionChain.h"
+#include "SignalProcessing.h"
+
+volatile size_t sink; // keeps the timed loops alive
+
+int main(int argc, char **argv)
+{
+	const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 20;
+
+	std::mt19937 rng(37);
+	std::uniform_real_distribution<float> uniform(0, 1);
+	std::vector<float> in(n);
+	for (float &v : in)
+		v = uniform(rng);
+
+	auto p = pipe(LowPassFilter(0.1f), Hysteresis(0.4f, 0.6f), BoolLowpass(5), PosEdge());
+
+	LowPassFilter lp(0.1f);
+	Hysteresis h(0.4f, 0.6f);
+	BoolLowpass bl(5);
+	PosEdge pe;
+	FunctionManager fm;
+	fm.addFunction(std::ref(lp));
+	fm.addFunction([&](float x)
+				   { return h.evaluate(x); });
+	fm.addFunction([&](bool x)
+				   { return bl.evaluate(x); });
+	fm.addFunction([&](bool x)
+				   { return pe.evaluate(x); });
+
+	using clock = std::chrono::steady_clock;
+	std::vector<uint8_t> out(n);
+	size_t edges = 0, bad = 0;
+
+	const auto t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		out[i] = p(in[i]);
+		edges += out[i];
+	}
+	const auto t1 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+		bad += std::any_cast<bool>(fm.executeChain(in[i])) != out[i];
+	const auto t2 = clock::now();
+	sink = edges;
+
+	const auto per_sample = [&](clock::duration d)
+	{
+		return std::chrono::duration<double, std::nano>(d).count() / n;
+	};
+	std::printf("%zu samples, %zu edges, %zu mismatches\n", n, edges, bad);
+	std::printf("pipe %.1f ns/sample, FunctionManager %.1f ns/sample\n", per_sample(t1 - t0), per_sample(t2 - t1));
+
+	// a pipeline is a stage itself
+	auto nested = pipe(std::ref(p), boolToFloat);
+	const bool nested_ok = nested(0.3f) == 0.0f;
+
+	const bool ok = bad == 0 && edges > 0 && nested_ok;
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
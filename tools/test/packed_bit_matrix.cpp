@@ -0,0 +1,155 @@
+// PackedBitMatrix against BitMatrix: every op of the algebra, the reductions and the conversions, and the time per op.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/packed_bit_matrix [rounds]
+//
+// Random operands for packed widths (16, 32, with and without a partial last word) and padded ones (10, 70, 64, 256).
+// Each op has to give the same matrix as BitMatrix, with the padding bits still 0. The bench times Jpq + Kpq + Fpq + any,
+// the ops of a typical frame composition, in both layouts.
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+
+#include "PackedBitMatrix.h"
+
+static std::mt19937_64 rng(41);
+static bool ok = true;
+
+template <size_t H, size_t W>
+static BitMatrix<H, W> random_matrix(unsigned density)
+{
+	BitMatrix<H, W> m;
+	for (size_t y = 0; y < H; ++y)
+		for (size_t x = 0; x < W; ++x)
+			m.set(y, x, rng() % 100 < density);
+	return m;
+}
+
+template <size_t H, size_t W>
+static bool padding_clear(const PackedBitMatrix<H, W> &p)
+{
+	for (size_t i = 0; i < PackedBitMatrix<H, W>::WORDS; ++i)
+		if (p.data()[i] & ~PackedBitMatrix<H, W>::valid(i))
+			return false;
+	return true;
+}
+
+template <size_t H, size_t W>
+static size_t check(size_t rounds)
+{
+	using P = PackedBitMatrix<H, W>;
+	size_t bad = 0;
+
+	const auto same = [&](const BitMatrix<H, W> &r, const P &p)
+	{
+		bad += !(P(r) == p) || !padding_clear(p) || !(p.to_bitmatrix() == r).all();
+	};
+
+	for (size_t i = 0; i < rounds; ++i)
+	{
+		// sparse, even and dense operands, plus the all-zero and all-one ends
+		const unsigned density[] = {0, 10, 50, 90, 100};
+		const BitMatrix<H, W> a = random_matrix<H, W>(density[i % 5]), b = random_matrix<H, W>(density[i / 5 % 5]);
+		const P pa(a), pb(b);
+
+		// applies the same op to both layouts
+		const auto op = [&](auto f)
+		{
+			BitMatrix<H, W> r = a;
+			P p = pa;
+			f(r, b);
+			f(p, pb);
+			same(r, p);
+		};
+		op([](auto &m, const auto &) { m.Opq(); });
+		op([](auto &m, const auto &o) { m.Kpq(o); });
+		op([](auto &m, const auto &o) { m.Lpq(o); });
+		op([](auto &m, const auto &) { m.Ipq(); });
+		op([](auto &m, const auto &o) { m.Mpq(o); });
+		op([](auto &m, const auto &o) { m.Hpq(o); });
+		op([](auto &m, const auto &o) { m.Jpq(o); });
+		op([](auto &m, const auto &o) { m.Apq(o); });
+		op([](auto &m, const auto &o) { m.Xpq(o); });
+		op([](auto &m, const auto &o) { m.Epq(o); });
+		op([](auto &m, const auto &o) { m.Gpq(o); });
+		op([](auto &m, const auto &o) { m.Bpq(o); });
+		op([](auto &m, const auto &) { m.Fpq(); });
+		op([](auto &m, const auto &o) { m.Cpq(o); });
+		op([](auto &m, const auto &o) { m.Dpq(o); });
+		op([](auto &m, const auto &) { m.Vpq(); });
+		op([](auto &m, const auto &) { m.flip(); });
+		op([](auto &m, const auto &o) { m |= o; });
+		op([](auto &m, const auto &o) { m &= o; });
+		op([](auto &m, const auto &o) { m ^= o; });
+		op([](auto &m, const auto &o) { m -= o; });
+		op([](auto &m, const auto &o) { m /= o; });
+
+		same(a | b, pa | pb);
+		same(a & b, pa & pb);
+		same(a ^ b, pa ^ pb);
+		same(a - b, pa - pb);
+		same(a / b, pa / pb);
+		same(BitMatrix<H, W>(a).Fpq(), ~pa);
+
+		bad += a.any() != pa.any() || a.all() != pa.all() || a.none() != pa.none();
+		bad += (a == b).all() != (pa == pb);
+		for (size_t y = 0; y < H; ++y)
+			for (size_t x = 0; x < W; ++x)
+				bad += a(y, x) != pa(y, x);
+	}
+	return bad;
+}
+
+volatile bool sink; // keeps the timed loops alive
+
+template <size_t H, size_t W>
+static void run(size_t rounds)
+{
+	using P = PackedBitMatrix<H, W>;
+	const size_t bad = check<H, W>(rounds);
+
+	BitMatrix<H, W> a = random_matrix<H, W>(50), b = random_matrix<H, W>(50);
+	P pa(a), pb(b);
+
+	using clock = std::chrono::steady_clock;
+	const size_t n = 20000000 / (H * W / 64 + 1);
+	const auto t0 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		a.Jpq(b).Kpq(b).Fpq();
+		sink = a.any();
+		asm volatile("" : : "g"(&a) : "memory");
+	}
+	const auto t1 = clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		pa.Jpq(pb).Kpq(pb).Fpq();
+		sink = pa.any();
+		asm volatile("" : : "g"(&pa) : "memory");
+	}
+	const auto t2 = clock::now();
+
+	const auto per_op = [&](clock::duration d)
+	{
+		return std::chrono::duration<double, std::nano>(d).count() / n;
+	};
+	std::printf("  %3zux%-3zu %3zu words  %zu mismatches  BitMatrix %6.1f ns, packed %6.1f ns\n", H, W, P::WORDS, bad, per_op(t1 - t0), per_op(t2 - t1));
+	ok &= bad == 0;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+
+	std::printf("%zu random operand pairs per shape, Jpq + Kpq + Fpq + any per round\n", rounds);
+	run<16, 16>(rounds); // VFD::matrix, 4 words
+	run<3, 32>(rounds);	 // 2 rows per word, last word half used
+	run<7, 10>(rounds);	 // padded rows
+	run<5, 70>(rounds);	 // 2 words per row
+	run<64, 64>(rounds);
+	run<256, 256>(rounds / 10 + 1);
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+// RollingWindow and SensorHistory statistics against a brute-force window, and their static RAM.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/sensor_history [pushes]
+//
+// Every push is followed by min, max, mean, slope and at() checked against a std::deque of the same samples, through
+// filling, many wrap-arounds of the ring and the deques, runs of equal values (ties in the monotonic deques), the
+// int16_t extremes and clear(). Empty and single-sample windows must give NaN / 0 instead of reading the deques.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <deque>
+#include <random>
+
+#include "SensorHistory.h"
+
+static std::mt19937 rng(27);
+static size_t bad = 0;
+
+static void expect(bool ok, const char *what, size_t step)
+{
+	if (!ok && bad < 10)
+		std::printf("  FAIL %s at push %zu\n", what, step);
+	bad += !ok;
+}
+
+// Least squares over the window in double, i = 0 for the oldest sample
+static double brute_slope(const std::deque<int16_t> &w)
+{
+	const double n = w.size();
+	double si = 0, sy = 0, sii = 0, siy = 0;
+	for (size_t i = 0; i < w.size(); ++i)
+	{
+		si += i, sy += w[i], sii += double(i) * i, siy += double(i) * w[i];
+	}
+	return (n * siy - si * sy) / (n * sii - si * si);
+}
+
+// Random walks with plateaus, jumps to the extremes and the odd clear()
+template <size_t N>
+static void check(size_t pushes)
+{
+	RollingWindow<N> win;
+	std::deque<int16_t> ref;
+	int32_t y = 0;
+
+	for (size_t step = 0; step < pushes; ++step)
+	{
+		const uint32_t r = rng() % 1000;
+		if (rng() % (4 * N + 1000) == 0) // rare enough that the largest window wraps many times in between
+		{
+			win.clear();
+			ref.clear();
+		}
+		if (r < 10)
+			y = r & 1 ? INT16_MAX : INT16_MIN;
+		else if (r < 400)
+			; // plateau, equal samples
+		else
+			y = std::clamp<int32_t>(y + int32_t(rng() % 201) - 100, INT16_MIN, INT16_MAX);
+
+		win.push(int16_t(y));
+		ref.push_back(int16_t(y));
+		if (ref.size() > N)
+			ref.pop_front();
+
+		expect(win.size() == ref.size(), "size", step);
+		expect(win.min() == *std::min_element(ref.begin(), ref.end()), "min", step);
+		expect(win.max() == *std::max_element(ref.begin(), ref.end()), "max", step);
+
+		double sum = 0;
+		for (int16_t v : ref)
+			sum += v;
+		expect(std::fabs(win.mean() - sum / ref.size()) <= 1e-6 * (std::fabs(sum / ref.size()) + 1), "mean", step);
+
+		const double slope = ref.size() < 2 ? 0 : brute_slope(ref);
+		expect(std::fabs(win.slope() - slope) <= 1e-5 * (std::fabs(slope) + 1), "slope", step);
+
+		const size_t age = rng() % ref.size();
+		expect(win.at(age) == ref[ref.size() - 1 - age], "at", step);
+	}
+	std::printf("  N %4zu  %zu pushes  %zu mismatches so far\n", N, pushes, bad);
+}
+
+static void check_empty()
+{
+	RollingWindow<4> win;
+	expect(std::isnan(win.mean()) && win.slope() == 0 && win.empty(), "empty window", 0);
+	win.push(7);
+	expect(win.mean() == 7 && win.slope() == 0 && win.min() == 7 && win.max() == 7, "one sample", 1);
+	win.clear();
+	expect(std::isnan(win.mean()) && win.slope() == 0 && win.size() == 0, "cleared window", 2);
+
+	SensorHistory<8> history;
+	using C = SensorHistory<8>::Channel;
+	for (C c : {C::TEMPERATURE, C::PRESSURE, C::HUMIDITY})
+		expect(std::isnan(history.min(c)) && std::isnan(history.max(c)) && std::isnan(history.mean(c)) && history.slope(c) == 0, "empty history", 0);
+}
+
+// Quantisation to 0.01 DegC, 2 Pa around 70 kPa and 0.01 %RH over the sensor range
+static void check_history()
+{
+	SensorHistory<16> history;
+	using C = SensorHistory<16>::Channel;
+	std::deque<BME280::Meas> ref;
+	for (size_t step = 0; step < 200; ++step)
+	{
+		BME280::Meas m;
+		m.temperature = -40 + std::uniform_real_distribution<float>(0, 125)(rng);
+		m.pressure = 30000 + std::uniform_real_distribution<float>(0, 80000)(rng);
+		m.humidity = std::uniform_real_distribution<float>(0, 100)(rng);
+		history.push(m);
+		ref.push_back(m);
+		if (ref.size() > 16)
+			ref.pop_front();
+
+		for (size_t age = 0; age < ref.size(); ++age)
+		{
+			const BME280::Meas &e = ref[ref.size() - 1 - age], got = history.at(age);
+			expect(std::fabs(got.temperature - e.temperature) <= 0.005f + 1e-4f, "temperature step", step);
+			expect(std::fabs(got.pressure - e.pressure) <= 1 + 1e-2f, "pressure step", step);
+			expect(std::fabs(got.humidity - e.humidity) <= 0.005f + 1e-4f, "humidity step", step);
+		}
+
+		float lo = INFINITY, hi = -INFINITY;
+		for (size_t age = 0; age < ref.size(); ++age)
+		{
+			lo = std::min(lo, history.at(age).temperature);
+			hi = std::max(hi, history.at(age).temperature);
+		}
+		expect(history.min(C::TEMPERATURE) == lo && history.max(C::TEMPERATURE) == hi, "history min/max", step);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const size_t pushes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+
+	std::printf("incremental statistics against a brute-force window\n");
+	check_empty();
+	check<2>(pushes);
+	check<3>(pushes);
+	check<7>(pushes);
+	check<64>(pushes);
+	check<24 * 60>(pushes);
+	check_history();
+
+	// Frontend keeps one SensorHistory<> as a static, all of it in DRAM
+	std::printf("SensorHistory<%zu> %zu bytes (RollingWindow %zu bytes per channel)\n",
+				SensorHistory<>::capacity(), sizeof(SensorHistory<>), sizeof(SensorHistory<>::window_t));
+
+	std::printf("%s\n", bad == 0 ? "OK" : "FAIL");
+	return bad == 0 ? 0 : 1;
+}
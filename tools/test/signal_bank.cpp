@@ -0,0 +1,121 @@
+// BoolLowpassBank + EdgeBank against one BoolLowpass, PosEdge and NegEdge object per channel.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/signal_bank [samples]
+//
+// 16 channels of a noisy touch mask: the true state of a random channel set flips every ~64 samples,
+// each bit is disturbed with probability 1/8. Every sample the debounced state and the pe/ne masks of
+// the bank have to equal those of the per-channel objects, for several required run lengths.
+// Reports the time per 16-channel sample for both.
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "SignalProcessing.h"
+
+constexpr size_t CHANNELS = 16;
+
+struct Channels
+{
+	std::vector<BoolLowpass> lowpass;
+	std::vector<PosEdge> pos;
+	std::vector<NegEdge> neg;
+
+	Channels(size_t req)
+	{
+		for (size_t i = 0; i < CHANNELS; ++i)
+		{
+			lowpass.emplace_back(req);
+			pos.emplace_back();
+			neg.emplace_back();
+		}
+	}
+
+	// debounced state, pe and ne as masks
+	void evaluate(uint16_t in, uint16_t &state, uint16_t &pe, uint16_t &ne)
+	{
+		state = pe = ne = 0;
+		for (size_t i = 0; i < CHANNELS; ++i)
+		{
+			const bool s = lowpass[i].evaluate(in >> i & 1);
+			state |= s << i;
+			pe |= pos[i].evaluate(s) << i;
+			ne |= neg[i].evaluate(s) << i;
+		}
+	}
+};
+
+volatile uint32_t sink; // keeps the timed loops alive
+
+int main(int argc, char **argv)
+{
+	const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 20;
+
+	std::mt19937 rng(36);
+	std::vector<uint16_t> in(n);
+	uint16_t truth = 0;
+	for (uint16_t &v : in)
+	{
+		if ((rng() & 63) == 0)
+			truth ^= rng();
+		v = truth ^ (rng() & rng() & rng());
+	}
+
+	std::printf("%zu samples of %zu channels, mismatches against the per-channel objects\n", n, CHANNELS);
+
+	bool ok = true;
+	for (size_t req : {1, 2, 3, 5, 7})
+	{
+		Channels ch(req);
+		BoolLowpassBank<uint16_t, 3> bank(req);
+		EdgeBank<uint16_t> edges;
+
+		size_t bad = 0;
+		for (uint16_t v : in)
+		{
+			uint16_t state, pe, ne;
+			ch.evaluate(v, state, pe, ne);
+
+			const uint16_t bs = bank.evaluate(v);
+			edges.evaluate(bs);
+			bad += bs != state || edges.pe != pe || edges.ne != ne;
+		}
+
+		std::printf("  req %zu  %zu\n", req, bad);
+		ok &= bad == 0;
+	}
+
+	using clock = std::chrono::steady_clock;
+	uint32_t acc = 0;
+
+	Channels ch(5);
+	const auto t0 = clock::now();
+	for (uint16_t v : in)
+	{
+		uint16_t state, pe, ne;
+		ch.evaluate(v, state, pe, ne);
+		acc += pe | ne << 16;
+	}
+	const auto t1 = clock::now();
+
+	BoolLowpassBank<uint16_t, 3> bank(5);
+	EdgeBank<uint16_t> edges;
+	for (uint16_t v : in)
+	{
+		edges.evaluate(bank.evaluate(v));
+		acc += edges.pe | edges.ne << 16;
+	}
+	const auto t2 = clock::now();
+	sink = acc;
+
+	const auto per_sample = [&](clock::duration d)
+	{
+		return std::chrono::duration<double, std::nano>(d).count() / n;
+	};
+	std::printf("req 5: per-channel objects %.1f ns/sample, bank %.1f ns/sample\n", per_sample(t1 - t0), per_sample(t2 - t1));
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
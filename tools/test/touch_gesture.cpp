@@ -0,0 +1,95 @@
+// TouchGesture on scripted edge sequences, with the edges handed to update() on time and late.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/touch_gesture
+//
+// The Frontend touch loop may see an edge after a gesture deadline has passed, e.g. when the touch task was
+// busy. update() gets the edge time and the current time, and has to decide as if it had run at every event:
+// timeouts due before the edge, the edge, then the timeouts due since.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "TouchGesture.h"
+
+constexpr touch_pad_t PAD = TOUCH_PAD_NUM3;
+constexpr uint16_t BIT_PAD = 1 << PAD;
+
+struct Step
+{
+	char edge;		// 'p' press, 'r' release, '-' none
+	int64_t edge_ms; // when it happened
+	int64_t now_ms;	 // when update() runs
+};
+
+struct Case
+{
+	const char *name;
+	std::vector<Step> steps;
+	const char *expected; // event letters in order
+};
+
+static char letter(TouchGesture::Type t)
+{
+	switch (t)
+	{
+	case TouchGesture::Type::TAP:
+		return 'T';
+	case TouchGesture::Type::DOUBLE_TAP:
+		return 'D';
+	case TouchGesture::Type::LONG_PRESS:
+		return 'L';
+	case TouchGesture::Type::REPEAT:
+		return 'R';
+	case TouchGesture::Type::RELEASE:
+		return 'U';
+	}
+	return '?';
+}
+
+int main()
+{
+	// double tap within 250 ms, long press after 600 ms, repeat every 150 ms
+	const Case cases[] = {
+		{"tap", {{'p', 0, 0}, {'r', 100, 100}, {'-', 400, 400}}, "T"},
+		{"double tap", {{'p', 0, 0}, {'r', 100, 100}, {'p', 200, 200}, {'r', 300, 300}}, "D"},
+		{"long press, repeats, release", {{'p', 0, 0}, {'-', 700, 700}, {'-', 1000, 1000}, {'r', 1100, 1100}}, "LRRRU"},
+		{"tap then long press", {{'p', 0, 0}, {'r', 100, 100}, {'p', 200, 200}, {'-', 900, 900}, {'r', 1000, 1000}}, "TLRU"},
+		// late updates: the edge is older than a deadline that has passed by now
+		{"second press seen after the double tap deadline", {{'p', 0, 0}, {'r', 100, 100}, {'p', 300, 500}, {'r', 400, 500}}, "D"},
+		{"release seen after the long press deadline", {{'p', 0, 0}, {'r', 500, 800}, {'-', 900, 900}}, "T"},
+		{"press after a real timeout, seen late", {{'p', 0, 0}, {'r', 100, 100}, {'p', 500, 600}, {'r', 550, 600}, {'-', 900, 900}}, "TT"},
+		{"release after repeats, seen late", {{'p', 0, 0}, {'r', 800, 1200}}, "LRU"},
+	};
+
+	bool ok = true;
+	for (const Case &c : cases)
+	{
+		TouchGesture g;
+		std::string got;
+		bool ordered = true;
+		int64_t last = -1;
+
+		for (const Step &s : c.steps)
+		{
+			const uint16_t pe = s.edge == 'p' ? BIT_PAD : 0;
+			const uint16_t ne = s.edge == 'r' ? BIT_PAD : 0;
+			g.update(pe, ne, s.edge_ms * 1000, s.now_ms * 1000);
+
+			TouchGesture::Event ev;
+			while (g.poll(ev))
+			{
+				got += letter(ev.type);
+				ordered &= ev.pad == PAD && ev.timestamp >= last && ev.timestamp + ev.latency == s.now_ms * 1000;
+				last = ev.timestamp;
+			}
+		}
+
+		const bool pass = got == c.expected && ordered && g.next_deadline() == TouchGesture::NEVER;
+		std::printf("  %-48s %-6s %s\n", c.name, got.c_str(), pass ? "ok" : "FAIL");
+		ok &= pass;
+	}
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
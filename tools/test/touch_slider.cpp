@@ -0,0 +1,130 @@
+// TouchSlider position and velocity against synthetic finger profiles.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/touch_slider
+//
+// A finger at x (in pads) gives every pad the analog value profile(|x - pad|). Profiles:
+//   narrow   triangle of half width 1 pad, two pads see the finger
+//   wide     triangle of half width 1.5 pads, three pads see it
+//   noisy    narrow, plus uniform noise of +-0.05 on every pad
+// The finger sweeps the slider and the wheel at constant speed, the test reports the worst position error
+// in pads, the velocity error once settled and the time per update(), and fails on an error above the bounds.
+// A wide finger reads 1/4 pad inwards at the ends of a slider, which also shows up in the velocity there.
+
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "TouchSlider.h"
+
+constexpr size_t PADS = 4;
+constexpr int64_t PERIOD_US = 20000; // 50 Hz
+constexpr float SPEED = 2.0f;		 // pads per second
+
+struct Profile
+{
+	const char *name;
+	float half_width;
+	float noise;
+	float max_error;	 // pads
+	float max_vel_error; // relative
+};
+
+struct Result
+{
+	float pos_error = 0;
+	float vel_error = 0;
+	bool flags_ok = true;
+};
+
+static Result sweep(SmartTouch &st, TouchSlider &s, const std::vector<touch_pad_t> &pins, bool wheel, const Profile &p)
+{
+	std::mt19937 rng(33);
+	std::uniform_real_distribution<float> noise(-p.noise, p.noise);
+
+	// slider: 0 .. n-1, wheel: once around
+	const float span = wheel ? PADS : PADS - 1;
+	const float to_pos = 1.0f / span;
+
+	Result r;
+	int64_t now = 0;
+	size_t step = 0;
+	for (float x = 0; x <= span; x += SPEED * PERIOD_US * 1e-6f, now += PERIOD_US, ++step)
+	{
+		for (size_t i = 0; i < PADS; ++i)
+		{
+			float d = std::fabs(x - i);
+			if (wheel)
+				d = std::min(d, PADS - d);
+			st.touch_analog[pins[i]] = std::clamp(1 - d / p.half_width + noise(rng), 0.0f, 1.0f);
+		}
+		s.update(st, now);
+
+		r.flags_ok &= s.active && s.pressed == (step == 0) && !s.released;
+
+		float err = s.position - x * to_pos;
+		if (wheel)
+			err -= std::round(err);
+		r.pos_error = std::max(r.pos_error, std::fabs(err) * span);
+
+		if (step >= 20) // velocity EMA settled
+			r.vel_error = std::max(r.vel_error, std::fabs(s.velocity - SPEED * to_pos) / (SPEED * to_pos));
+	}
+
+	// lift the finger
+	for (touch_pad_t pin : pins)
+		st.touch_analog[pin] = 0;
+	s.update(st, now);
+	r.flags_ok &= !s.active && s.released && s.velocity == 0;
+
+	return r;
+}
+
+volatile float sink; // keeps the timed loop alive
+
+int main()
+{
+	const std::vector<touch_pad_t> pins = {TOUCH_PAD_NUM2, TOUCH_PAD_NUM3, TOUCH_PAD_NUM4, TOUCH_PAD_NUM5};
+	SmartTouch st(pins); // only touch_analog is used, no init()
+
+	const Profile profiles[] = {
+		{"narrow", 1.0f, 0, 1e-4f, 0.01f},
+		{"wide", 1.5f, 0, 0.3f, 0.6f}, // the end pads of a slider pull the centroid inwards by up to 1/4 pad
+		{"noisy", 1.0f, 0.05f, 0.1f, 0.6f},
+	};
+
+	std::printf("%zu pads, finger at %.1f pads/s sampled at %lld Hz: max position error [pads], max velocity error once settled\n",
+				PADS, SPEED, 1000000LL / PERIOD_US);
+
+	bool ok = true;
+	for (bool wheel : {false, true})
+		for (const Profile &p : profiles)
+		{
+			TouchSlider s(pins, wheel);
+			const Result r = sweep(st, s, pins, wheel, p);
+			std::printf("  %-6s %-6s position %.5f  velocity %5.1f %%  flags %s\n", wheel ? "wheel" : "slider", p.name,
+						r.pos_error, 100 * r.vel_error, r.flags_ok ? "ok" : "WRONG");
+
+			ok &= r.pos_error <= p.max_error && r.vel_error <= p.max_vel_error && r.flags_ok;
+		}
+
+	// cost of one update, finger between pads 1 and 2
+	TouchSlider s(pins);
+	for (size_t i = 0; i < PADS; ++i)
+		st.touch_analog[pins[i]] = std::max(0.0f, 1 - std::fabs(1.3f - i));
+	constexpr int ROUNDS = 1000000;
+	const auto t0 = std::chrono::steady_clock::now();
+	float acc = 0;
+	for (int i = 0; i < ROUNDS; ++i)
+	{
+		s.update(st, i * PERIOD_US);
+		acc += s.position;
+	}
+	const auto t1 = std::chrono::steady_clock::now();
+	sink = acc;
+	std::printf("update %.1f ns\n", std::chrono::duration<double, std::nano>(t1 - t0).count() / ROUNDS);
+
+	std::printf("%s\n", ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
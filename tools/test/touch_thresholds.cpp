@@ -0,0 +1,250 @@
+// Replays synthetic pad traces through SmartTouch (k * sigma thresholds) and through the fixed percentage
+// thresholds it replaced, and reports false and missed touches for both.
+//
+//   cmake -S tools -B build-host && cmake --build build-host && ./build-host/touch_thresholds [hours]
+//
+// One pad polled at 50 Hz, baseline ~800 counts, a touch pulls the reading down (ESP32 touch sensor).
+// Every scenario has 60 touches per hour, of 0.2..1.5 s, 40..70 % deep unless noted:
+//   quiet    white noise sigma 2
+//   drift    humidity pulls the baseline down 20 % over the hour, sigma 3
+//   bursts   sigma 3, every ~2 min an EMI burst of sigma 30 (4 %) for 2..10 s
+//   slow     presses and releases ramp over 1.5 s
+//   light    touches only 25..45 % deep, sigma 4
+//   spikes   sigma 2, about 2 single-sample glitches per minute that read 30 % of the baseline
+// A touch is missed if touch_on never rises while it lasts, a false touch is a rising touch_on with no touch
+// within 200 ms. Wakeups count readings crossing below the touch threshold without a touch, in FSM mode
+// each of them is an interrupt. The run fails if SmartTouch misses or falsely reports more than MAX_PER_HOUR
+// touches in any scenario; the fixed thresholds are only printed for comparison.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "SmartTouch.h"
+
+constexpr touch_pad_t PAD = TOUCH_PAD_NUM8;
+constexpr double RATE = 50;		 // Hz
+constexpr int64_t GUARD = 10;	 // samples, 200 ms around a touch
+constexpr double MAX_PER_HOUR = 1; // missed and false touches
+
+// The thresholds SmartTouch used before: fixed percentages of an EMA baseline
+class FixedTouch
+{
+	static constexpr float ALPHA = 0.01f;
+
+	float mean = 0;
+	float min_thresh, max_thresh, neg_thresh;
+
+public:
+	bool touch_on = false;
+
+	FixedTouch(float mt = 3, float Mt = 10, float nt = 0.5) : min_thresh(mt / 100), max_thresh(Mt / 100), neg_thresh(nt / 100)
+	{
+	}
+
+	void init(float sample)
+	{
+		if (mean == 0)
+			mean = sample;
+		mean += ALPHA * (sample - mean);
+	}
+
+	float threshold() const
+	{
+		return mean * (1 - min_thresh);
+	}
+
+	void test(float sample)
+	{
+		const float mt = mean * (1 - min_thresh);
+		const float Mt = mean * (0 + max_thresh);
+		const float nt = mean * (1 + neg_thresh);
+
+		const float meas = std::clamp(sample, Mt, mt);
+		touch_on = 1 - (meas - Mt) / (mt - Mt) >= 0.5f;
+
+		if (sample > mt && sample < nt)
+			mean += ALPHA * (sample - mean);
+	}
+};
+
+struct Trace
+{
+	std::vector<uint16_t> value;
+	std::vector<uint8_t> touched; // ground truth per sample
+	std::vector<std::pair<int64_t, int64_t>> touches;
+};
+
+struct Scenario
+{
+	const char *name;
+	float drift;	  // relative baseline change over the trace
+	float sigma;	  // counts
+	float burst;	  // sigma during EMI bursts, 0 for none
+	float ramp_s;	  // press and release ramp
+	float depth_min;  // relative
+	float depth_max;
+	float spikes;	  // per minute
+};
+
+static Trace make_trace(const Scenario &sc, double hours, uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	std::normal_distribution<float> noise(0, 1);
+	const auto uniform = [&](double lo, double hi)
+	{
+		return std::uniform_real_distribution<double>(lo, hi)(rng);
+	};
+
+	const int64_t n = int64_t(hours * 3600 * RATE);
+	Trace tr;
+	tr.value.resize(n);
+	tr.touched.resize(n);
+
+	// touch envelope 0..1 per sample
+	std::vector<float> depth(n, 0);
+	for (int64_t t = int64_t(uniform(5, 60) * RATE); t < n;)
+	{
+		const int64_t ramp = int64_t(sc.ramp_s * RATE);
+		const int64_t hold = int64_t(uniform(0.2, 1.5) * RATE);
+		const float d = uniform(sc.depth_min, sc.depth_max);
+		const int64_t end = std::min(n, t + 2 * ramp + hold);
+
+		for (int64_t i = t; i < end; ++i)
+		{
+			const int64_t k = i - t;
+			const float env = k < ramp ? float(k + 1) / (ramp + 1) : k < ramp + hold ? 1 : float(end - i) / (ramp + 1);
+			depth[i] = d * env;
+			tr.touched[i] = 1;
+		}
+		tr.touches.push_back({t, end});
+		t = end + int64_t(uniform(20, 100) * RATE);
+	}
+
+	int64_t burst_end = -1;
+	int64_t next_burst = int64_t(uniform(30, 120) * RATE);
+	for (int64_t i = 0; i < n; ++i)
+	{
+		if (sc.burst > 0 && i == next_burst)
+		{
+			burst_end = i + int64_t(uniform(2, 10) * RATE);
+			next_burst = burst_end + int64_t(uniform(60, 180) * RATE);
+		}
+
+		const float base = 800 * (1 - sc.drift * float(i) / n);
+		const float sigma = i < burst_end ? sc.burst : sc.sigma;
+		float v = base * (1 - depth[i]) + sigma * noise(rng);
+		if (sc.spikes > 0 && !tr.touched[i] && uniform(0, 60 * RATE) < sc.spikes)
+			v = 0.3f * base;
+		tr.value[i] = uint16_t(std::clamp(std::lround(v), 1L, 65535L));
+	}
+
+	return tr;
+}
+
+struct Score
+{
+	size_t missed = 0;
+	size_t false_touches = 0;
+	size_t wakeups = 0;
+};
+
+// Replays the trace through detect(sample index) -> {touch_on, below threshold}
+template <typename Detect>
+static Score score(const Trace &tr, Detect &&detect)
+{
+	const int64_t n = tr.value.size();
+
+	// within GUARD of a touch
+	std::vector<uint8_t> near(n, 0);
+	for (auto [s, e] : tr.touches)
+		for (int64_t i = std::max<int64_t>(0, s - GUARD); i < std::min(n, e + GUARD); ++i)
+			near[i] = 1;
+
+	Score sc;
+	std::vector<uint8_t> on(n);
+	bool last_on = false, last_below = false;
+	for (int64_t i = 0; i < n; ++i)
+	{
+		const auto [touch, below] = detect(i);
+		on[i] = touch;
+		if (touch && !last_on && !near[i])
+			++sc.false_touches;
+		if (below && !last_below && !near[i])
+			++sc.wakeups;
+		last_on = touch;
+		last_below = below;
+	}
+
+	for (auto [s, e] : tr.touches)
+	{
+		bool seen = false;
+		for (int64_t i = s; i < e && !seen; ++i)
+			seen = on[i];
+		sc.missed += !seen;
+	}
+	return sc;
+}
+
+int main(int argc, char **argv)
+{
+	const double hours = argc > 1 ? std::atof(argv[1]) : 1;
+
+	const Scenario scenarios[] = {
+		{"quiet", 0, 2, 0, 0, 0.4f, 0.7f, 0},
+		{"drift", 0.2f, 3, 0, 0, 0.4f, 0.7f, 0},
+		{"bursts", 0, 3, 30, 0, 0.4f, 0.7f, 0},
+		{"slow", 0, 2, 0, 1.5f, 0.4f, 0.7f, 0},
+		{"light", 0, 4, 0, 0, 0.25f, 0.45f, 0},
+		{"spikes", 0, 2, 0, 0, 0.4f, 0.7f, 2},
+	};
+
+	SmartTouch::Init();
+
+	std::printf("%.1f h per scenario at %.0f Hz, per hour: touches, missed, false touches, wakeups (fixed %% -> k*sigma)\n", hours, RATE);
+
+	bool ok = true;
+	uint32_t seed = 32;
+	for (const Scenario &sc : scenarios)
+	{
+		const Trace tr = make_trace(sc, hours, seed++);
+		int64_t pos = 0;
+		host::touch_source = [&](touch_pad_t)
+		{
+			return tr.value[std::min<int64_t>(pos, tr.value.size() - 1)];
+		};
+
+		// both learn their baseline from the first 100 samples, which are never touched
+		FixedTouch fixed;
+		for (pos = 0; pos < 100; ++pos)
+			fixed.init(tr.value[pos]);
+		const Score old_score = score(tr, [&](int64_t i)
+									  {
+										  const bool below = tr.value[i] < fixed.threshold();
+										  fixed.test(tr.value[i]);
+										  return std::pair<bool, bool>(fixed.touch_on, below); });
+
+		SmartTouch st({PAD});
+		pos = 0;
+		st.init(); // reads the first 100 samples
+		const Score new_score = score(tr, [&](int64_t i)
+									  {
+										  pos = i;
+										  const bool below = tr.value[i] < st.get_threshold(PAD);
+										  st.test_pins();
+										  return std::pair<bool, bool>(st.touch_on & BIT(PAD), below); });
+
+		const double per_h = 1 / hours;
+		std::printf("  %-7s %5.0f  missed %4.0f -> %-4.0f  false %4.0f -> %-4.0f  wakeups %6.0f -> %-6.0f\n", sc.name, tr.touches.size() * per_h,
+					old_score.missed * per_h, new_score.missed * per_h,
+					old_score.false_touches * per_h, new_score.false_touches * per_h,
+					old_score.wakeups * per_h, new_score.wakeups * per_h);
+
+		ok &= new_score.missed * per_h <= MAX_PER_HOUR && new_score.false_touches * per_h <= MAX_PER_HOUR;
+	}
+
+	std::printf("%s\n", ok ? "OK" : "FAIL: more missed or false touches than allowed");
+	return ok ? 0 : 1;
+}